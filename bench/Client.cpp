@@ -0,0 +1,268 @@
+// Client.cpp
+#include "Client.hpp"
+#include <sys/socket.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+
+Client::Client(const struct sockaddr_in& server)
+    : _server(server), _fd(-1), _state(CLIENT_IDLE), _failure(FAIL_NONE), _request(NULL), _headRequest(false), _sent(0), _reused(false), _reconnects(0),
+      _headDone(false), _status(0), _received(0), _bodyReceived(0), _contentLength(-1),
+      _chunked(false), _serverClose(false), _tailLength(0) {}
+
+Client::~Client() {
+    closeSocket();
+}
+
+void Client::closeSocket() {
+    if (_fd != -1) {
+        close(_fd);
+        _fd = -1;
+    }
+}
+
+void Client::fail(Failure failure) {
+    _failure = failure;
+    _state = CLIENT_FAILED;
+    closeSocket();
+}
+
+void Client::start(const std::string* request, bool head) {
+    _request = request;
+    _headRequest = head;
+    _sent = 0;
+    _head.clear();
+    _headDone = false;
+    _status = 0;
+    _received = 0;
+    _bodyReceived = 0;
+    _contentLength = -1;
+    _chunked = false;
+    _serverClose = false;
+    _tailLength = 0;
+    _failure = FAIL_NONE;
+    _reused = (_fd != -1);
+    if (_reused) {
+        _state = CLIENT_SENDING;
+        onWritable(); // Keep-alive : la socket est presque toujours prete
+        return;
+    }
+    connectAndSend();
+}
+
+void Client::connectAndSend() {
+    _fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (_fd == -1) {
+        fail(FAIL_CONNECT);
+        return;
+    }
+    if (connect(_fd, reinterpret_cast<const struct sockaddr*>(&_server), sizeof(_server)) == -1) {
+        if (errno != EINPROGRESS) {
+            fail(FAIL_CONNECT);
+            return;
+        }
+        _state = CLIENT_CONNECTING;
+        return;
+    }
+    _state = CLIENT_SENDING;
+    onWritable();
+}
+
+// Un serveur peut fermer une connexion keep-alive entre deux requetes (delai, ou fermeture
+// apres une erreur) : la requete, pas encore traitee, part sur une nouvelle connexion (RFC 9112, 9.3.1)
+void Client::ioError() {
+    if (_reused && _received == 0) {
+        closeSocket();
+        _reused = false;
+        _sent = 0;
+        ++_reconnects;
+        connectAndSend();
+        return;
+    }
+    fail(FAIL_IO);
+}
+
+void Client::onWritable() {
+    if (_state == CLIENT_CONNECTING) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &length) == -1 || error != 0) {
+            fail(FAIL_CONNECT);
+            return;
+        }
+        _state = CLIENT_SENDING;
+    }
+    while (_state == CLIENT_SENDING && _sent < _request->size()) {
+        ssize_t written = send(_fd, _request->data() + _sent, _request->size() - _sent, MSG_NOSIGNAL);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                ioError();
+            }
+            return;
+        }
+        _sent += static_cast<size_t>(written);
+    }
+    if (_state == CLIENT_SENDING) {
+        _state = CLIENT_READING;
+    }
+}
+
+// Ligne de statut et headers utiles a la delimitation du corps
+bool Client::parseHead() {
+    if (_head.compare(0, 5, "HTTP/") != 0 || _head.size() < 12) {
+        return false;
+    }
+    _status = std::atoi(_head.c_str() + 9);
+    size_t lineStart = _head.find("\r\n");
+    while (lineStart != std::string::npos && lineStart + 2 < _head.size()) {
+        lineStart += 2;
+        size_t lineEnd = _head.find("\r\n", lineStart);
+        if (lineEnd == std::string::npos || lineEnd == lineStart) {
+            break;
+        }
+        size_t colon = _head.find(':', lineStart);
+        if (colon != std::string::npos && colon < lineEnd) {
+            std::string name = _head.substr(lineStart, colon - lineStart);
+            for (size_t i = 0; i < name.size(); ++i) {
+                name[i] = static_cast<char>(tolower(static_cast<unsigned char>(name[i])));
+            }
+            size_t valueStart = _head.find_first_not_of(" \t", colon + 1);
+            std::string value = (valueStart < lineEnd) ? _head.substr(valueStart, lineEnd - valueStart) : "";
+            if (name == "content-length") {
+                _contentLength = std::atol(value.c_str());
+            } else if (name == "transfer-encoding" && value.find("chunked") != std::string::npos) {
+                _chunked = true;
+            } else if (name == "connection" && (value == "close" || value == "Close")) {
+                _serverClose = true;
+            }
+        }
+        lineStart = lineEnd;
+    }
+    if (_headRequest || _status == 204 || _status == 304) {
+        _contentLength = 0; // Jamais de corps
+    }
+    if (_contentLength < 0 && !_chunked) {
+        _serverClose = true; // Corps delimite par la fermeture
+    }
+    return _status >= 100 && _status <= 599;
+}
+
+// Le chunk final "0\r\n\r\n" termine un corps chunked (sans trailers : le serveur n'en envoie pas)
+void Client::checkBodyEnd() {
+    if (_chunked) {
+        if (_tailLength >= 5 && std::memcmp(_tail + _tailLength - 5, "0\r\n\r\n", 5) == 0) {
+            _state = CLIENT_DONE;
+        }
+    } else if (_contentLength >= 0 && _bodyReceived >= static_cast<size_t>(_contentLength)) {
+        _state = CLIENT_DONE;
+    }
+}
+
+void Client::onReadable() {
+    char buffer[65536];
+    while (_state == CLIENT_READING) {
+        ssize_t count = recv(_fd, buffer, sizeof(buffer), 0);
+        if (count == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                ioError();
+            }
+            return;
+        }
+        if (count == 0) {
+            // Fin attendue seulement pour un corps sans longueur
+            if (_headDone && _contentLength < 0 && !_chunked) {
+                _state = CLIENT_DONE;
+                closeSocket();
+            } else {
+                ioError();
+            }
+            return;
+        }
+        _received += static_cast<size_t>(count);
+        const char* body = buffer;
+        size_t bodyLength = static_cast<size_t>(count);
+        if (!_headDone) {
+            size_t before = _head.size();
+            _head.append(buffer, bodyLength);
+            size_t end = _head.find("\r\n\r\n", before >= 3 ? before - 3 : 0);
+            if (end == std::string::npos) {
+                if (_head.size() > 65536) {
+                    fail(FAIL_PROTOCOL);
+                }
+                continue;
+            }
+            _headDone = true;
+            if (!parseHead()) {
+                fail(FAIL_PROTOCOL);
+                return;
+            }
+            size_t consumed = end + 4 - before;
+            body = buffer + consumed;
+            bodyLength -= consumed;
+        }
+        _bodyReceived += bodyLength;
+        if (_chunked) {
+            // Garde les 8 derniers octets du corps
+            for (size_t i = (bodyLength > sizeof(_tail)) ? bodyLength - sizeof(_tail) : 0; i < bodyLength; ++i) {
+                if (_tailLength == sizeof(_tail)) {
+                    std::memmove(_tail, _tail + 1, sizeof(_tail) - 1);
+                    --_tailLength;
+                }
+                _tail[_tailLength++] = body[i];
+            }
+        }
+        checkBodyEnd();
+    }
+}
+
+void Client::abort() {
+    fail(FAIL_TIMEOUT);
+}
+
+void Client::reset(bool keepAlive) {
+    if (!keepAlive || _serverClose || _state != CLIENT_DONE) {
+        closeSocket();
+    }
+    _state = CLIENT_IDLE;
+}
+
+int Client::fd() const {
+    return _fd;
+}
+
+short Client::events() const {
+    if (_state == CLIENT_CONNECTING || _state == CLIENT_SENDING) {
+        return POLLOUT;
+    }
+    return (_state == CLIENT_READING) ? POLLIN : 0;
+}
+
+Client::State Client::state() const {
+    return _state;
+}
+
+Client::Failure Client::failure() const {
+    return _failure;
+}
+
+int Client::status() const {
+    return _status;
+}
+
+size_t Client::received() const {
+    return _received;
+}
+
+unsigned long Client::reconnects() const {
+    return _reconnects;
+}
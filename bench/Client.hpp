@@ -0,0 +1,77 @@
+// Client.hpp
+#ifndef CLIENT_HPP
+#define CLIENT_HPP
+
+#include <netinet/in.h>
+#include <string>
+#include <cstddef>
+
+/*
+ * Connexion HTTP/1.1 non bloquante des outils de bench (LoadGen, Replay) :
+ * une requete a la fois, reponse lue jusqu'a sa fin (Content-Length,
+ * chunked, ou fermeture par le serveur). La boucle poll() appelle
+ * onWritable() et onReadable() selon events(). Le corps n'est pas garde,
+ * seulement compte.
+ */
+class Client {
+public:
+    enum State { CLIENT_IDLE, CLIENT_CONNECTING, CLIENT_SENDING, CLIENT_READING, CLIENT_DONE, CLIENT_FAILED };
+    enum Failure { FAIL_NONE, FAIL_CONNECT, FAIL_IO, FAIL_PROTOCOL, FAIL_TIMEOUT };
+
+    explicit Client(const struct sockaddr_in& server);
+    ~Client();
+
+    // `request` doit survivre a l'envoi. La connexion est reprise si elle est encore ouverte,
+    // sinon une nouvelle est ouverte (connect non bloquant). `head` : reponse sans corps (requete HEAD).
+    void start(const std::string* request, bool head = false);
+    void onWritable();
+    void onReadable();
+    // Requete abandonnee (delai depasse) : la connexion est fermee
+    void abort();
+    // Fin de reponse lue : ferme la connexion si `keepAlive` est faux ou si le serveur l'a refusee
+    void reset(bool keepAlive);
+
+    int fd() const;
+    short events() const;
+    State state() const;
+    Failure failure() const;
+    int status() const;
+    size_t received() const; // Octets de la reponse, headers compris
+    // Requetes renvoyees sur une nouvelle connexion : la connexion reprise avait ete fermee par le serveur
+    unsigned long reconnects() const;
+
+private:
+    Client(const Client&);
+    Client& operator=(const Client&);
+
+    void fail(Failure failure);
+    // Erreur d'envoi ou de lecture : nouvelle tentative si la connexion etait reprise et rien n'a ete recu
+    void ioError();
+    void connectAndSend();
+    void closeSocket();
+    bool parseHead(); // false si la reponse est invalide
+    void checkBodyEnd();
+
+    struct sockaddr_in _server;
+    int _fd;
+    State _state;
+    Failure _failure;
+    const std::string* _request;
+    bool _headRequest;
+    size_t _sent;
+    bool _reused;
+    unsigned long _reconnects;
+
+    std::string _head;      // Debut de la reponse, jusqu'a la fin des headers
+    bool _headDone;
+    int _status;
+    size_t _received;
+    size_t _bodyReceived;
+    long _contentLength;    // -1 : inconnu
+    bool _chunked;
+    bool _serverClose;      // Connection: close, ou ni longueur ni chunked
+    char _tail[8];          // Derniers octets du corps chunked, pour reperer le chunk final
+    size_t _tailLength;
+};
+
+#endif
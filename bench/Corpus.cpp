@@ -0,0 +1,301 @@
+// Corpus.cpp
+#include "Corpus.hpp"
+#include <fstream>
+#include <cstdlib>
+#include <cctype>
+
+namespace {
+
+// Lecteur JSON minimal : ce dont le corpus a besoin, le reste est valide puis saute
+class JsonReader {
+public:
+    JsonReader(const std::string& text) : _text(text), _pos(0) {}
+
+    bool object(CorpusRequest& request, bool& hasMethod) {
+        if (!consume('{')) {
+            return false;
+        }
+        if (consume('}')) {
+            return atEnd();
+        }
+        do {
+            std::string key;
+            if (!string(key) || !consume(':')) {
+                return false;
+            }
+            bool ok;
+            if (key == "method") {
+                ok = string(request.method);
+                hasMethod = ok && !request.method.empty();
+            } else if (key == "path" || key == "target" || key == "url") {
+                ok = string(request.path);
+            } else if (key == "body") {
+                ok = string(request.body);
+            } else if (key == "headers") {
+                ok = headers(request.headers);
+            } else if (key == "t" || key == "time") {
+                ok = number(request.time);
+            } else if (key == "status") {
+                double value = 0;
+                ok = number(value);
+                request.status = static_cast<int>(value);
+            } else if (key == "size") {
+                double value = 0;
+                ok = number(value);
+                request.size = static_cast<long>(value);
+            } else {
+                ok = skipValue();
+            }
+            if (!ok) {
+                return false;
+            }
+        } while (consume(','));
+        return consume('}') && atEnd();
+    }
+
+private:
+    void spaces() {
+        while (_pos < _text.size() && isspace(static_cast<unsigned char>(_text[_pos]))) {
+            ++_pos;
+        }
+    }
+
+    bool consume(char c) {
+        spaces();
+        if (_pos < _text.size() && _text[_pos] == c) {
+            ++_pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool atEnd() {
+        spaces();
+        return _pos == _text.size();
+    }
+
+    static void appendUtf8(std::string& out, unsigned long code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool string(std::string& out) {
+        if (!consume('"')) {
+            return false;
+        }
+        out.clear();
+        while (_pos < _text.size()) {
+            char c = _text[_pos++];
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (_pos >= _text.size()) {
+                return false;
+            }
+            char escape = _text[_pos++];
+            switch (escape) {
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': {
+                    if (_pos + 4 > _text.size()) {
+                        return false;
+                    }
+                    std::string hex = _text.substr(_pos, 4);
+                    char* end = NULL;
+                    unsigned long code = std::strtoul(hex.c_str(), &end, 16);
+                    if (end != hex.c_str() + 4) {
+                        return false;
+                    }
+                    appendUtf8(out, code); // Paires de substitution non recomposees
+                    _pos += 4;
+                    break;
+                }
+                default: out += escape; // '"', '\\', '/'
+            }
+        }
+        return false;
+    }
+
+    bool number(double& out) {
+        spaces();
+        const char* start = _text.c_str() + _pos;
+        char* end = NULL;
+        out = std::strtod(start, &end);
+        if (end == start) {
+            return false;
+        }
+        _pos += end - start;
+        return true;
+    }
+
+    bool headers(std::vector<std::pair<std::string, std::string> >& out) {
+        if (!consume('{')) {
+            return false;
+        }
+        if (consume('}')) {
+            return true;
+        }
+        do {
+            std::pair<std::string, std::string> header;
+            if (!string(header.first) || !consume(':') || !string(header.second)) {
+                return false;
+            }
+            out.push_back(header);
+        } while (consume(','));
+        return consume('}');
+    }
+
+    bool skipValue() {
+        spaces();
+        if (_pos >= _text.size()) {
+            return false;
+        }
+        char c = _text[_pos];
+        if (c == '"') {
+            std::string ignored;
+            return string(ignored);
+        }
+        if (c == '{' || c == '[') {
+            char close = (c == '{') ? '}' : ']';
+            ++_pos;
+            if (consume(close)) {
+                return true;
+            }
+            do {
+                if (c == '{') {
+                    std::string key;
+                    if (!string(key) || !consume(':')) {
+                        return false;
+                    }
+                }
+                if (!skipValue()) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume(close);
+        }
+        static const char* literals[] = { "true", "false", "null" };
+        for (size_t i = 0; i < 3; ++i) {
+            std::string literal = literals[i];
+            if (_text.compare(_pos, literal.size(), literal) == 0) {
+                _pos += literal.size();
+                return true;
+            }
+        }
+        double ignored;
+        return number(ignored);
+    }
+
+    const std::string& _text;
+    size_t _pos;
+};
+
+bool sameName(const std::string& a, const std::string& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (tolower(static_cast<unsigned char>(a[i])) != tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+CorpusRequest::CorpusRequest() : time(-1), status(0), size(-1) {}
+
+bool CorpusRequest::hasHeader(const std::string& name) const {
+    for (size_t i = 0; i < headers.size(); ++i) {
+        if (sameName(headers[i].first, name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string CorpusRequest::header(const std::string& name) const {
+    for (size_t i = 0; i < headers.size(); ++i) {
+        if (sameName(headers[i].first, name)) {
+            return headers[i].second;
+        }
+    }
+    return "";
+}
+
+std::string CorpusRequest::raw(const std::string& defaultHost, const char* connection) const {
+    std::string out = method + " " + (path.empty() ? "/" : path) + " HTTP/1.1\r\n";
+    if (!hasHeader("Host")) {
+        out += "Host: " + defaultHost + "\r\n";
+    }
+    for (size_t i = 0; i < headers.size(); ++i) {
+        if (connection != NULL && sameName(headers[i].first, "Connection")) {
+            continue;
+        }
+        out += headers[i].first + ": " + headers[i].second + "\r\n";
+    }
+    if (connection != NULL) {
+        out += std::string("Connection: ") + connection + "\r\n";
+    }
+    if (!body.empty() && !hasHeader("Content-Length") && !hasHeader("Transfer-Encoding")) {
+        char length[32];
+        size_t value = body.size();
+        size_t count = 0;
+        do {
+            length[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value > 0);
+        out += "Content-Length: ";
+        while (count > 0) {
+            out += length[--count];
+        }
+        out += "\r\n";
+    }
+    out += "\r\n";
+    out += body;
+    return out;
+}
+
+bool loadCorpus(const std::string& path, std::vector<CorpusRequest>& requests, CorpusStats& stats) {
+    stats.loaded = 0;
+    stats.skipped = 0;
+    stats.invalid = 0;
+    std::ifstream file(path.c_str());
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        CorpusRequest request;
+        bool hasMethod = false;
+        JsonReader reader(line);
+        if (!reader.object(request, hasMethod)) {
+            ++stats.invalid;
+        } else if (!hasMethod) {
+            ++stats.skipped;
+        } else {
+            requests.push_back(request);
+            ++stats.loaded;
+        }
+    }
+    return true;
+}
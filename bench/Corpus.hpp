@@ -0,0 +1,46 @@
+// Corpus.hpp
+#ifndef CORPUS_HPP
+#define CORPUS_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+/*
+ * Requetes enregistrees, une par ligne JSON (JSONL) :
+ *   {"t": 0.125, "method": "GET", "path": "/index.html?x=1", "headers": {"Host": "localhost"},
+ *    "body": "", "status": 200, "size": 3599}
+ * Seuls "method" et "path" sont obligatoires ; "t" (secondes depuis le debut
+ * de l'enregistrement), "status" et "size" (octets de la reponse, headers compris, comme l'access log) servent au
+ * rejeu. Les autres cles sont ignorees, les lignes sans "method" aussi : un
+ * fichier JSONL d'un autre format ne donne simplement aucune requete.
+ */
+struct CorpusRequest {
+    double time;   // -1 si absent
+    std::string method;
+    std::string path;
+    std::vector<std::pair<std::string, std::string> > headers;
+    std::string body;
+    int status;    // 0 si absent
+    long size;     // -1 si absent
+
+    CorpusRequest();
+
+    // Requete HTTP/1.1 serialisee. Host ajoute s'il manque ; `connection` remplace le header
+    // Connection enregistre (NULL : garde tel quel) ; Content-Length ajoute pour un corps sans longueur.
+    std::string raw(const std::string& defaultHost, const char* connection) const;
+    bool hasHeader(const std::string& name) const;
+    std::string header(const std::string& name) const;
+};
+
+struct CorpusStats {
+    size_t loaded;
+    size_t skipped; // JSON valide sans "method"
+    size_t invalid; // JSON illisible
+};
+
+// false si le fichier ne s'ouvre pas
+bool loadCorpus(const std::string& path, std::vector<CorpusRequest>& requests, CorpusStats& stats);
+
+#endif
@@ -0,0 +1,407 @@
+// LoadGen.cpp
+// Generateur de charge HTTP : connexions en boucle fermee (chaque connexion enchaine ses requetes),
+// melange de requetes ponderees, latences dans des LatencyHistogram, resultat en JSON.
+// make bench && ./loadgen --port=8080 --concurrency=64 --duration=10 --mix=static=70,cgi=10,upload=10,404=10
+// Le JSON (stdout, ou --json=fichier) se compare d'un commit a l'autre ; --label=$(git rev-parse --short HEAD)
+#include "Client.hpp"
+#include "LatencyHistogram.hpp"
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <signal.h>
+#include <ctime>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+enum Kind { KIND_STATIC, KIND_CGI, KIND_UPLOAD, KIND_NOT_FOUND, KIND_COUNT };
+
+const char* g_kindNames[KIND_COUNT] = { "static", "cgi", "upload", "404" };
+
+struct Options {
+    std::string host;
+    int port;
+    int concurrency;
+    unsigned long requests;  // 0 : limite par la duree
+    double duration;         // Secondes
+    bool keepAlive;
+    int timeoutMs;           // Par requete
+    int weights[KIND_COUNT];
+    std::string paths[KIND_COUNT];
+    size_t uploadSize;
+    std::string json;        // Fichier de sortie, "" : stdout
+    std::string label;
+
+    Options() : host("127.0.0.1"), port(8080), concurrency(16), requests(0), duration(10), keepAlive(true),
+                timeoutMs(10000), uploadSize(64 * 1024) {
+        weights[KIND_STATIC] = 100;
+        weights[KIND_CGI] = 0;
+        weights[KIND_UPLOAD] = 0;
+        weights[KIND_NOT_FOUND] = 0;
+        paths[KIND_STATIC] = "/index.html";
+        paths[KIND_CGI] = "/cgi-bin/hello.cgi";
+        paths[KIND_UPLOAD] = "/uploads";
+        paths[KIND_NOT_FOUND] = "/loadgen-not-found";
+    }
+};
+
+struct KindStats {
+    unsigned long requests;
+    unsigned long failures[5]; // Par Client::Failure
+    unsigned long statusClasses[6];
+    unsigned long bytes;
+    LatencyHistogram latency;
+
+    KindStats() : requests(0), bytes(0) {
+        std::memset(failures, 0, sizeof(failures));
+        std::memset(statusClasses, 0, sizeof(statusClasses));
+    }
+};
+
+struct Slot {
+    Client* client;
+    Kind kind;
+    unsigned long startedNs;
+};
+
+unsigned long nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<unsigned long>(ts.tv_sec) * 1000000000UL + static_cast<unsigned long>(ts.tv_nsec);
+}
+
+void usage() {
+    std::cerr << "usage: loadgen [--host=127.0.0.1] [--port=8080] [--concurrency=16] [--duration=10 | --requests=N]\n"
+                 "               [--close] [--timeout=10000] [--mix=static=70,cgi=10,upload=10,404=10]\n"
+                 "               [--static=/index.html] [--cgi=/cgi-bin/hello.cgi] [--upload=/uploads] [--404=/x]\n"
+                 "               [--upload-size=65536] [--json=out.json] [--label=text]\n";
+}
+
+int kindFor(const std::string& name) {
+    for (int k = 0; k < KIND_COUNT; ++k) {
+        if (name == g_kindNames[k]) {
+            return k;
+        }
+    }
+    return -1;
+}
+
+// "static=70,cgi=10" : poids absents remis a 0
+bool parseMix(const std::string& value, Options& options) {
+    for (int k = 0; k < KIND_COUNT; ++k) {
+        options.weights[k] = 0;
+    }
+    std::istringstream stream(value);
+    std::string item;
+    int total = 0;
+    while (std::getline(stream, item, ',')) {
+        size_t equal = item.find('=');
+        int kind = kindFor(item.substr(0, equal));
+        if (equal == std::string::npos || kind == -1) {
+            return false;
+        }
+        options.weights[kind] = std::atoi(item.c_str() + equal + 1);
+        if (options.weights[kind] < 0) {
+            return false;
+        }
+        total += options.weights[kind];
+    }
+    return total > 0;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t equal = arg.find('=');
+        std::string name = arg.substr(0, equal);
+        std::string value = (equal == std::string::npos) ? "" : arg.substr(equal + 1);
+        int kind = kindFor(name.size() > 2 ? name.substr(2) : "");
+        if (name == "--host") {
+            options.host = value;
+        } else if (name == "--port") {
+            options.port = std::atoi(value.c_str());
+        } else if (name == "--concurrency") {
+            options.concurrency = std::atoi(value.c_str());
+        } else if (name == "--requests") {
+            options.requests = std::strtoul(value.c_str(), NULL, 10);
+        } else if (name == "--duration") {
+            options.duration = std::atof(value.c_str());
+        } else if (name == "--close") {
+            options.keepAlive = false;
+        } else if (name == "--timeout") {
+            options.timeoutMs = std::atoi(value.c_str());
+        } else if (name == "--mix") {
+            if (!parseMix(value, options)) {
+                return false;
+            }
+        } else if (kind != -1) {
+            options.paths[kind] = value;
+        } else if (name == "--upload-size") {
+            options.uploadSize = std::strtoul(value.c_str(), NULL, 10);
+        } else if (name == "--json") {
+            options.json = value;
+        } else if (name == "--label") {
+            options.label = value;
+        } else {
+            return false;
+        }
+    }
+    return options.port > 0 && options.concurrency > 0 && options.timeoutMs > 0
+        && (options.requests > 0 || options.duration > 0);
+}
+
+// Requetes construites une fois, envoyees telles quelles
+std::string buildRequest(Kind kind, const Options& options) {
+    std::string connection = options.keepAlive ? "keep-alive" : "close";
+    std::string head = "Host: " + options.host + "\r\nUser-Agent: webserv-loadgen\r\nConnection: " + connection + "\r\n";
+    if (kind != KIND_UPLOAD) {
+        return "GET " + options.paths[kind] + " HTTP/1.1\r\n" + head + "\r\n";
+    }
+    std::string boundary = "----loadgen7d3f9a";
+    std::string body = "--" + boundary + "\r\nContent-Disposition: form-data; name=\"file\"; filename=\"loadgen.bin\"\r\n"
+                       "Content-Type: application/octet-stream\r\n\r\n";
+    unsigned int seed = 42;
+    for (size_t i = 0; i < options.uploadSize; ++i) {
+        seed = seed * 1103515245 + 12345;
+        body += static_cast<char>('a' + (seed >> 16) % 26); // Pas de boundary possible dans le contenu
+    }
+    body += "\r\n--" + boundary + "--\r\n";
+    std::ostringstream request;
+    request << "POST " << options.paths[kind] << " HTTP/1.1\r\n" << head
+            << "Content-Type: multipart/form-data; boundary=" << boundary << "\r\n"
+            << "Content-Length: " << body.size() << "\r\n\r\n" << body;
+    return request.str();
+}
+
+// Tirage pondere reproductible d'une execution a l'autre
+Kind nextKind(const Options& options, unsigned int& seed) {
+    int total = 0;
+    for (int k = 0; k < KIND_COUNT; ++k) {
+        total += options.weights[k];
+    }
+    seed = seed * 1103515245 + 12345;
+    int pick = static_cast<int>((seed >> 8) % static_cast<unsigned int>(total));
+    for (int k = 0; k < KIND_COUNT; ++k) {
+        if (pick < options.weights[k]) {
+            return static_cast<Kind>(k);
+        }
+        pick -= options.weights[k];
+    }
+    return KIND_STATIC;
+}
+
+double ms(unsigned long ns) {
+    return ns / 1e6;
+}
+
+void latencyJson(std::ostream& out, const LatencyHistogram& h) {
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer),
+                  "{ \"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"p999\": %.3f, \"max\": %.3f }",
+                  h.count() ? ms(h.sumNs() / h.count()) : 0.0, ms(h.quantileNs(0.5)), ms(h.quantileNs(0.9)),
+                  ms(h.quantileNs(0.99)), ms(h.quantileNs(0.999)), ms(h.maxNs()));
+    out << buffer;
+}
+
+void statsJson(std::ostream& out, const KindStats& stats, const char* indent) {
+    static const char* classes[6] = { "other", "1xx", "2xx", "3xx", "4xx", "5xx" };
+    out << "{\n" << indent << "  \"requests\": " << stats.requests << ",\n"
+        << indent << "  \"errors\": { \"connect\": " << stats.failures[Client::FAIL_CONNECT]
+        << ", \"io\": " << stats.failures[Client::FAIL_IO]
+        << ", \"protocol\": " << stats.failures[Client::FAIL_PROTOCOL]
+        << ", \"timeout\": " << stats.failures[Client::FAIL_TIMEOUT] << " },\n"
+        << indent << "  \"status\": {";
+    for (int c = 1; c <= 6; ++c) {
+        out << (c > 1 ? ", " : " ") << '"' << classes[c % 6] << "\": " << stats.statusClasses[c % 6];
+    }
+    out << " },\n" << indent << "  \"received_bytes\": " << stats.bytes << ",\n"
+        << indent << "  \"latency_ms\": ";
+    latencyJson(out, stats.latency);
+    out << "\n" << indent << "}";
+}
+
+void jsonString(std::ostream& out, const std::string& value) {
+    out << '"';
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (value[i] == '"' || value[i] == '\\') {
+            out << '\\';
+        }
+        out << value[i];
+    }
+    out << '"';
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    struct sockaddr_in server;
+    std::memset(&server, 0, sizeof(server));
+    server.sin_family = AF_INET;
+    server.sin_port = htons(static_cast<unsigned short>(options.port));
+    if (inet_pton(AF_INET, options.host.c_str(), &server.sin_addr) != 1) {
+        struct hostent* entry = gethostbyname(options.host.c_str());
+        if (entry == NULL || entry->h_addrtype != AF_INET) {
+            std::cerr << "loadgen: cannot resolve " << options.host << "\n";
+            return 1;
+        }
+        std::memcpy(&server.sin_addr, entry->h_addr_list[0], sizeof(server.sin_addr));
+    }
+
+    std::string requests[KIND_COUNT];
+    for (int k = 0; k < KIND_COUNT; ++k) {
+        if (options.weights[k] > 0) {
+            requests[k] = buildRequest(static_cast<Kind>(k), options);
+        }
+    }
+
+    std::vector<Slot> slots(options.concurrency);
+    for (size_t s = 0; s < slots.size(); ++s) {
+        slots[s].client = new Client(server);
+        slots[s].kind = KIND_STATIC;
+        slots[s].startedNs = 0;
+    }
+    KindStats total;
+    KindStats kinds[KIND_COUNT];
+    unsigned int seed = 1;
+    unsigned long issued = 0;
+    unsigned long begin = nowNs();
+    unsigned long deadline = begin + static_cast<unsigned long>(options.duration * 1e9);
+    unsigned long timeoutNs = static_cast<unsigned long>(options.timeoutMs) * 1000000UL;
+    std::vector<pollfd> fds;
+    std::vector<size_t> fdSlots;
+
+    for (;;) {
+        unsigned long now = nowNs();
+        bool accepting = (options.requests > 0) ? issued < options.requests : now < deadline;
+        size_t active = 0;
+        fds.clear();
+        fdSlots.clear();
+        for (size_t s = 0; s < slots.size(); ++s) {
+            Slot& slot = slots[s];
+            Client::State state = slot.client->state();
+            if (state == Client::CLIENT_DONE || state == Client::CLIENT_FAILED) {
+                // Requete terminee : comptee, puis la connexion est rendue ou fermee
+                KindStats* targets[2] = { &total, &kinds[slot.kind] };
+                for (int t = 0; t < 2; ++t) {
+                    ++targets[t]->requests;
+                    if (state == Client::CLIENT_FAILED) {
+                        ++targets[t]->failures[slot.client->failure()];
+                        continue;
+                    }
+                    int statusClass = slot.client->status() / 100;
+                    ++targets[t]->statusClasses[(statusClass >= 1 && statusClass <= 5) ? statusClass : 0];
+                    targets[t]->bytes += slot.client->received();
+                    targets[t]->latency.record(now - slot.startedNs);
+                }
+                slot.client->reset(options.keepAlive);
+                state = Client::CLIENT_IDLE;
+            } else if (state != Client::CLIENT_IDLE && now - slot.startedNs > timeoutNs) {
+                slot.client->abort();
+                continue; // Comptee au tour suivant
+            }
+            if (state == Client::CLIENT_IDLE && accepting) {
+                slot.kind = nextKind(options, seed);
+                slot.startedNs = nowNs();
+                slot.client->start(&requests[slot.kind]);
+                ++issued;
+                accepting = (options.requests > 0) ? issued < options.requests : now < deadline;
+            }
+            if (slot.client->events() != 0) {
+                pollfd pfd;
+                pfd.fd = slot.client->fd();
+                pfd.events = slot.client->events();
+                pfd.revents = 0;
+                fds.push_back(pfd);
+                fdSlots.push_back(s);
+            }
+            Client::State after = slot.client->state();
+            if (after != Client::CLIENT_IDLE) {
+                ++active;
+            }
+        }
+        if (active == 0 && !accepting) {
+            break;
+        }
+        if (fds.empty()) {
+            continue; // Requetes terminees sans attendre (erreur de connect immediate)
+        }
+        if (poll(&fds[0], fds.size(), 100) == -1) {
+            continue;
+        }
+        for (size_t i = 0; i < fds.size(); ++i) {
+            Client* client = slots[fdSlots[i]].client;
+            if (fds[i].revents & (POLLOUT | POLLERR | POLLHUP)) {
+                if (client->events() == POLLOUT) {
+                    client->onWritable();
+                }
+            }
+            if (fds[i].revents & (POLLIN | POLLERR | POLLHUP)) {
+                if (client->events() == POLLIN) {
+                    client->onReadable();
+                }
+            }
+        }
+    }
+    double elapsed = (nowNs() - begin) / 1e9;
+    unsigned long reconnects = 0;
+    for (size_t s = 0; s < slots.size(); ++s) {
+        reconnects += slots[s].client->reconnects();
+        delete slots[s].client;
+    }
+
+    std::ofstream file;
+    if (!options.json.empty()) {
+        file.open(options.json.c_str());
+        if (!file.is_open()) {
+            std::cerr << "loadgen: cannot write " << options.json << "\n";
+            return 1;
+        }
+    }
+    std::ostream& out = options.json.empty() ? std::cout : file;
+    char rate[64];
+    std::snprintf(rate, sizeof(rate), "%.1f", elapsed > 0 ? total.requests / elapsed : 0.0);
+    out << "{\n  \"label\": ";
+    jsonString(out, options.label);
+    std::ostringstream target;
+    target << options.host << ':' << options.port;
+    out << ",\n  \"target\": ";
+    jsonString(out, target.str());
+    out << ",\n"
+        << "  \"concurrency\": " << options.concurrency << ",\n"
+        << "  \"keepalive\": " << (options.keepAlive ? "true" : "false") << ",\n"
+        << "  \"duration_s\": " << elapsed << ",\n"
+        << "  \"throughput_rps\": " << rate << ",\n"
+        << "  \"reconnects\": " << reconnects << ",\n"
+        << "  \"total\": ";
+    statsJson(out, total, "  ");
+    out << ",\n  \"kinds\": {";
+    bool first = true;
+    for (int k = 0; k < KIND_COUNT; ++k) {
+        if (options.weights[k] == 0) {
+            continue;
+        }
+        out << (first ? "\n" : ",\n") << "    \"" << g_kindNames[k] << "\": ";
+        statsJson(out, kinds[k], "    ");
+        first = false;
+    }
+    out << "\n  }\n}\n";
+
+    std::cerr << total.requests << " requests in " << elapsed << " s, " << rate << " req/s, p99 "
+              << ms(total.latency.quantileNs(0.99)) << " ms, "
+              << (total.requests - total.latency.count()) << " errors\n";
+    return 0;
+}
@@ -0,0 +1,433 @@
+// MicroBench.cpp
+// Cout par operation des chemins chauds du serveur, sans socket : parse de requete, serialisation de reponse,
+// choix de location, lecture de session, decoupage multipart. Objets du serveur tels que compiles par `make`.
+// make microbench && ./microbench [--corpus=bench/corpus.jsonl] [--filter=parse] [--time=200] [--json[=out.json]] [--label=text]
+// ns/op au temps monotone ; allocs/op et bytes/op par les compteurs d'AllocStats (operator new remplace).
+// Travail dans un repertoire temporaire (logs/, sessions/, uploads/), garde pour inspection et affiche a la fin.
+#include "Corpus.hpp"
+#include "HTTPRequest.hpp"
+#include "HTTPResponse.hpp"
+#include "ResponseWriter.hpp"
+#include "ServerConfig.hpp"
+#include "SessionManager.hpp"
+#include "Server.hpp"
+#include "StatusLine.hpp"
+#include "AllocStats.hpp"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+volatile size_t g_sink; // Empeche le compilateur de supprimer les boucles
+
+unsigned long nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<unsigned long>(ts.tv_sec) * 1000000000UL + static_cast<unsigned long>(ts.tv_nsec);
+}
+
+// Une operation par run(), sur l'element suivant de son jeu d'entrees
+class Bench {
+public:
+    Bench(const char* name) : _name(name), _input(0) {}
+    virtual ~Bench() {}
+    virtual void run() = 0;
+    const char* name() const { return _name; }
+    // Octets d'entree moyens par operation, 0 si sans objet
+    double input() const { return _input; }
+
+protected:
+    const char* _name;
+    double _input;
+};
+
+struct Result {
+    std::string name;
+    unsigned long iterations;
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesPerOp;
+    double inputPerOp;
+};
+
+// Iterations doublees (ou plus) jusqu'a tenir `minNs` : les premiers tours servent de chauffe
+Result measure(Bench& bench, unsigned long minNs) {
+    unsigned long iterations = 1;
+    while (true) {
+        unsigned long allocations = AllocStats::allocations();
+        unsigned long bytes = AllocStats::bytes();
+        unsigned long start = nowNs();
+        for (unsigned long i = 0; i < iterations; ++i) {
+            bench.run();
+        }
+        unsigned long elapsed = nowNs() - start;
+        if (elapsed >= minNs) {
+            Result result;
+            result.name = bench.name();
+            result.iterations = iterations;
+            result.nsPerOp = static_cast<double>(elapsed) / iterations;
+            result.allocsPerOp = static_cast<double>(AllocStats::allocations() - allocations) / iterations;
+            result.bytesPerOp = static_cast<double>(AllocStats::bytes() - bytes) / iterations;
+            result.inputPerOp = bench.input();
+            return result;
+        }
+        unsigned long scale = (elapsed == 0) ? 100 : (minNs + minNs / 5) / elapsed;
+        iterations *= (scale < 2) ? 2 : (scale > 100 ? 100 : scale);
+    }
+}
+
+// Chemin sans query string, comme le route la boucle
+std::string pathOnly(const std::string& target) {
+    return target.substr(0, target.find('?'));
+}
+
+std::string boundaryOf(const CorpusRequest& request) {
+    std::string type = request.header("Content-Type");
+    if (type.compare(0, 19, "multipart/form-data") != 0) {
+        return "";
+    }
+    size_t pos = type.find("boundary=");
+    return (pos == std::string::npos) ? "" : type.substr(pos + 9);
+}
+
+// Requetes du corpus telles que recues, une instance reutilisee comme dans ConnectionTable
+class ParseBench : public Bench {
+public:
+    ParseBench(const std::vector<CorpusRequest>& corpus) : Bench("request.parse"), _next(0) {
+        for (size_t i = 0; i < corpus.size(); ++i) {
+            _raw.push_back(corpus[i].raw("localhost", NULL));
+            _input += _raw.back().size();
+        }
+        _input /= _raw.size();
+    }
+
+    void run() {
+        const std::string& raw = _raw[_next];
+        _next = (_next + 1) % _raw.size();
+        _request.reset();
+        _request._rawRequest.assign(raw);
+        if (_request.parse()) {
+            g_sink += _request.getPath().size() + _request.getBody().size();
+        }
+    }
+
+private:
+    std::vector<std::string> _raw;
+    size_t _next;
+    HTTPRequest _request;
+};
+
+// Reponse typique d'un fichier statique (headers et corps de 4 KiB), construite a chaque operation
+class ResponseBench : public Bench {
+public:
+    ResponseBench(const char* name, bool writer) : Bench(name), _writer(writer), _body(4096, 'x') {
+        _input = _body.size();
+    }
+
+    void run() {
+        HTTPResponse response;
+        response.setStatusCode(200);
+        response.setHeader("Content-Type", "text/html");
+        response.setHeader("Content-Length", "4096");
+        response.setHeader("Last-Modified", "Mon, 13 Oct 2026 09:12:44 GMT");
+        response.setHeader("Connection", "keep-alive");
+        response.addHeader("Set-Cookie", "session_id=6d08cd39-17f2-4be8-bcb9-8b6830df1964; Path=/; HttpOnly");
+        response.setBody(_body);
+        if (_writer) {
+            // Chemin d'envoi reel : iovecs prepares, jamais envoyes
+            _output.queue(response);
+            g_sink += _output.pending();
+            _output.clear();
+        } else {
+            g_sink += response.toString().size();
+        }
+    }
+
+private:
+    bool _writer;
+    std::string _body;
+    ResponseWriter _output;
+};
+
+// Chemins du corpus contre les locations d'un server de taille moyenne
+class LocationBench : public Bench {
+public:
+    LocationBench(const std::vector<CorpusRequest>& corpus) : Bench("config.findLocation"), _next(0) {
+        static const char* paths[] = {
+            "/", "/images", "/uploads", "/cgi-bin", "/api", "/docs", "/redirect", "/metrics",
+            "/static", "/assets", "/downloads", "/admin", "/blog", "/media", "/private", "/old"
+        };
+        for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); ++i) {
+            Location location;
+            location.path = paths[i];
+            location.allowedMethods.push_back("GET");
+            _config.locations.push_back(location);
+        }
+        for (size_t i = 0; i < corpus.size(); ++i) {
+            _paths.push_back(pathOnly(corpus[i].path));
+            _input += _paths.back().size();
+        }
+        _input /= _paths.size();
+    }
+
+    void run() {
+        const Location* location = _config.findLocation(_paths[_next]);
+        _next = (_next + 1) % _paths.size();
+        g_sink += (location != NULL);
+    }
+
+private:
+    ServerConfig _config;
+    std::vector<std::string> _paths;
+    size_t _next;
+};
+
+// Fichier de session au format de persistSession, un enregistrement ajoute par requete
+class SessionBench : public Bench {
+public:
+    SessionBench(size_t records) : Bench("session.load"), _id("6d08cd39-17f2-4be8-bcb9-8b6830df1964"), _session(NULL) {
+        std::string path = "sessions/" + _id + ".txt";
+        std::ofstream file(path.c_str(), std::ofstream::out | std::ofstream::trunc);
+        std::string pages = "/index.html";
+        for (size_t i = 0; i < records; ++i) {
+            file << "[General]\nlast_access_time=2026-10-19 09:12:" << (10 + i % 50) << "\nstatus=active\n"
+                 << "user_agent=Mozilla/5.0 (X11; Linux x86_64; rv:120.0) Gecko/20100101 Firefox/120.0\n"
+                 << "\n[Requests]\nPages=" << pages << "\nMethods=GET\n";
+            pages += ",/images/logo.png";
+        }
+        file.close();
+        struct stat st;
+        _input = (stat(path.c_str(), &st) == 0) ? st.st_size : 0;
+        // Le constructeur salue l'utilisateur sur stdout : hors du tableau
+        std::ostringstream muted;
+        std::streambuf* saved = std::cout.rdbuf(muted.rdbuf());
+        _session = new SessionManager(_id);
+        std::cout.rdbuf(saved);
+    }
+
+    ~SessionBench() {
+        delete _session;
+    }
+
+    void run() {
+        _session->loadSession();
+        g_sink += 1;
+    }
+
+private:
+    std::string _id;
+    SessionManager* _session;
+};
+
+// Corps multipart du corpus, plus un envoi de 4 fichiers de 16 KiB
+class MultipartBench : public Bench {
+public:
+    MultipartBench(const std::vector<CorpusRequest>& corpus) : Bench("upload.parseMultipart"), _server(ServerConfig()), _next(0) {
+        for (size_t i = 0; i < corpus.size(); ++i) {
+            std::string boundary = boundaryOf(corpus[i]);
+            if (!boundary.empty() && !corpus[i].body.empty()) {
+                _bodies.push_back(corpus[i].body);
+                _boundaries.push_back(boundary);
+            }
+        }
+        std::string boundary = "----microbench0123456789";
+        std::string body;
+        for (int part = 0; part < 4; ++part) {
+            body += "--" + boundary + "\r\nContent-Disposition: form-data; name=\"file\"; filename=\"part" +
+                    static_cast<char>('0' + part) + ".bin\"\r\nContent-Type: application/octet-stream\r\n\r\n";
+            unsigned int seed = 42 + part;
+            for (size_t i = 0; i < 16 * 1024; ++i) {
+                seed = seed * 1103515245 + 12345;
+                body += static_cast<char>((seed >> 16) & 0xFF);
+            }
+            body += "\r\n";
+        }
+        body += "--" + boundary + "--\r\n";
+        _bodies.push_back(body);
+        _boundaries.push_back(boundary);
+        for (size_t i = 0; i < _bodies.size(); ++i) {
+            _input += _bodies[i].size();
+        }
+        _input /= _bodies.size();
+    }
+
+    void run() {
+        std::vector<UploadHandler::Part> parts;
+        HTTPResponse response;
+        _server.parseMultipart(_bodies[_next], _boundaries[_next], "uploads", parts, response);
+        _next = (_next + 1) % _bodies.size();
+        g_sink += parts.size();
+    }
+
+private:
+    Server _server;
+    std::vector<std::string> _bodies;
+    std::vector<std::string> _boundaries;
+    size_t _next;
+};
+
+struct Options {
+    std::string corpus;
+    std::string filter;
+    unsigned long minNs;
+    bool json;
+    std::string jsonFile; // "" : stdout
+    std::string label;
+
+    Options() : corpus("bench/corpus.jsonl"), minNs(200000000UL), json(false) {}
+};
+
+void usage() {
+    std::cerr << "usage: microbench [--corpus=bench/corpus.jsonl] [--filter=substring] [--time=200]\n"
+                 "                  [--json[=out.json]] [--label=text]\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t equal = arg.find('=');
+        std::string name = arg.substr(0, equal);
+        std::string value = (equal == std::string::npos) ? "" : arg.substr(equal + 1);
+        if (name == "--corpus") {
+            options.corpus = value;
+        } else if (name == "--filter") {
+            options.filter = value;
+        } else if (name == "--time") {
+            long ms = std::atol(value.c_str());
+            if (ms <= 0) {
+                return false;
+            }
+            options.minNs = static_cast<unsigned long>(ms) * 1000000UL;
+        } else if (name == "--json") {
+            options.json = true;
+            options.jsonFile = value;
+        } else if (name == "--label") {
+            options.label = value;
+        } else {
+            return false;
+        }
+    }
+    return !options.corpus.empty();
+}
+
+void jsonString(std::ostream& out, const std::string& value) {
+    out << '"';
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (value[i] == '"' || value[i] == '\\') {
+            out << '\\';
+        }
+        out << value[i];
+    }
+    out << '"';
+}
+
+void printTable(std::ostream& out, const std::vector<Result>& results) {
+    out << std::left << std::setw(24) << "benchmark" << std::right
+        << std::setw(12) << "ns/op" << std::setw(12) << "allocs/op" << std::setw(12) << "bytes/op"
+        << std::setw(12) << "input B" << std::setw(10) << "MB/s" << "\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << std::left << std::setw(24) << r.name << std::right << std::fixed
+            << std::setw(12) << std::setprecision(1) << r.nsPerOp
+            << std::setw(12) << std::setprecision(2) << r.allocsPerOp
+            << std::setw(12) << std::setprecision(0) << r.bytesPerOp
+            << std::setw(12) << std::setprecision(0) << r.inputPerOp
+            << std::setw(10) << std::setprecision(1) << (r.inputPerOp > 0 ? r.inputPerOp * 1000.0 / r.nsPerOp : 0.0) << "\n";
+    }
+}
+
+void printJson(std::ostream& out, const std::vector<Result>& results, const Options& options, const CorpusStats& stats) {
+    out << "{\n  \"label\": ";
+    jsonString(out, options.label);
+    out << ",\n  \"corpus\": ";
+    jsonString(out, options.corpus);
+    out << ",\n  \"corpus_requests\": " << stats.loaded << ",\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << (i == 0 ? "\n" : ",\n") << "    { \"name\": ";
+        jsonString(out, r.name);
+        out << std::fixed << ", \"iterations\": " << r.iterations
+            << ", \"ns_per_op\": " << std::setprecision(1) << r.nsPerOp
+            << ", \"allocs_per_op\": " << std::setprecision(2) << r.allocsPerOp
+            << ", \"bytes_per_op\": " << std::setprecision(0) << r.bytesPerOp
+            << ", \"input_bytes_per_op\": " << r.inputPerOp << " }";
+    }
+    out << "\n  ]\n}\n";
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    std::vector<CorpusRequest> corpus;
+    CorpusStats stats;
+    if (!loadCorpus(options.corpus, corpus, stats)) {
+        std::cerr << "microbench: cannot read " << options.corpus << "\n";
+        return 1;
+    }
+    if (corpus.empty()) {
+        std::cerr << "microbench: no request in " << options.corpus << " (" << stats.skipped
+                  << " lines without \"method\", " << stats.invalid << " invalid)\n";
+        return 1;
+    }
+    std::ofstream file;
+    if (!options.jsonFile.empty()) {
+        file.open(options.jsonFile.c_str());
+        if (!file.is_open()) {
+            std::cerr << "microbench: cannot write " << options.jsonFile << "\n";
+            return 1;
+        }
+    }
+
+    // Logs, sessions et uploads du serveur hors du depot ; pas de question du Logger a la sortie
+    char workDir[] = "/tmp/microbench.XXXXXX";
+    if (mkdtemp(workDir) == NULL || chdir(workDir) != 0) {
+        std::cerr << "microbench: cannot create a work directory\n";
+        return 1;
+    }
+    mkdir("sessions", 0755);
+    mkdir("uploads", 0755);
+    if (std::freopen("/dev/null", "r", stdin) == NULL) {
+        std::cerr << "microbench: cannot detach stdin\n";
+    }
+    DateCache::refresh(static_cast<unsigned long>(time(NULL)) * 1000);
+
+    std::vector<Bench*> benches;
+    benches.push_back(new ParseBench(corpus));
+    benches.push_back(new ResponseBench("response.toString", false));
+    benches.push_back(new ResponseBench("response.queue", true));
+    benches.push_back(new LocationBench(corpus));
+    benches.push_back(new SessionBench(20));
+    benches.push_back(new MultipartBench(corpus));
+
+    std::vector<Result> results;
+    for (size_t i = 0; i < benches.size(); ++i) {
+        if (options.filter.empty() || std::string(benches[i]->name()).find(options.filter) != std::string::npos) {
+            results.push_back(measure(*benches[i], options.minNs));
+        }
+        delete benches[i];
+    }
+
+    // JSON sur stdout : le tableau passe sur stderr
+    std::ostream& table = (options.json && options.jsonFile.empty()) ? std::cerr : std::cout;
+    printTable(table, results);
+    table << "corpus: " << options.corpus << " (" << stats.loaded << " requests, " << stats.skipped
+          << " skipped, " << stats.invalid << " invalid), work dir: " << workDir << "\n";
+    if (options.json) {
+        printJson(options.jsonFile.empty() ? std::cout : file, results, options, stats);
+    }
+    return 0;
+}
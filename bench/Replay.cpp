@@ -0,0 +1,441 @@
+// Replay.cpp
+// Rejeu d'un trafic enregistre (JSONL, voir Corpus.hpp) contre un serveur lance : chaque requete part a son instant
+// d'origine divise par --speed (0 : sans attente), sur au plus --concurrency connexions, dans l'ordre du fichier.
+// Statut et taille (octets recus, headers compris, comme l'access log) sont compares a l'enregistrement ;
+// la taille ne l'est pas avec --close, qui change le header Connection des reponses.
+// make bench && ./replay --port=8080 --corpus=bench/corpus.jsonl --speed=4 --concurrency=16 --loops=10
+// Code de sortie 3 si une reponse differe ou echoue ; le JSON (--json[=fichier]) se compare comme celui de loadgen.
+#include "Client.hpp"
+#include "Corpus.hpp"
+#include "LatencyHistogram.hpp"
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <signal.h>
+#include <ctime>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+#define REPLAY_MISMATCHES_MAX 100 // Ecarts detailles dans le JSON
+
+struct Options {
+    std::string host;
+    int port;
+    std::string corpus;
+    double speed;            // Facteur d'acceleration, 0 : au plus vite
+    int concurrency;
+    unsigned long loops;     // Passes sur l'enregistrement
+    bool close;              // Connection: close force sur chaque requete
+    int timeoutMs;           // Par requete
+    bool verbose;            // Ecarts sur stderr au fil de l'eau
+    bool json;
+    std::string jsonFile;    // "" : stdout
+    std::string label;
+
+    Options() : host("127.0.0.1"), port(8080), corpus("bench/corpus.jsonl"), speed(1), concurrency(8), loops(1),
+                close(false), timeoutMs(10000), verbose(false), json(false) {}
+};
+
+// Requete prete a partir : octets, instant relatif au debut du rejeu, reponse attendue
+struct Scheduled {
+    const CorpusRequest* recorded;
+    const std::string* raw;
+    bool keepAlive;
+    unsigned long dueNs;
+};
+
+struct Mismatch {
+    size_t index; // Ligne de requete dans le corpus (sans les lignes ignorees)
+    int status;
+    size_t size;
+    Client::Failure failure;
+};
+
+struct Slot {
+    Client* client;
+    size_t request;          // Indice dans le planning
+    unsigned long startedNs;
+};
+
+struct Stats {
+    unsigned long requests;
+    unsigned long failures[5]; // Par Client::Failure
+    unsigned long statusMismatches;
+    unsigned long sizeMismatches;
+    unsigned long unchecked;   // Ni statut ni taille enregistres
+    unsigned long bytes;
+    LatencyHistogram latency;
+    LatencyHistogram lag;      // Depart effectif moins instant prevu : connexions toutes occupees
+    std::vector<Mismatch> mismatches;
+
+    Stats() : requests(0), statusMismatches(0), sizeMismatches(0), unchecked(0), bytes(0) {
+        std::memset(failures, 0, sizeof(failures));
+    }
+};
+
+const char* g_failureNames[5] = { "none", "connect", "io", "protocol", "timeout" };
+
+unsigned long nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<unsigned long>(ts.tv_sec) * 1000000000UL + static_cast<unsigned long>(ts.tv_nsec);
+}
+
+double ms(unsigned long ns) {
+    return ns / 1e6;
+}
+
+void usage() {
+    std::cerr << "usage: replay [--host=127.0.0.1] [--port=8080] [--corpus=bench/corpus.jsonl] [--speed=1 | --speed=0]\n"
+                 "              [--concurrency=8] [--loops=1] [--close] [--timeout=10000] [--verbose]\n"
+                 "              [--json[=out.json]] [--label=text]\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t equal = arg.find('=');
+        std::string name = arg.substr(0, equal);
+        std::string value = (equal == std::string::npos) ? "" : arg.substr(equal + 1);
+        if (name == "--host") {
+            options.host = value;
+        } else if (name == "--port") {
+            options.port = std::atoi(value.c_str());
+        } else if (name == "--corpus") {
+            options.corpus = value;
+        } else if (name == "--speed") {
+            options.speed = std::atof(value.c_str());
+        } else if (name == "--concurrency") {
+            options.concurrency = std::atoi(value.c_str());
+        } else if (name == "--loops") {
+            options.loops = std::strtoul(value.c_str(), NULL, 10);
+        } else if (name == "--close") {
+            options.close = true;
+        } else if (name == "--timeout") {
+            options.timeoutMs = std::atoi(value.c_str());
+        } else if (name == "--verbose") {
+            options.verbose = true;
+        } else if (name == "--json") {
+            options.json = true;
+            options.jsonFile = value;
+        } else if (name == "--label") {
+            options.label = value;
+        } else {
+            return false;
+        }
+    }
+    return options.port > 0 && options.concurrency > 0 && options.timeoutMs > 0 && options.loops > 0
+        && options.speed >= 0 && !options.corpus.empty();
+}
+
+// Instants relatifs a la premiere requete ; "t" absent : juste apres la precedente.
+// Chaque passe suivante reprend a la fin de la precedente.
+void schedule(const std::vector<CorpusRequest>& corpus, const std::vector<std::string>& raw, const Options& options,
+              std::vector<Scheduled>& plan) {
+    std::vector<double> offsets(corpus.size(), 0);
+    double first = -1;
+    double previous = 0;
+    for (size_t i = 0; i < corpus.size(); ++i) {
+        if (corpus[i].time >= 0) {
+            if (first < 0) {
+                first = corpus[i].time;
+            }
+            previous = (corpus[i].time - first > previous) ? corpus[i].time - first : previous;
+        }
+        offsets[i] = previous;
+    }
+    double span = previous;
+    for (unsigned long loop = 0; loop < options.loops; ++loop) {
+        for (size_t i = 0; i < corpus.size(); ++i) {
+            Scheduled item;
+            item.recorded = &corpus[i];
+            item.raw = &raw[i];
+            item.keepAlive = !options.close && corpus[i].header("Connection") != "close";
+            double seconds = (options.speed > 0) ? (offsets[i] + loop * span) / options.speed : 0;
+            item.dueNs = static_cast<unsigned long>(seconds * 1e9);
+            plan.push_back(item);
+        }
+    }
+}
+
+// Reponse comparee a l'enregistrement, ecarts comptes et gardes pour le JSON
+void compare(const Scheduled& item, size_t index, const Client& client, const Options& options, Stats& stats) {
+    const CorpusRequest& recorded = *item.recorded;
+    ++stats.requests;
+    Mismatch mismatch;
+    mismatch.index = index;
+    mismatch.status = client.status();
+    mismatch.size = client.received();
+    mismatch.failure = client.failure();
+    bool differs = false;
+    if (client.state() == Client::CLIENT_FAILED) {
+        ++stats.failures[client.failure()];
+        differs = true;
+    } else {
+        stats.bytes += client.received();
+        if (recorded.status == 0 && (recorded.size < 0 || options.close)) {
+            ++stats.unchecked;
+        }
+        if (recorded.status != 0 && recorded.status != client.status()) {
+            ++stats.statusMismatches;
+            differs = true;
+        }
+        // --close change le header Connection des reponses : tailles non comparables
+        if (recorded.size >= 0 && !options.close && static_cast<size_t>(recorded.size) != client.received()) {
+            ++stats.sizeMismatches;
+            differs = true;
+        }
+    }
+    if (!differs) {
+        return;
+    }
+    if (stats.mismatches.size() < REPLAY_MISMATCHES_MAX) {
+        stats.mismatches.push_back(mismatch);
+    }
+    if (options.verbose) {
+        std::cerr << "replay: #" << index << ' ' << recorded.method << ' ' << recorded.path << ": ";
+        if (mismatch.failure != Client::FAIL_NONE) {
+            std::cerr << g_failureNames[mismatch.failure] << " error\n";
+        } else {
+            std::cerr << "status " << mismatch.status << " (recorded " << recorded.status << "), "
+                      << mismatch.size << " bytes (recorded " << recorded.size << ")\n";
+        }
+    }
+}
+
+void histogramJson(std::ostream& out, const LatencyHistogram& h) {
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer),
+                  "{ \"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"p999\": %.3f, \"max\": %.3f }",
+                  h.count() ? ms(h.sumNs() / h.count()) : 0.0, ms(h.quantileNs(0.5)), ms(h.quantileNs(0.9)),
+                  ms(h.quantileNs(0.99)), ms(h.quantileNs(0.999)), ms(h.maxNs()));
+    out << buffer;
+}
+
+void jsonString(std::ostream& out, const std::string& value) {
+    out << '"';
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (value[i] == '"' || value[i] == '\\') {
+            out << '\\';
+        }
+        out << value[i];
+    }
+    out << '"';
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    std::vector<CorpusRequest> corpus;
+    CorpusStats corpusStats;
+    if (!loadCorpus(options.corpus, corpus, corpusStats)) {
+        std::cerr << "replay: cannot read " << options.corpus << "\n";
+        return 1;
+    }
+    if (corpus.empty()) {
+        std::cerr << "replay: no request in " << options.corpus << " (" << corpusStats.skipped
+                  << " lines without \"method\", " << corpusStats.invalid << " invalid)\n";
+        return 1;
+    }
+
+    struct sockaddr_in server;
+    std::memset(&server, 0, sizeof(server));
+    server.sin_family = AF_INET;
+    server.sin_port = htons(static_cast<unsigned short>(options.port));
+    if (inet_pton(AF_INET, options.host.c_str(), &server.sin_addr) != 1) {
+        struct hostent* entry = gethostbyname(options.host.c_str());
+        if (entry == NULL || entry->h_addrtype != AF_INET) {
+            std::cerr << "replay: cannot resolve " << options.host << "\n";
+            return 1;
+        }
+        std::memcpy(&server.sin_addr, entry->h_addr_list[0], sizeof(server.sin_addr));
+    }
+
+    // Host enregistre garde : les virtual hosts voient le meme trafic
+    std::ostringstream target;
+    target << options.host << ':' << options.port;
+    std::vector<std::string> raw;
+    for (size_t i = 0; i < corpus.size(); ++i) {
+        raw.push_back(corpus[i].raw(target.str(), options.close ? "close" : NULL));
+    }
+    std::vector<Scheduled> plan;
+    schedule(corpus, raw, options, plan);
+
+    std::vector<Slot> slots(options.concurrency);
+    for (size_t s = 0; s < slots.size(); ++s) {
+        slots[s].client = new Client(server);
+        slots[s].request = 0;
+        slots[s].startedNs = 0;
+    }
+    Stats stats;
+    size_t next = 0;
+    unsigned long begin = nowNs();
+    unsigned long timeoutNs = static_cast<unsigned long>(options.timeoutMs) * 1000000UL;
+    std::vector<pollfd> fds;
+    std::vector<size_t> fdSlots;
+
+    for (;;) {
+        unsigned long now = nowNs();
+        size_t active = 0;
+        bool idle = false;
+        fds.clear();
+        fdSlots.clear();
+        for (size_t s = 0; s < slots.size(); ++s) {
+            Slot& slot = slots[s];
+            Client::State state = slot.client->state();
+            if (state == Client::CLIENT_DONE || state == Client::CLIENT_FAILED) {
+                const Scheduled& item = plan[slot.request];
+                if (state == Client::CLIENT_DONE) {
+                    stats.latency.record(now - slot.startedNs);
+                }
+                compare(item, slot.request % corpus.size(), *slot.client, options, stats);
+                slot.client->reset(item.keepAlive);
+                state = Client::CLIENT_IDLE;
+            } else if (state != Client::CLIENT_IDLE && now - slot.startedNs > timeoutNs) {
+                slot.client->abort();
+                continue; // Comptee au tour suivant
+            }
+            // Ordre du fichier : une requete en retard passe avant les suivantes
+            if (state == Client::CLIENT_IDLE && next < plan.size() && begin + plan[next].dueNs <= now) {
+                const Scheduled& item = plan[next];
+                slot.request = next++;
+                slot.startedNs = nowNs();
+                stats.lag.record(slot.startedNs - (begin + item.dueNs));
+                slot.client->start(item.raw, item.recorded->method == "HEAD");
+            }
+            if (slot.client->events() != 0) {
+                pollfd pfd;
+                pfd.fd = slot.client->fd();
+                pfd.events = slot.client->events();
+                pfd.revents = 0;
+                fds.push_back(pfd);
+                fdSlots.push_back(s);
+            }
+            if (slot.client->state() != Client::CLIENT_IDLE) {
+                ++active;
+            } else {
+                idle = true;
+            }
+        }
+        if (active == 0 && next == plan.size()) {
+            break;
+        }
+        // Reveil au plus tard pour la prochaine requete due, si une connexion peut la prendre
+        int waitMs = 100;
+        if (next < plan.size() && idle) {
+            unsigned long due = begin + plan[next].dueNs;
+            unsigned long current = nowNs();
+            unsigned long untilDue = (due > current) ? (due - current + 999999) / 1000000 : 0;
+            if (untilDue < static_cast<unsigned long>(waitMs)) {
+                waitMs = static_cast<int>(untilDue);
+            }
+        }
+        if (fds.empty()) {
+            if (waitMs > 0 && active == 0) {
+                poll(NULL, 0, waitMs);
+            }
+            continue;
+        }
+        if (poll(&fds[0], fds.size(), waitMs) == -1) {
+            continue;
+        }
+        for (size_t i = 0; i < fds.size(); ++i) {
+            Client* client = slots[fdSlots[i]].client;
+            if (fds[i].revents & (POLLOUT | POLLERR | POLLHUP)) {
+                if (client->events() == POLLOUT) {
+                    client->onWritable();
+                }
+            }
+            if (fds[i].revents & (POLLIN | POLLERR | POLLHUP)) {
+                if (client->events() == POLLIN) {
+                    client->onReadable();
+                }
+            }
+        }
+    }
+    double elapsed = (nowNs() - begin) / 1e9;
+    unsigned long reconnects = 0;
+    for (size_t s = 0; s < slots.size(); ++s) {
+        reconnects += slots[s].client->reconnects();
+        delete slots[s].client;
+    }
+    unsigned long failures = 0;
+    for (int f = Client::FAIL_CONNECT; f <= Client::FAIL_TIMEOUT; ++f) {
+        failures += stats.failures[f];
+    }
+
+    if (options.json) {
+        std::ofstream file;
+        if (!options.jsonFile.empty()) {
+            file.open(options.jsonFile.c_str());
+            if (!file.is_open()) {
+                std::cerr << "replay: cannot write " << options.jsonFile << "\n";
+                return 1;
+            }
+        }
+        std::ostream& out = options.jsonFile.empty() ? std::cout : file;
+        char rate[64];
+        std::snprintf(rate, sizeof(rate), "%.1f", elapsed > 0 ? stats.requests / elapsed : 0.0);
+        out << "{\n  \"label\": ";
+        jsonString(out, options.label);
+        out << ",\n  \"target\": ";
+        jsonString(out, target.str());
+        out << ",\n  \"corpus\": ";
+        jsonString(out, options.corpus);
+        out << ",\n"
+            << "  \"corpus_requests\": " << corpus.size() << ",\n"
+            << "  \"speed\": " << options.speed << ",\n"
+            << "  \"concurrency\": " << options.concurrency << ",\n"
+            << "  \"loops\": " << options.loops << ",\n"
+            << "  \"duration_s\": " << elapsed << ",\n"
+            << "  \"throughput_rps\": " << rate << ",\n"
+            << "  \"requests\": " << stats.requests << ",\n"
+            << "  \"reconnects\": " << reconnects << ",\n"
+            << "  \"errors\": { \"connect\": " << stats.failures[Client::FAIL_CONNECT]
+            << ", \"io\": " << stats.failures[Client::FAIL_IO]
+            << ", \"protocol\": " << stats.failures[Client::FAIL_PROTOCOL]
+            << ", \"timeout\": " << stats.failures[Client::FAIL_TIMEOUT] << " },\n"
+            << "  \"status_mismatches\": " << stats.statusMismatches << ",\n"
+            << "  \"size_mismatches\": " << stats.sizeMismatches << ",\n"
+            << "  \"unchecked\": " << stats.unchecked << ",\n"
+            << "  \"received_bytes\": " << stats.bytes << ",\n"
+            << "  \"latency_ms\": ";
+        histogramJson(out, stats.latency);
+        out << ",\n  \"lag_ms\": ";
+        histogramJson(out, stats.lag);
+        out << ",\n  \"mismatches\": [";
+        for (size_t i = 0; i < stats.mismatches.size(); ++i) {
+            const Mismatch& m = stats.mismatches[i];
+            const CorpusRequest& recorded = corpus[m.index];
+            out << (i == 0 ? "\n" : ",\n") << "    { \"index\": " << m.index << ", \"method\": ";
+            jsonString(out, recorded.method);
+            out << ", \"path\": ";
+            jsonString(out, recorded.path);
+            out << ", \"error\": ";
+            jsonString(out, g_failureNames[m.failure]);
+            out << ", \"status\": " << m.status << ", \"recorded_status\": " << recorded.status
+                << ", \"size\": " << m.size << ", \"recorded_size\": " << recorded.size << " }";
+        }
+        out << (stats.mismatches.empty() ? "]\n}\n" : "\n  ]\n}\n");
+    }
+
+    std::cerr << stats.requests << " requests in " << elapsed << " s, p99 " << ms(stats.latency.quantileNs(0.99))
+              << " ms, lag p99 " << ms(stats.lag.quantileNs(0.99)) << " ms, " << failures << " errors, "
+              << stats.statusMismatches << " status and " << stats.sizeMismatches << " size mismatches\n";
+    return (failures + stats.statusMismatches + stats.sizeMismatches > 0) ? 3 : 0;
+}
@@ -0,0 +1,142 @@
+// ScanBench.cpp
+// Compare les noyaux de Scan (scalaire, SSE2, AVX2) aux recherches std::string::find qu'ils remplacent.
+// make scan_bench && ./scan_bench
+#include "Scan.hpp"
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <ctime>
+
+namespace {
+
+volatile size_t g_sink; // Empeche le compilateur de supprimer les boucles
+
+double nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+struct Case {
+    const char* name;
+    std::string data;
+    std::string needle;
+    int iterations;
+};
+
+// Requete GET typique d'un navigateur, ~700 octets de headers
+std::string browserRequest() {
+    return "GET /images/photo.jpg?size=large HTTP/1.1\r\n"
+           "Host: www.example.com\r\n"
+           "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:120.0) Gecko/20100101 Firefox/120.0\r\n"
+           "Accept: image/avif,image/webp,image/png,image/svg+xml,image/*;q=0.8,*/*;q=0.5\r\n"
+           "Accept-Language: fr-FR,fr;q=0.8,en-US;q=0.5,en;q=0.3\r\n"
+           "Accept-Encoding: gzip, deflate, br\r\n"
+           "Referer: https://www.example.com/gallery/index.html\r\n"
+           "Connection: keep-alive\r\n"
+           "Cookie: session_id=6d08cd39-17f2-4be8-bcb9-8b6830df1964; theme=dark; lang=fr\r\n"
+           "Sec-Fetch-Dest: image\r\n"
+           "Sec-Fetch-Mode: no-cors\r\n"
+           "Sec-Fetch-Site: same-origin\r\n"
+           "Pragma: no-cache\r\n"
+           "Cache-Control: no-cache\r\n\r\n";
+}
+
+// Corps multipart de 1 MiB dont la boundary finale est a la fin
+std::string multipartBody(const std::string& boundary) {
+    std::string body = "--" + boundary + "\r\nContent-Disposition: form-data; name=\"file\"; filename=\"a.bin\"\r\n\r\n";
+    unsigned int seed = 42;
+    while (body.size() < 1024 * 1024) {
+        seed = seed * 1103515245 + 12345;
+        body += static_cast<char>((seed >> 16) & 0xFF);
+    }
+    body += "\r\n--" + boundary + "--\r\n";
+    return body;
+}
+
+void report(const std::string& label, double totalNs, int iterations, size_t bytes) {
+    double perOp = totalNs / iterations;
+    std::cout << "  " << std::left << std::setw(22) << label
+              << std::right << std::setw(12) << std::fixed << std::setprecision(1) << perOp << " ns/op"
+              << std::setw(10) << std::setprecision(2) << (bytes / perOp) << " GB/s" << std::endl;
+}
+
+typedef size_t (*ScanFn)(const Case&);
+
+size_t stdHeaderEnd(const Case& c) { return c.data.find("\r\n\r\n"); }
+size_t scanHeaderEnd(const Case& c) { return Scan::findHeaderEnd(c.data.data(), c.data.size()); }
+
+size_t stdLines(const Case& c) {
+    size_t count = 0;
+    for (size_t pos = c.data.find("\r\n"); pos != std::string::npos; pos = c.data.find("\r\n", pos + 2)) {
+        ++count;
+    }
+    return count;
+}
+size_t scanLines(const Case& c) {
+    size_t count = 0;
+    const char* data = c.data.data();
+    size_t length = c.data.size();
+    for (size_t pos = 0; ; ) {
+        size_t found = Scan::findCRLF(data + pos, length - pos);
+        if (found == SCAN_NPOS) {
+            break;
+        }
+        ++count;
+        pos += found + 2;
+    }
+    return count;
+}
+
+size_t stdBoundary(const Case& c) { return c.data.find(c.needle); }
+size_t scanBoundary(const Case& c) { return Scan::find(c.data.data(), c.data.size(), c.needle.data(), c.needle.size()); }
+
+size_t stdToken(const Case& c) { return c.data.find_first_of(" \t\"(),/:;<=>?@[\\]{}"); }
+size_t scanToken(const Case& c) { return Scan::tokenLength(c.data.data(), c.data.size()); }
+
+void run(const Case& c, ScanFn reference, ScanFn kernel) {
+    std::cout << c.name << " (" << c.data.size() << " bytes)" << std::endl;
+    double start = nowNs();
+    for (int i = 0; i < c.iterations; ++i) {
+        g_sink = reference(c);
+    }
+    report("std::string", nowNs() - start, c.iterations, c.data.size());
+    size_t expected = reference(c);
+
+    Scan::Level levels[] = { Scan::SCAN_SCALAR, Scan::SCAN_SSE2, Scan::SCAN_AVX2 };
+    for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); ++l) {
+        Scan::forceLevel(levels[l]);
+        if (Scan::level() != levels[l]) {
+            continue; // Non supporte par ce CPU
+        }
+        size_t result = kernel(c);
+        start = nowNs();
+        for (int i = 0; i < c.iterations; ++i) {
+            g_sink = kernel(c);
+        }
+        std::string label = std::string("Scan ") + Scan::levelName(levels[l]);
+        if (kernel == scanToken ? result != (expected == std::string::npos ? c.data.size() : expected) : result != expected) {
+            label += " (MISMATCH)";
+        }
+        report(label, nowNs() - start, c.iterations, c.data.size());
+    }
+}
+
+}
+
+int main() {
+    std::string boundary = "----WebKitFormBoundary7MA4YWxkTrZu0gW";
+
+    Case headerEnd = { "end of headers", browserRequest(), "", 200000 };
+    Case lines = { "header line split", browserRequest(), "", 200000 };
+    Case multipart = { "multipart boundary", multipartBody(boundary), "\r\n--" + boundary, 200 };
+    std::string longName(48, 'X');
+    Case token = { "token validation", "X-Forwarded-" + longName + ":", "", 2000000 };
+
+    run(headerEnd, stdHeaderEnd, scanHeaderEnd);
+    run(lines, stdLines, scanLines);
+    run(multipart, stdBoundary, scanBoundary);
+    run(token, stdToken, scanToken);
+    return 0;
+}
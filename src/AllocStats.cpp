@@ -0,0 +1,104 @@
+// AllocStats.cpp
+#include "AllocStats.hpp"
+#include <cstdlib>
+#include <new>
+
+namespace {
+    unsigned long g_requests = 0;
+    unsigned long g_requestAllocations = 0;
+}
+
+#ifdef WEBSERV_ALLOC_STATS
+namespace {
+    unsigned long g_allocations = 0;
+    unsigned long g_bytes = 0;
+    unsigned long g_frees = 0;
+
+    void* countedAlloc(std::size_t size) {
+        __sync_fetch_and_add(&g_allocations, 1);
+        __sync_fetch_and_add(&g_bytes, size);
+        void* ptr = std::malloc(size == 0 ? 1 : size);
+        if (ptr == NULL) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
+    void countedFree(void* ptr) {
+        if (ptr != NULL) {
+            __sync_fetch_and_add(&g_frees, 1);
+            std::free(ptr);
+        }
+    }
+}
+
+void* operator new(std::size_t size) throw(std::bad_alloc) {
+    return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size) throw(std::bad_alloc) {
+    return countedAlloc(size);
+}
+
+void operator delete(void* ptr) throw() {
+    countedFree(ptr);
+}
+
+void operator delete[](void* ptr) throw() {
+    countedFree(ptr);
+}
+#endif
+
+namespace AllocStats {
+
+#ifdef WEBSERV_ALLOC_STATS
+bool enabled() {
+    return true;
+}
+
+unsigned long allocations() {
+    return __sync_fetch_and_add(&g_allocations, 0);
+}
+
+unsigned long bytes() {
+    return __sync_fetch_and_add(&g_bytes, 0);
+}
+
+unsigned long frees() {
+    return __sync_fetch_and_add(&g_frees, 0);
+}
+#else
+bool enabled() {
+    return false;
+}
+
+unsigned long allocations() {
+    return 0;
+}
+
+unsigned long bytes() {
+    return 0;
+}
+
+unsigned long frees() {
+    return 0;
+}
+#endif
+
+void recordRequest(unsigned long allocations) {
+    ++g_requests;
+    g_requestAllocations += allocations;
+}
+
+unsigned long requests() {
+    return g_requests;
+}
+
+double averagePerRequest() {
+    if (g_requests == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(g_requestAllocations) / g_requests;
+}
+
+}
@@ -0,0 +1,28 @@
+// AllocStats.hpp
+#ifndef ALLOCSTATS_HPP
+#define ALLOCSTATS_HPP
+
+#include <cstddef>
+
+/*
+ * Compteurs d'allocations : avec -DWEBSERV_ALLOC_STATS (microbench,
+ * ou make re ALLOC_STATS=1), operator new / delete sont remplaces
+ * globalement (AllocStats.cpp) pour compter chaque allocation du
+ * processus. La boucle principale mesure l'ecart autour du traitement
+ * d'une requete pour suivre le nombre d'allocations par requete.
+ * Increments atomiques : les threads d'I/O peuvent aussi allouer.
+ * Sans le flag, l'allocateur n'est pas touche et les compteurs restent a 0.
+ */
+namespace AllocStats {
+    bool enabled();
+    unsigned long allocations(); // Depuis le demarrage
+    unsigned long bytes();
+    unsigned long frees();
+
+    // Cumul par requete, pour la moyenne affichee a l'arret
+    void recordRequest(unsigned long allocations);
+    unsigned long requests();
+    double averagePerRequest();
+}
+
+#endif
@@ -0,0 +1,79 @@
+// Arena.cpp
+#include "Arena.hpp"
+#include <cstring>
+
+#define ARENA_ALIGN (sizeof(void*) * 2)
+
+Arena::Arena() : _head(NULL), _total(0) {}
+
+Arena::~Arena() {
+    while (_head != NULL) {
+        Block* next = _head->next;
+        delete[] reinterpret_cast<char*>(_head);
+        _head = next;
+    }
+}
+
+char* Arena::dataOf(Block* block) {
+    return reinterpret_cast<char*>(block) + ((sizeof(Block) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1));
+}
+
+Arena::Block* Arena::newBlock(size_t size) {
+    size_t header = (sizeof(Block) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    // operator new : les blocs apparaissent dans les compteurs d'AllocStats
+    Block* block = reinterpret_cast<Block*>(new char[header + size]);
+    block->next = _head;
+    block->size = size;
+    block->used = 0;
+    _head = block;
+    return block;
+}
+
+void* Arena::allocate(size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    if (_head == NULL || _head->size - _head->used < size) {
+        size_t blockSize = ARENA_BLOCK_SIZE;
+        while (blockSize < size) {
+            blockSize *= 2;
+        }
+        newBlock(blockSize);
+    }
+    char* ptr = dataOf(_head) + _head->used;
+    _head->used += size;
+    _total += size;
+    return ptr;
+}
+
+char* Arena::copy(const char* data, size_t length) {
+    char* out = static_cast<char*>(allocate(length + 1));
+    std::memcpy(out, data, length);
+    out[length] = '\0';
+    return out;
+}
+
+void Arena::reset() {
+    if (_head == NULL) {
+        return;
+    }
+    if (_head->next == NULL) {
+        _head->used = 0;
+        _total = 0;
+        return;
+    }
+    // La requete a deborde : un seul bloc assez grand pour la prochaine
+    size_t wanted = ARENA_BLOCK_SIZE;
+    while (wanted < _total && wanted < ARENA_MAX_RETAINED) {
+        wanted *= 2;
+    }
+    while (_head != NULL) {
+        Block* next = _head->next;
+        delete[] reinterpret_cast<char*>(_head);
+        _head = next;
+    }
+    _total = 0;
+    newBlock(wanted);
+}
+
+size_t Arena::used() const {
+    return _total;
+}
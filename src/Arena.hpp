@@ -0,0 +1,46 @@
+// Arena.hpp
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+
+#define ARENA_BLOCK_SIZE 4096       // Premier bloc, suffit aux headers d'une requete courante
+#define ARENA_MAX_RETAINED 65536    // Taille max du bloc garde entre deux requetes
+
+/*
+ * Allocateur "bump" pour la duree d'une requete : chaque allocation avance
+ * un pointeur dans le bloc courant, rien n'est libere individuellement.
+ * reset() rend tout d'un coup en fin de requete et garde un bloc, agrandi
+ * si la requete precedente a deborde : en regime etabli, plus aucun appel
+ * a malloc pour les headers.
+ */
+class Arena {
+public:
+    Arena();
+    ~Arena();
+
+    void* allocate(size_t size);
+    // Copie terminee par '\0'
+    char* copy(const char* data, size_t length);
+    void reset();
+
+    size_t used() const;
+
+private:
+    Arena(const Arena&);
+    Arena& operator=(const Arena&);
+
+    struct Block {
+        Block* next;
+        size_t size;
+        size_t used;
+    };
+
+    Block* newBlock(size_t size);
+    static char* dataOf(Block* block);
+
+    Block* _head; // Bloc courant, les precedents chaines derriere
+    size_t _total;
+};
+
+#endif
@@ -0,0 +1,161 @@
+// BinaryUpgrade.cpp
+#include "BinaryUpgrade.hpp"
+#include "Listener.hpp"
+#include "Logger.hpp"
+#include "Utils.hpp"
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <vector>
+#include <unistd.h>
+
+#define UPGRADE_MAX_FDS 250
+
+namespace {
+    int g_channelFd = -1; // Cote nouveau processus, jusqu'a l'acquittement
+}
+
+namespace BinaryUpgrade {
+
+int start(char* argv[], const std::map<std::string, Listener*>& listeners, pid_t& childPid) {
+    if (listeners.empty() || listeners.size() > UPGRADE_MAX_FDS) {
+        Logger::instance().log(ERROR, "Binary upgrade: nothing to hand off or too many listeners");
+        return -1;
+    }
+
+    int channel[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, channel) == -1) {
+        Logger::instance().log(ERROR, std::string("Binary upgrade: socketpair failed: ") + strerror(errno));
+        return -1;
+    }
+
+    childPid = fork();
+    if (childPid == -1) {
+        Logger::instance().log(ERROR, std::string("Binary upgrade: fork failed: ") + strerror(errno));
+        close(channel[0]);
+        close(channel[1]);
+        return -1;
+    }
+    if (childPid == 0) {
+        // Ne garder que stdio et le canal : les sockets clients ne doivent pas survivre dans le nouveau processus
+        long maxFd = sysconf(_SC_OPEN_MAX);
+        for (int fd = 3; fd < maxFd; ++fd) {
+            if (fd != channel[1]) {
+                close(fd);
+            }
+        }
+        setenv(UPGRADE_ENV, to_string(channel[1]).c_str(), 1);
+        execv(argv[0], argv);
+        _exit(EXIT_FAILURE);
+    }
+    close(channel[1]);
+
+    // Un seul message : les cles en charge utile, les fds en donnees auxiliaires
+    std::string keys;
+    std::vector<int> fds;
+    for (std::map<std::string, Listener*>::const_iterator it = listeners.begin(); it != listeners.end(); ++it) {
+        keys += it->first + "\n";
+        fds.push_back(it->second->getFd());
+    }
+
+    std::vector<char> control(CMSG_SPACE(sizeof(int) * fds.size()), 0);
+    struct iovec iov;
+    iov.iov_base = const_cast<char*>(keys.c_str());
+    iov.iov_len = keys.size();
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = &control[0];
+    msg.msg_controllen = control.size();
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+    memcpy(CMSG_DATA(cmsg), &fds[0], sizeof(int) * fds.size());
+
+    if (sendmsg(channel[0], &msg, 0) == -1) {
+        Logger::instance().log(ERROR, std::string("Binary upgrade: sendmsg failed: ") + strerror(errno));
+        close(channel[0]);
+        return -1;
+    }
+    Logger::instance().log(INFO, "Binary upgrade: " + to_string(fds.size()) + " listeners handed off to PID " + to_string(childPid));
+    return channel[0];
+}
+
+bool readAcknowledge(int channelFd) {
+    char ack = 0;
+    ssize_t bytesRead = read(channelFd, &ack, 1);
+    close(channelFd);
+    return bytesRead == 1 && ack == 'A';
+}
+
+std::map<std::string, int> receiveListeners() {
+    std::map<std::string, int> inherited;
+    const char* env = getenv(UPGRADE_ENV);
+    if (env == NULL) {
+        return inherited;
+    }
+    g_channelFd = std::atoi(env);
+    unsetenv(UPGRADE_ENV); // Ne pas le transmettre aux CGI
+
+    char payload[8192];
+    std::vector<char> control(CMSG_SPACE(sizeof(int) * UPGRADE_MAX_FDS), 0);
+    struct iovec iov;
+    iov.iov_base = payload;
+    iov.iov_len = sizeof(payload);
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = &control[0];
+    msg.msg_controllen = control.size();
+
+    ssize_t bytesRead = recvmsg(g_channelFd, &msg, 0);
+    if (bytesRead <= 0) {
+        Logger::instance().log(ERROR, std::string("Binary upgrade: no listeners received: ") + strerror(errno));
+        return inherited;
+    }
+
+    std::vector<int> fds;
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS && cmsg->cmsg_len > CMSG_LEN(0)) {
+            size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            fds.resize(count);
+            memcpy(&fds[0], CMSG_DATA(cmsg), sizeof(int) * count);
+        }
+    }
+
+    std::string keys(payload, bytesRead);
+    size_t start = 0;
+    for (size_t i = 0; i < fds.size(); ++i) {
+        size_t end = keys.find('\n', start);
+        if (end == std::string::npos) {
+            close(fds[i]);
+            continue;
+        }
+        inherited[keys.substr(start, end - start)] = fds[i];
+        start = end + 1;
+    }
+    Logger::instance().log(INFO, "Binary upgrade: inherited " + to_string(inherited.size()) + " listening sockets");
+    return inherited;
+}
+
+void acknowledge() {
+    if (g_channelFd == -1) {
+        return;
+    }
+    char ack = 'A';
+    if (write(g_channelFd, &ack, 1) != 1) {
+        Logger::instance().log(ERROR, std::string("Binary upgrade: acknowledge failed: ") + strerror(errno));
+    }
+    close(g_channelFd);
+    g_channelFd = -1;
+}
+
+}
@@ -0,0 +1,35 @@
+// BinaryUpgrade.hpp
+#ifndef BINARYUPGRADE_HPP
+#define BINARYUPGRADE_HPP
+
+#include <string>
+#include <map>
+#include <sys/types.h>
+
+class Listener;
+
+#define UPGRADE_ENV "WEBSERV_UPGRADE_FD"
+
+/*
+ * Mise a jour a chaud du binaire (SIGUSR2) :
+ * 1. l'ancien processus cree une socketpair AF_UNIX, fork et exec le binaire
+ *    (argv[0]) avec WEBSERV_UPGRADE_FD=<fd> dans l'environnement ;
+ * 2. il envoie toutes ses sockets d'ecoute en un seul message SCM_RIGHTS,
+ *    la charge utile contient les cles "address:port" separees par '\n' ;
+ * 3. le nouveau processus adopte les sockets dont il a besoin au lieu de
+ *    les binder, puis acquitte par un octet ;
+ * 4. a l'acquittement, l'ancien processus ferme ses listeners et draine.
+ * Les sockets ne sont jamais fermees entre les deux : aucun refus de connexion.
+ */
+namespace BinaryUpgrade {
+    // Cote ancien processus : retourne l'extremite a surveiller (POLLIN) ou -1
+    int start(char* argv[], const std::map<std::string, Listener*>& listeners, pid_t& childPid);
+    // true si l'octet d'acquittement est recu, false si le nouveau processus a echoue
+    bool readAcknowledge(int channelFd);
+
+    // Cote nouveau processus : sockets heritees par cle, vide si pas d'upgrade en cours
+    std::map<std::string, int> receiveListeners();
+    void acknowledge();
+}
+
+#endif
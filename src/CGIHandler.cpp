@@ -2,6 +2,8 @@
 #include "CGIHandler.hpp"
 #include "HTTPResponse.hpp"
 #include "Server.hpp"
+#include "FsStats.hpp"
+#include "Metrics.hpp"
 #include <unistd.h>  // For fork, exec, pipe
 #include <sys/wait.h>  // For waitpid
 #include <iostream>
@@ -61,6 +63,7 @@ std::string CGIHandler::executeCGI(const std::string& scriptPath, const HTTPRequ
         return response.beError(500, "Internal Server Error: Unable to create stdin pipe.").toString();
     }
 
+    unsigned long spawnedAt = FsStats::nowNs();
     pid_t pid = fork();
     if (pid == 0) {
         // Processus enfant : exécution du script CGI
@@ -78,9 +81,10 @@ std::string CGIHandler::executeCGI(const std::string& scriptPath, const HTTPRequ
             execl(fullPath.c_str(), fullPath.c_str(), NULL);
         }
         Logger::instance().log(ERROR, std::string("executeCGI: Failed to execute CGI script: ") + fullPath + std::string(". Error: ") + strerror(errno));
-        exit(EXIT_FAILURE);
+        _exit(EXIT_FAILURE); // Pas de destructeurs statiques du parent (DiskPool joindrait des threads absents)
     } else if (pid > 0) {
         // Processus parent : gestion de la sortie du CGI
+        Metrics::cgiSpawned();
         close(pipefd[1]);
         close(pipefd_in[0]);
 
@@ -104,6 +108,7 @@ std::string CGIHandler::executeCGI(const std::string& scriptPath, const HTTPRequ
 
         int status;
         waitpid(pid, &status, 0);
+        Metrics::cgiDuration(FsStats::nowNs() - spawnedAt);
         if (WIFEXITED(status)) {
             int exitCode = WEXITSTATUS(status);
             if (exitCode != 0) {
@@ -154,11 +159,11 @@ void CGIHandler::setupEnvironment(const HTTPRequest& request, std::string script
     setenv("SCRIPT_FILENAME", scriptPath.c_str(), 1);
     setenv("SCRIPT_NAME", scriptPath.c_str(), 1);
     setenv("QUERY_STRING", request.getQueryString().c_str(), 1);
-    setenv("CONTENT_TYPE", request.getStrHeader("Content-Type").c_str(), 1);
+    setenv("CONTENT_TYPE", request.getStrHeader(HEADER_CONTENT_TYPE).c_str(), 1);
     setenv("CONTENT_LENGTH", to_string(request.getBody().size()).c_str(), 1);
     setenv("REDIRECT_STATUS", "200", 1); // Nécessaire pour php-cgi
     setenv("SERVER_PROTOCOL", "HTTP/1.1", 1);
     //setenv("REMOTE_ADDR", request.getClientIP().c_str(), 1);
-    setenv("SERVER_NAME", request.getStrHeader("Host").c_str(), 1);
+    setenv("SERVER_NAME", request.getStrHeader(HEADER_HOST).c_str(), 1);
     //setenv("SERVER_PORT", request.getPort().c_str(), 1);
 }
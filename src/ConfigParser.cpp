@@ -8,7 +8,7 @@
 #include <cctype>
 #include <algorithm>
 
-ConfigParser::ConfigParser() {}
+ConfigParser::ConfigParser() : _workerConnections(WORKER_CONNECTIONS_DEFAULT), _eventsSeen(false) {}
 
 ConfigParser::~ConfigParser() {}
 
@@ -41,6 +41,8 @@ void ConfigParser::parseConfigFile(const std::string &filename) {
                 processServerDirective(file, line, serverConfig);
             }
             _serverConfigs.push_back(serverConfig);
+        } else if (line == "events {") {
+            processEventsBlock(file);
         } else {
             throw ConfigParserException("Unknown or unexpected directive: \"" + line + "\"");
         }
@@ -51,9 +53,52 @@ const std::vector<ServerConfig>& ConfigParser::getServerConfigs() const {
     return _serverConfigs;
 }
 
+int ConfigParser::getWorkerConnections() const {
+    return _workerConnections;
+}
+
+// Reglages du processus, hors de tout server
+void ConfigParser::processEventsBlock(std::ifstream &file) {
+    if (_eventsSeen) {
+        throw ConfigParserException("Duplicate events block");
+    }
+    _eventsSeen = true;
+    std::string line;
+    while (std::getline(file, line)) {
+        trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        if (line == "}") {
+            return;
+        }
+        if (line[line.size() - 1] != ';') {
+            throw ConfigParserException("Missing ';' in events block: \"" + line + "\"");
+        }
+        std::istringstream iss(line.substr(0, line.size() - 1));
+        std::string directive, value, extra;
+        iss >> directive >> value >> extra;
+        if (directive == "worker_connections") {
+            validateDirectiveValue(directive, value + extra);
+            _workerConnections = std::atoi(value.c_str());
+        } else {
+            throw ConfigParserException("Unknown directive in events block: \"" + directive + "\"");
+        }
+    }
+    throw ConfigParserException("Unterminated events block");
+}
+
 void ConfigParser::validateDirectiveValue(const std::string &directive, const std::string &value) {
     if (directive == "listen") {
-        size_t colonPos = value.find(':');
+        size_t colonPos = value.rfind(':');
+        if (!value.empty() && value[0] == '[') {
+            // IPv6 : [addr]:port
+            size_t closingPos = value.find(']');
+            if (closingPos == std::string::npos || closingPos + 1 >= value.size() || value[closingPos + 1] != ':') {
+                throw ConfigParserException("Invalid IPv6 listen address: " + value);
+            }
+            colonPos = closingPos + 1;
+        }
         if (colonPos != std::string::npos) {
             std::string ipAddress = value.substr(0, colonPos);
             std::string portStr = value.substr(colonPos + 1);
@@ -118,7 +163,57 @@ void ConfigParser::validateDirectiveValue(const std::string &directive, const st
     if (value != "on" && value != "off") {
         throw ConfigParserException("Invalid value for 'autoindex': " + value);
 		}
-	}
+    } else if (directive == "autoindex_format") {
+        if (value != "html" && value != "json") {
+            throw ConfigParserException("Invalid value for 'autoindex_format': " + value);
+        }
+	} else if (directive == "client_header_timeout" || directive == "client_body_timeout"
+               || directive == "keepalive_timeout" || directive == "send_timeout") {
+        if (parseTimeValue(value) < 0) {
+            throw ConfigParserException("Invalid value for '" + directive + "': " + value);
+        }
+    } else if (directive == "types_file") {
+        if (value.empty()) {
+            throw ConfigParserException("Invalid path for 'types_file'");
+        }
+    } else if (directive == "default_type") {
+        if (value.find('/') == std::string::npos || value.find_first_of(" \t") != std::string::npos) {
+            throw ConfigParserException("Invalid value for 'default_type': " + value);
+        }
+    } else if (directive == "upload_fsync") {
+        if (value != "on" && value != "off") {
+            throw ConfigParserException("Invalid value for 'upload_fsync': " + value);
+        }
+    } else if (directive == "trace") {
+        if (value != "off" && (value.find_first_not_of("0123456789") != std::string::npos || std::atoi(value.c_str()) < 1)) {
+            throw ConfigParserException("Invalid value for 'trace': " + value);
+        }
+    } else if (directive == "worker_connections") {
+        if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos
+            || value.size() > 7 || std::atoi(value.c_str()) < 1) {
+            throw ConfigParserException("Invalid value for 'worker_connections': " + value);
+        }
+    } else if (directive == "stub_status") {
+        if (value != "on" && value != "off") {
+            throw ConfigParserException("Invalid value for 'stub_status': " + value);
+        }
+    } else if (directive == "upload_directio") {
+        if (value != "off" && parseSizeValue(value) < 1) {
+            throw ConfigParserException("Invalid value for 'upload_directio': " + value);
+        }
+    } else if (directive == "client_header_buffer_size") {
+        if (parseSizeValue(value) < 1) {
+            throw ConfigParserException("Invalid value for 'client_header_buffer_size': " + value);
+        }
+    } else if (directive == "large_client_header_buffers") {
+        std::istringstream valueStream(value);
+        std::string number, size, extra;
+        valueStream >> number >> size >> extra;
+        if (!extra.empty() || number.find_first_not_of("0123456789") != std::string::npos
+            || std::atoi(number.c_str()) < 1 || std::atoi(number.c_str()) > 64 || parseSizeValue(size) < 1) {
+            throw ConfigParserException("Invalid value for 'large_client_header_buffers': " + value);
+        }
+    }
 
 }
 
@@ -154,19 +249,19 @@ void ConfigParser::processServerDirective(std::ifstream &file, const std::string
         if (directive == "location") {
             trim(value);
             processLocationBlock(file, value, serverConfig);
+        } else if (directive == "types" && value.empty()) {
+            processTypesBlock(file, serverConfig);
         } else {
             throw ConfigParserException("Unexpected '{' after directive '" + directive + "'");
         }
     } else if (endsWithSemicolon) {
         if (directive == "listen") {
-            size_t colonPos = value.find(':');
-            if (colonPos != std::string::npos) {
-                serverConfig.host = value.substr(0, colonPos);
-                int port = std::atoi(value.substr(colonPos + 1).c_str());
-                serverConfig.ports.push_back(port);
-            } else {
-                serverConfig.ports.push_back(std::atoi(value.c_str()));
+            ListenDirective listen = parseListenDirective(value);
+            if (!listen.host.empty()) {
+                serverConfig.host = listen.host;
             }
+            serverConfig.ports.push_back(listen.port);
+            serverConfig.listens.push_back(listen);
         } else if (directive == "server_name") {
             std::istringstream valueStream(value);
             std::string serverName;
@@ -217,6 +312,49 @@ void ConfigParser::processServerDirective(std::ifstream &file, const std::string
     		validateDirectiveValue(directive, value);
     		serverConfig.autoindex = (value == "on");
     		Logger::instance().log(DEBUG, "Set autoindex to " + value + " in server config");
+	} else if (directive == "autoindex_format") {
+            validateDirectiveValue(directive, value);
+            serverConfig.autoindexFormat = value;
+	} else if (directive == "client_header_timeout") {
+            validateDirectiveValue(directive, value);
+            serverConfig.clientHeaderTimeout = parseTimeValue(value);
+        } else if (directive == "client_body_timeout") {
+            validateDirectiveValue(directive, value);
+            serverConfig.clientBodyTimeout = parseTimeValue(value);
+        } else if (directive == "keepalive_timeout") {
+            validateDirectiveValue(directive, value);
+            serverConfig.keepaliveTimeout = parseTimeValue(value);
+        } else if (directive == "send_timeout") {
+            validateDirectiveValue(directive, value);
+            serverConfig.sendTimeout = parseTimeValue(value);
+        } else if (directive == "client_header_buffer_size") {
+            validateDirectiveValue(directive, value);
+            serverConfig.clientHeaderBufferSize = parseSizeValue(value);
+        } else if (directive == "types_file") {
+            validateDirectiveValue(directive, value);
+            if (!serverConfig.mimeTypes.loadFile(value)) {
+                throw ConfigParserException("Unable to open types_file: " + value);
+            }
+            Logger::instance().log(DEBUG, "Loaded MIME types from " + value);
+        } else if (directive == "default_type") {
+            validateDirectiveValue(directive, value);
+            serverConfig.defaultType = value;
+        } else if (directive == "upload_fsync") {
+            validateDirectiveValue(directive, value);
+            serverConfig.uploadFsync = (value == "on");
+        } else if (directive == "upload_directio") {
+            validateDirectiveValue(directive, value);
+            serverConfig.uploadDirectIo = (value == "off") ? 0 : parseSizeValue(value);
+        } else if (directive == "trace") {
+            validateDirectiveValue(directive, value);
+            serverConfig.traceSample = (value == "off") ? 0 : std::atoi(value.c_str());
+        } else if (directive == "large_client_header_buffers") {
+            validateDirectiveValue(directive, value);
+            std::istringstream valueStream(value);
+            std::string number, size;
+            valueStream >> number >> size;
+            serverConfig.largeClientHeaderBuffers = std::atoi(number.c_str());
+            serverConfig.largeClientHeaderBufferSize = parseSizeValue(size);
 	} else {
             throw ConfigParserException("Unknown directive: \"" + directive + "\"");
         }
@@ -225,6 +363,122 @@ void ConfigParser::processServerDirective(std::ifstream &file, const std::string
     }
 }
 
+// listen [address:]port [default_server] [backlog=N] [reuseport] [deferred[=N]] [fastopen=N];
+ListenDirective ConfigParser::parseListenDirective(const std::string &value) {
+    std::istringstream valueStream(value);
+    std::string address;
+    valueStream >> address;
+    validateDirectiveValue("listen", address);
+
+    ListenDirective listen;
+    size_t colonPos = address.rfind(':');
+    if (address[0] == '[') {
+        size_t closingPos = address.find(']');
+        listen.host = address.substr(1, closingPos - 1);
+        listen.port = std::atoi(address.substr(closingPos + 2).c_str());
+    } else if (colonPos != std::string::npos) {
+        listen.host = address.substr(0, colonPos);
+        listen.port = std::atoi(address.substr(colonPos + 1).c_str());
+    } else {
+        listen.port = std::atoi(address.c_str());
+    }
+    if (listen.host == "*") {
+        listen.host = "";
+    }
+
+    std::string option;
+    while (valueStream >> option) {
+        std::string name = option.substr(0, option.find('='));
+        std::string arg = (option.find('=') != std::string::npos) ? option.substr(option.find('=') + 1) : "";
+        if (name == "default_server") {
+            listen.defaultServer = true;
+            continue;
+        }
+        listen.hasOptions = true;
+        if (name == "backlog") {
+            listen.backlog = std::atoi(arg.c_str());
+            if (arg.empty() || listen.backlog <= 0) {
+                throw ConfigParserException("Invalid listen backlog: " + option);
+            }
+        } else if (name == "reuseport") {
+            listen.reusePort = true;
+        } else if (name == "deferred") {
+            listen.deferAccept = arg.empty() ? 1 : std::atoi(arg.c_str());
+            if (listen.deferAccept <= 0) {
+                throw ConfigParserException("Invalid listen deferred timeout: " + option);
+            }
+        } else if (name == "fastopen") {
+            listen.fastOpen = std::atoi(arg.c_str());
+            if (arg.empty() || listen.fastOpen <= 0) {
+                throw ConfigParserException("Invalid listen fastopen queue length: " + option);
+            }
+        } else {
+            throw ConfigParserException("Unknown listen option: " + option);
+        }
+    }
+    return listen;
+}
+
+// Duree "30", "30s", "500ms" ou "1m" (sans unite : secondes) ; retourne des ms, -1 si invalide
+int ConfigParser::parseTimeValue(const std::string &value) {
+    size_t digits = 0;
+    while (digits < value.size() && isdigit(value[digits])) {
+        ++digits;
+    }
+    if (digits == 0 || digits > 6) {
+        return -1;
+    }
+    int amount = std::atoi(value.substr(0, digits).c_str());
+    std::string unit = value.substr(digits);
+    if (unit.empty() || unit == "s") {
+        return amount * 1000;
+    } else if (unit == "ms") {
+        return amount;
+    } else if (unit == "m" && amount <= 60 * 24) {
+        return amount * 60 * 1000;
+    }
+    return -1;
+}
+
+// Taille "1024", "8k" ou "1m" ; retourne des octets, -1 si invalide
+int ConfigParser::parseSizeValue(const std::string &value) {
+    size_t digits = 0;
+    while (digits < value.size() && isdigit(value[digits])) {
+        ++digits;
+    }
+    if (digits == 0 || digits > 7) {
+        return -1;
+    }
+    int amount = std::atoi(value.substr(0, digits).c_str());
+    std::string unit = value.substr(digits);
+    if (unit.empty()) {
+        return amount;
+    } else if ((unit == "k" || unit == "K") && amount <= 1024 * 1024) {
+        return amount * 1024;
+    } else if ((unit == "m" || unit == "M") && amount <= 1024) {
+        return amount * 1024 * 1024;
+    }
+    return -1;
+}
+
+// types { type ext ext; ... } : complete (ou remplace extension par extension) les types par defaut
+void ConfigParser::processTypesBlock(std::ifstream &file, ServerConfig& serverConfig) {
+    std::string line;
+    while (std::getline(file, line)) {
+        trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        if (line == "}") {
+            return;
+        }
+        if (line[line.size() - 1] != ';' || !serverConfig.mimeTypes.addLine(line)) {
+            throw ConfigParserException("Invalid entry in 'types' block: \"" + line + "\"");
+        }
+    }
+    throw ConfigParserException("Missing '}' at end of 'types' block");
+}
+
 void ConfigParser::processLocationBlock(std::ifstream &file, const std::string& locationPath, ServerConfig& serverConfig) {
     Location location;
     location.path = locationPath;
@@ -300,6 +554,12 @@ void ConfigParser::processLocationBlock(std::ifstream &file, const std::string&
                 validateDirectiveValue(directive, value);
                 location.autoindex = (value == "on");
                 Logger::instance().log(DEBUG, "Set autoindex to " + value + " in location " + location.path);
+            } else if (directive == "autoindex_format") {
+                validateDirectiveValue(directive, value);
+                location.autoindexFormat = value;
+            } else if (directive == "stub_status") {
+                validateDirectiveValue(directive, value);
+                location.stubStatus = (value == "on");
             } else {
                 location.options[directive] = value;
             }
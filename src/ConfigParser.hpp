@@ -3,6 +3,7 @@
 #define CONFIGPARSER_HPP
 
 #include "ServerConfig.hpp"
+#include "ListenDirective.hpp"
 #include "Logger.hpp"
 #include <vector>
 #include <string>
@@ -10,6 +11,8 @@
 #include <fstream>
 #include <stdexcept>
 
+#define WORKER_CONNECTIONS_DEFAULT 1024 // Connexions client simultanees sans bloc events
+
 class ConfigParserException : public std::exception {
 public:
     ConfigParserException(const std::string& message) : _message(message) {}
@@ -29,14 +32,28 @@ public:
     void parseConfigFile(const std::string &filename);
 
     const std::vector<ServerConfig>& getServerConfigs() const;
+    // Bloc `events { worker_connections N; }`, commun a tous les servers
+    int getWorkerConnections() const;
 
 private:
     std::vector<ServerConfig> _serverConfigs;
+    int _workerConnections;
+    bool _eventsSeen;
 
     void processServerDirective(std::ifstream &file, const std::string &line, ServerConfig &serverConfig);
 
     void processLocationBlock(std::ifstream &file, const std::string& locationPath, ServerConfig& serverConfig);
 
+    void processTypesBlock(std::ifstream &file, ServerConfig& serverConfig);
+
+    void processEventsBlock(std::ifstream &file);
+
+    ListenDirective parseListenDirective(const std::string &value);
+
+    int parseTimeValue(const std::string &value);
+
+    int parseSizeValue(const std::string &value);
+
     void validateDirectiveValue(const std::string &directive, const std::string &value);
 
     void trim(std::string &s);
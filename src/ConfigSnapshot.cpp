@@ -0,0 +1,172 @@
+// ConfigSnapshot.cpp
+#include "ConfigSnapshot.hpp"
+#include "ConfigParser.hpp"
+#include "Listener.hpp"
+#include "Server.hpp"
+#include "Logger.hpp"
+#include "Utils.hpp"
+
+unsigned long ConfigSnapshot::_nextGeneration = 1;
+
+ConfigSnapshot* ConfigSnapshot::load(const std::string& configFile) {
+    ConfigParser configParser;
+    configParser.parseConfigFile(configFile);
+
+    const std::vector<ServerConfig>& configs = configParser.getServerConfigs();
+    if (configs.empty()) {
+        throw ConfigParserException("No server block in " + configFile);
+    }
+    for (size_t i = 0; i < configs.size(); ++i) {
+        if (!configs[i].isValid()) {
+            throw ConfigParserException("Invalid server block #" + to_string(i + 1) + " in " + configFile);
+        }
+    }
+
+    ConfigSnapshot* snapshot = new ConfigSnapshot(configFile, configs, configParser.getWorkerConnections());
+    snapshot->build();
+    return snapshot;
+}
+
+ConfigSnapshot::ConfigSnapshot(const std::string& configFile, const std::vector<ServerConfig>& configs, int workerConnections)
+    : _configFile(configFile), _configs(configs), _generation(_nextGeneration++), _workerConnections(workerConnections), _refCount(1) {}
+
+ConfigSnapshot::~ConfigSnapshot() {
+    for (size_t i = 0; i < _servers.size(); ++i) {
+        delete _servers[i];
+    }
+    Logger::instance().log(DEBUG, "Configuration snapshot #" + to_string(_generation) + " released");
+}
+
+void ConfigSnapshot::build() {
+    // _configs n'est plus modifie : les Server peuvent garder une reference dessus
+    for (size_t i = 0; i < _configs.size(); ++i) {
+        Server* server = new Server(_configs[i]);
+        _servers.push_back(server);
+
+        const std::vector<ListenDirective>& listens = _configs[i].listens;
+        for (size_t j = 0; j < listens.size(); ++j) {
+            ListenDirective listen = listens[j];
+            std::string key = Listener::makeKey(listen);
+            std::map<std::string, ListenDirective>::iterator found = _listens.find(key);
+            if (found == _listens.end()) {
+                _listens[key] = listen;
+            } else if (listen.hasOptions) {
+                // Les options de socket ne peuvent etre donnees qu'une fois par address:port
+                if (found->second.hasOptions) {
+                    Logger::instance().log(WARNING, "Duplicate listen options for " + key + ", ignored");
+                } else {
+                    found->second = listen;
+                }
+            }
+            _vhosts[key].addServer(server, _configs[i].serverNames, listens[j].defaultServer);
+        }
+    }
+
+    for (std::map<std::string, VirtualHostTable>::iterator it = _vhosts.begin(); it != _vhosts.end(); ++it) {
+        it->second.build();
+    }
+    Logger::instance().log(INFO, "Configuration snapshot #" + to_string(_generation) + " built: "
+        + to_string(_servers.size()) + " servers, " + to_string(_listens.size()) + " listeners");
+}
+
+void ConfigSnapshot::retain() {
+    ++_refCount;
+}
+
+void ConfigSnapshot::release() {
+    if (--_refCount == 0) {
+        delete this;
+    }
+}
+
+const std::map<std::string, ListenDirective>& ConfigSnapshot::getListens() const {
+    return _listens;
+}
+
+Server* ConfigSnapshot::route(const std::string& listenKey, HTTPRequest& request) const {
+    if (!request.getHeadersParsed()) {
+        request.parseRawRequest();
+        if (!request.getHeadersParsed()) {
+            return NULL;
+        }
+    }
+    std::map<std::string, VirtualHostTable>::const_iterator it = _vhosts.find(listenKey);
+    if (it == _vhosts.end()) {
+        return NULL;
+    }
+    Server* server = it->second.resolve(request.getHost());
+    request.applyBodyLimit(server->getConfig());
+    return server;
+}
+
+Server* ConfigSnapshot::getDefaultServer(const std::string& listenKey) const {
+    std::map<std::string, VirtualHostTable>::const_iterator it = _vhosts.find(listenKey);
+    if (it == _vhosts.end()) {
+        return _servers.empty() ? NULL : _servers[0];
+    }
+    return it->second.getDefaultServer();
+}
+
+const std::vector<ServerConfig>& ConfigSnapshot::getServerConfigs() const {
+    return _configs;
+}
+
+const std::string& ConfigSnapshot::getConfigFile() const {
+    return _configFile;
+}
+
+unsigned long ConfigSnapshot::getGeneration() const {
+    return _generation;
+}
+
+int ConfigSnapshot::getWorkerConnections() const {
+    return _workerConnections;
+}
+
+ConfigSnapshotJob::ConfigSnapshotJob(const std::string& configFile)
+    : DiskJob(-1, 0), _configFile(configFile), _snapshot(NULL) {}
+
+ConfigSnapshotJob::~ConfigSnapshotJob() {
+    if (_snapshot != NULL) {
+        _snapshot->release(); // Job abandonne (arret pendant le reload)
+    }
+}
+
+// Thread du pool : le Logger n'est pas partage, ses messages sont retenus dans _logs
+void ConfigSnapshotJob::run() {
+    Logger::instance().capture(&_logs);
+    try {
+        _snapshot = ConfigSnapshot::load(_configFile);
+    } catch (const std::exception& e) {
+        _error = e.what();
+    }
+    Logger::instance().capture(NULL);
+}
+
+void ConfigSnapshotJob::finish(Server& server, int clientFd, HTTPRequest& request, ResponseWriter& output) {
+    (void)server;
+    (void)clientFd;
+    (void)request;
+    (void)output;
+}
+
+void ConfigSnapshotJob::replayLogs() {
+    for (size_t i = 0; i < _logs.size(); ++i) {
+        Logger::instance().log(_logs[i].first, _logs[i].second);
+    }
+    _logs.clear();
+}
+
+ConfigSnapshot* ConfigSnapshotJob::takeSnapshot() {
+    ConfigSnapshot* snapshot = _snapshot;
+    _snapshot = NULL;
+    return snapshot;
+}
+
+const std::string& ConfigSnapshotJob::getConfigFile() const {
+    return _configFile;
+}
+
+const std::string& ConfigSnapshotJob::getError() const {
+    return _error;
+}
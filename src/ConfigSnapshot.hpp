@@ -0,0 +1,96 @@
+// ConfigSnapshot.hpp
+#ifndef CONFIGSNAPSHOT_HPP
+#define CONFIGSNAPSHOT_HPP
+
+#include "ServerConfig.hpp"
+#include "ListenDirective.hpp"
+#include "VirtualHostTable.hpp"
+#include "HTTPRequest.hpp"
+#include "DiskPool.hpp"
+#include "Logger.hpp"
+#include <string>
+#include <vector>
+#include <map>
+
+class Server;
+
+/*
+ * Etat immuable issu d'un fichier de configuration : les ServerConfig,
+ * les Server construits dessus et la table Host -> Server de chaque
+ * listener. Compte de references intrusif : la boucle principale garde
+ * une reference sur le snapshot courant, chaque connexion sur celui qui
+ * etait courant a son accept. Un reload (SIGHUP) remplace le snapshot
+ * courant, les connexions en cours terminent sur l'ancien.
+ * Construit par un ConfigSnapshotJob sur un thread du DiskPool, puis
+ * manipule uniquement depuis la boucle d'evenements (mono-thread).
+ */
+class ConfigSnapshot {
+public:
+    // Parse et valide ; leve ConfigParserException en cas d'erreur
+    static ConfigSnapshot* load(const std::string& configFile);
+
+    void retain();
+    void release();
+
+    // Une directive par address:port distinct (la premiere qui porte des options)
+    const std::map<std::string, ListenDirective>& getListens() const;
+
+    // Parse les headers bruts et choisit le server ; NULL tant que les headers sont incomplets
+    Server* route(const std::string& listenKey, HTTPRequest& request) const;
+    Server* getDefaultServer(const std::string& listenKey) const;
+
+    const std::vector<ServerConfig>& getServerConfigs() const;
+    const std::string& getConfigFile() const;
+    unsigned long getGeneration() const;
+    // Plafond de connexions client ouvertes (events { worker_connections })
+    int getWorkerConnections() const;
+
+private:
+    ConfigSnapshot(const std::string& configFile, const std::vector<ServerConfig>& configs, int workerConnections);
+    ~ConfigSnapshot();
+    ConfigSnapshot(const ConfigSnapshot&);
+    ConfigSnapshot& operator=(const ConfigSnapshot&);
+
+    void build();
+
+    std::string _configFile;
+    std::vector<ServerConfig> _configs;
+    std::vector<Server*> _servers;
+    std::map<std::string, ListenDirective> _listens;
+    std::map<std::string, VirtualHostTable> _vhosts;
+    unsigned long _generation;
+    int _workerConnections;
+    int _refCount;
+
+    static unsigned long _nextGeneration; // Un seul chargement a la fois (demarrage, puis un job de reload)
+};
+
+/*
+ * Reload hors de la boucle : parsing, types_file, pages d'erreur et
+ * resolution des listen (getaddrinfo) sur un thread du pool. Les messages
+ * du Logger sont captures puis rejoues par le thread principal, qui bascule
+ * ensuite le snapshot courant.
+ */
+class ConfigSnapshotJob : public DiskJob {
+public:
+    explicit ConfigSnapshotJob(const std::string& configFile);
+    virtual ~ConfigSnapshotJob();
+
+    virtual void run();
+    virtual void finish(Server& server, int clientFd, HTTPRequest& request, ResponseWriter& output);
+
+    // Thread principal, apres collect() : ecrit les messages captures pendant run()
+    void replayLogs();
+    // Snapshot construit (l'appelant en prend la reference), NULL si le chargement a echoue
+    ConfigSnapshot* takeSnapshot();
+    const std::string& getConfigFile() const;
+    const std::string& getError() const;
+
+private:
+    std::string _configFile;
+    ConfigSnapshot* _snapshot;
+    std::string _error;
+    Logger::Captured _logs;
+};
+
+#endif
@@ -0,0 +1,88 @@
+// ConnectionTable.cpp
+#include "ConnectionTable.hpp"
+
+ConnectionTable::ConnectionTable() : _freeHead(-1), _count(0) {}
+
+ConnectionTable::~ConnectionTable() {
+    for (size_t i = 0; i < _pages.size(); ++i) {
+        delete[] _pages[i];
+    }
+}
+
+void ConnectionTable::grow() {
+    Connection* page = new Connection[CONNECTION_PAGE_SIZE];
+    int base = static_cast<int>(_pages.size() * CONNECTION_PAGE_SIZE);
+    _pages.push_back(page);
+    // Chainage a l'envers : le premier slot de la page sort en premier
+    for (int i = CONNECTION_PAGE_SIZE - 1; i >= 0; --i) {
+        page[i].slot = base + i;
+        page[i].nextFree = _freeHead;
+        _freeHead = base + i;
+    }
+}
+
+Connection* ConnectionTable::acquire(int fd) {
+    if (fd < 0) {
+        return NULL;
+    }
+    if (_freeHead == -1) {
+        grow();
+    }
+    int index = _freeHead;
+    Connection* conn = slot(index);
+    _freeHead = conn->nextFree;
+
+    if (static_cast<size_t>(fd) >= _fdToSlot.size()) {
+        _fdToSlot.resize(fd + 1 + CONNECTION_PAGE_SIZE, -1);
+    }
+    _fdToSlot[fd] = index;
+
+    conn->fd = fd;
+    conn->inUse = true;
+    conn->nextFree = -1;
+    conn->timer.fd = fd;
+    ++_count;
+    return conn;
+}
+
+void ConnectionTable::release(Connection* conn) {
+    if (conn == NULL || !conn->inUse) {
+        return;
+    }
+    _fdToSlot[conn->fd] = -1;
+
+    conn->inUse = false;
+    conn->fd = -1;
+    conn->server = NULL;
+    conn->snapshot = NULL;
+    conn->listenKey.clear();
+    conn->request.reset(); // La capacite du buffer sert a la prochaine connexion du slot
+    conn->output.clear();
+    conn->timer = TimerNode();
+    conn->pollIndex = 0;
+    conn->requestAllocations = 0;
+    conn->trace = RequestTrace();
+    conn->peer.clear();
+    conn->nextFree = _freeHead;
+    _freeHead = conn->slot;
+    --_count;
+}
+
+Connection* ConnectionTable::get(int fd) const {
+    if (fd < 0 || static_cast<size_t>(fd) >= _fdToSlot.size() || _fdToSlot[fd] == -1) {
+        return NULL;
+    }
+    return slot(_fdToSlot[fd]);
+}
+
+size_t ConnectionTable::size() const {
+    return _count;
+}
+
+size_t ConnectionTable::capacity() const {
+    return _pages.size() * CONNECTION_PAGE_SIZE;
+}
+
+Connection* ConnectionTable::slot(size_t index) const {
+    return &_pages[index / CONNECTION_PAGE_SIZE][index % CONNECTION_PAGE_SIZE];
+}
@@ -0,0 +1,74 @@
+// ConnectionTable.hpp
+#ifndef CONNECTIONTABLE_HPP
+#define CONNECTIONTABLE_HPP
+
+#include "HTTPRequest.hpp"
+#include "TimerWheel.hpp"
+#include "ResponseWriter.hpp"
+#include "RequestTrace.hpp"
+#include <string>
+#include <vector>
+#include <cstddef>
+
+class Server;
+class ConfigSnapshot;
+
+#define CONNECTION_PAGE_SIZE 256 // Connexions allouees par page du slab
+
+// Etat complet d'une connexion client, reutilise d'un accept a l'autre
+struct Connection {
+    int fd;
+    bool inUse;
+    Server* server;           // NULL tant que le Host n'a pas ete resolu
+    ConfigSnapshot* snapshot; // Snapshot courant a l'accept, retenu jusqu'a la fermeture
+    std::string listenKey;
+    HTTPRequest request;
+    TimerNode timer;
+    ResponseWriter output;    // Reponse en cours d'envoi, reprise sur POLLOUT
+    size_t pollIndex;         // Position dans le tableau de poll()
+    unsigned long requestAllocations; // Allocations deja faites pour la requete en cours
+    RequestTrace trace;       // Horodatage de la requete en cours
+    std::string peer;         // Adresse du client, pour l'access log
+    int slot;                 // Index fixe dans le slab
+    int nextFree;
+
+    Connection() : fd(-1), inUse(false), server(NULL), snapshot(NULL), pollIndex(0), requestAllocations(0), slot(-1), nextFree(-1) {}
+};
+
+/*
+ * Slab de connexions : pages contigues de Connection (adresses stables,
+ * les TimerNode y sont embarques), recyclees par une free list LIFO pour
+ * reprendre les slots encore chauds en cache. La recherche par fd est un
+ * simple index dans un tableau plat fd -> slot.
+ * Fermer le fd et rendre le snapshot reste a la charge de l'appelant.
+ */
+class ConnectionTable {
+public:
+    ConnectionTable();
+    ~ConnectionTable();
+
+    Connection* acquire(int fd);
+    void release(Connection* conn);
+
+    // NULL si le fd n'est pas une connexion client ; une reponse differee se valide
+    // par son ticket (ResponseWriter::awaiting), le fd pouvant avoir ete reutilise
+    Connection* get(int fd) const;
+
+    size_t size() const;
+    // Parcours des slots (drain, arret) : capacity() slots, inUse a verifier
+    size_t capacity() const;
+    Connection* slot(size_t index) const;
+
+private:
+    ConnectionTable(const ConnectionTable&);
+    ConnectionTable& operator=(const ConnectionTable&);
+
+    void grow();
+
+    std::vector<Connection*> _pages;
+    std::vector<int> _fdToSlot; // -1 : fd inconnu
+    int _freeHead;
+    size_t _count;
+};
+
+#endif
@@ -0,0 +1,38 @@
+// DeleteHandler.cpp
+#include "DeleteHandler.hpp"
+#include "FsStats.hpp"
+#include "Server.hpp"
+#include <unistd.h>
+#include <cerrno>
+
+DeleteHandler::DeleteHandler(int clientFd, unsigned long ticket, const std::string& path)
+    : DiskJob(clientFd, ticket), _path(path), _found(false), _error(0) {}
+
+DeleteHandler::~DeleteHandler() {}
+
+// Thread du pool : pas de Logger
+void DeleteHandler::run() {
+    if (FsStats::access(_path.c_str(), F_OK) == -1) {
+        return;
+    }
+    _found = true;
+    if (FsStats::remove(_path.c_str()) != 0) {
+        _error = errno;
+    }
+}
+
+void DeleteHandler::finish(Server& server, int clientFd, HTTPRequest& request, ResponseWriter& output) {
+    server.completeDelete(clientFd, request, *this, output);
+}
+
+const std::string& DeleteHandler::path() const {
+    return _path;
+}
+
+bool DeleteHandler::found() const {
+    return _found;
+}
+
+int DeleteHandler::error() const {
+    return _error;
+}
@@ -0,0 +1,31 @@
+// DeleteHandler.hpp
+#ifndef DELETEHANDLER_HPP
+#define DELETEHANDLER_HPP
+
+#include "DiskPool.hpp"
+#include <string>
+
+/*
+ * DELETE sur un thread du DiskPool : access() puis remove(), qui peuvent
+ * bloquer longtemps sur un systeme de fichiers reseau. La reponse part
+ * de Server::completeDelete() une fois le job termine.
+ */
+class DeleteHandler : public DiskJob {
+public:
+    DeleteHandler(int clientFd, unsigned long ticket, const std::string& path);
+    ~DeleteHandler();
+
+    virtual void run();
+    virtual void finish(Server& server, int clientFd, HTTPRequest& request, ResponseWriter& output);
+
+    const std::string& path() const;
+    bool found() const;
+    int error() const; // errno de remove(), 0 si supprime
+
+private:
+    std::string _path;
+    bool _found;
+    int _error;
+};
+
+#endif
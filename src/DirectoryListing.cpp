@@ -0,0 +1,301 @@
+// DirectoryListing.cpp
+#include "DirectoryListing.hpp"
+#include "Logger.hpp"
+#include "Utils.hpp"
+#include "FsStats.hpp"
+#include "Metrics.hpp"
+#include <algorithm>
+#include <dirent.h>
+#include <fcntl.h>
+#include <cctype>
+
+// Repertoires d'abord, puis la colonne demandee ; le nom departage
+struct EntryOrder {
+    char column;
+    bool descending;
+
+    EntryOrder(char column, bool descending) : column(column), descending(descending) {}
+
+    // Sur des pointeurs : le tri ne copie pas les noms
+    template <typename Entry>
+    bool operator()(const Entry* a, const Entry* b) const {
+        if (a->isDirectory != b->isDirectory) {
+            return a->isDirectory;
+        }
+        int order = 0;
+        if (column == 'S' && a->size != b->size) {
+            order = (a->size < b->size) ? -1 : 1;
+        } else if (column == 'M' && a->mtime != b->mtime) {
+            order = (a->mtime < b->mtime) ? -1 : 1;
+        } else {
+            order = a->name.compare(b->name);
+        }
+        return descending ? (order > 0) : (order < 0);
+    }
+};
+
+static void appendNumber(std::string& out, unsigned long value) {
+    char digits[24];
+    size_t count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (count > 0) {
+        out += digits[--count];
+    }
+}
+
+static void appendTime(std::string& out, time_t value, const char* format) {
+    struct tm utc;
+    char buffer[64];
+    gmtime_r(&value, &utc);
+    size_t length = std::strftime(buffer, sizeof(buffer), format, &utc);
+    out.append(buffer, length);
+}
+
+static void appendHtml(std::string& out, const std::string& text) {
+    for (size_t i = 0; i < text.size(); ++i) {
+        switch (text[i]) {
+            case '&': out += "&amp;"; break;
+            case '<': out += "&lt;"; break;
+            case '>': out += "&gt;"; break;
+            case '"': out += "&quot;"; break;
+            default: out += text[i];
+        }
+    }
+}
+
+// Segment d'URL : tout ce qui n'est pas non reserve (RFC 3986) est encode
+static void appendUrl(std::string& out, const std::string& text) {
+    static const char hex[] = "0123456789ABCDEF";
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (isalnum(c) || c == '-' || c == '.' || c == '_' || c == '~' || c == '/') {
+            out += static_cast<char>(c);
+        } else {
+            out += '%';
+            out += hex[c >> 4];
+            out += hex[c & 0x0F];
+        }
+    }
+}
+
+static void appendJson(std::string& out, const std::string& text) {
+    static const char hex[] = "0123456789abcdef";
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if (c < 0x20) {
+            out += "\\u00";
+            out += hex[c >> 4];
+            out += hex[c & 0x0F];
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+}
+
+// Valeur d'un parametre "C=..." ou "O=..." du query string (separateurs '&' ou ';')
+static char queryFlag(const std::string& query, char name, char fallback) {
+    for (size_t i = 0; i + 2 < query.size(); ++i) {
+        if ((i == 0 || query[i - 1] == '&' || query[i - 1] == ';') && query[i] == name && query[i + 1] == '=') {
+            return query[i + 2];
+        }
+    }
+    return fallback;
+}
+
+DirectoryListing::DirectoryListing() : _clock(0) {}
+
+DirectoryListing::~DirectoryListing() {
+    for (std::map<std::string, Directory>::iterator it = _directories.begin(); it != _directories.end(); ++it) {
+        dropPages(it->second);
+    }
+}
+
+void DirectoryListing::dropPages(Directory& directory) {
+    for (std::map<int, SharedBuffer*>::iterator it = directory.pages.begin(); it != directory.pages.end(); ++it) {
+        it->second->release(); // Les envois en cours gardent leur reference
+    }
+    directory.pages.clear();
+}
+
+// Le moins recemment servi laisse sa place
+void DirectoryListing::evict() {
+    std::map<std::string, Directory>::iterator oldest = _directories.begin();
+    for (std::map<std::string, Directory>::iterator it = _directories.begin(); it != _directories.end(); ++it) {
+        if (it->second.lastUse < oldest->second.lastUse) {
+            oldest = it;
+        }
+    }
+    dropPages(oldest->second);
+    _directories.erase(oldest);
+}
+
+// Un seul open() du repertoire ; les entrees sont resolues relativement a lui (fstatat), sans
+// reconstruire de chemin complet. d_type sert de repli si fstatat echoue (lien casse, course).
+bool DirectoryListing::scan(const std::string& directoryPath, std::vector<Entry>& entries) {
+    FsTimer timer(FS_OPENDIR); // Lecture complete, fstatat compris
+    int fd = open(directoryPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    DIR* dir = fdopendir(fd);
+    if (dir == NULL) {
+        close(fd);
+        return false;
+    }
+    entries.clear();
+    struct dirent* dirent;
+    while ((dirent = readdir(dir)) != NULL) {
+        const char* name = dirent->d_name;
+        // Ignorer les entrées spéciales "." et ".."
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+        Entry entry;
+        entry.name = name;
+        entry.isDirectory = (dirent->d_type == DT_DIR);
+        entry.size = 0;
+        entry.mtime = 0;
+        struct stat st;
+        if (fstatat(fd, name, &st, 0) == 0) {
+            entry.isDirectory = S_ISDIR(st.st_mode); // Suit les liens, comme le ferait la requete
+            entry.size = st.st_size;
+            entry.mtime = st.st_mtime;
+        }
+        entries.push_back(entry);
+    }
+    closedir(dir); // Ferme aussi fd
+    return true;
+}
+
+void DirectoryListing::render(const Directory& directory, ListingFormat format, char column, bool descending, std::string& out) {
+    std::vector<const Entry*> sorted;
+    sorted.reserve(directory.entries.size());
+    for (size_t i = 0; i < directory.entries.size(); ++i) {
+        sorted.push_back(&directory.entries[i]);
+    }
+    std::sort(sorted.begin(), sorted.end(), EntryOrder(column, descending));
+
+    if (format == LISTING_JSON) {
+        // Meme forme que l'autoindex_format json de nginx
+        out.reserve(64 + sorted.size() * 96);
+        out += "[\n";
+        for (size_t i = 0; i < sorted.size(); ++i) {
+            const Entry& entry = *sorted[i];
+            out += "{ \"name\":\"";
+            appendJson(out, entry.name);
+            out += entry.isDirectory ? "\", \"type\":\"directory\", \"mtime\":\"" : "\", \"type\":\"file\", \"mtime\":\"";
+            appendTime(out, entry.mtime, "%a, %d %b %Y %H:%M:%S GMT");
+            out += '"';
+            if (!entry.isDirectory) {
+                out += ", \"size\":";
+                appendNumber(out, static_cast<unsigned long>(entry.size));
+            }
+            out += (i + 1 < sorted.size()) ? " },\n" : " }\n";
+        }
+        out += "]\n";
+        return;
+    }
+
+    out.reserve(512 + sorted.size() * (128 + 2 * directory.prefix.size()));
+    out += "<html><head><title>Index of ";
+    appendHtml(out, directory.prefix);
+    out += "</title></head><body><h1>Index of ";
+    appendHtml(out, directory.prefix);
+    out += "</h1><table><tr>";
+    // Un clic sur la colonne deja triee inverse l'ordre
+    static const char columns[] = { 'N', 'M', 'S' };
+    static const char* titles[] = { "Name", "Last modified", "Size" };
+    for (size_t c = 0; c < 3; ++c) {
+        out += "<th><a href=\"?C=";
+        out += columns[c];
+        out += (columns[c] == column && !descending) ? "&amp;O=D\">" : "&amp;O=A\">";
+        out += titles[c];
+        out += "</a></th>";
+    }
+    out += "</tr>";
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        const Entry& entry = *sorted[i];
+        out += "<tr><td><a href=\"";
+        appendUrl(out, directory.prefix);
+        appendUrl(out, entry.name);
+        if (entry.isDirectory) {
+            out += '/';
+        }
+        out += "\">";
+        appendHtml(out, entry.name);
+        if (entry.isDirectory) {
+            out += '/';
+        }
+        out += "</a></td><td>";
+        appendTime(out, entry.mtime, "%d-%b-%Y %H:%M");
+        out += "</td><td>";
+        if (entry.isDirectory) {
+            out += '-';
+        } else {
+            appendNumber(out, static_cast<unsigned long>(entry.size));
+        }
+        out += "</td></tr>";
+    }
+    out += "</table></body></html>";
+}
+
+SharedBuffer* DirectoryListing::page(const std::string& directoryPath, const struct stat& directoryStat,
+                                     const std::string& requestPath, const std::string& query, ListingFormat format) {
+    std::map<std::string, Directory>::iterator it = _directories.find(directoryPath);
+    bool changed = (it == _directories.end()
+        || it->second.inode != directoryStat.st_ino
+        || it->second.mtime.tv_sec != directoryStat.st_mtim.tv_sec
+        || it->second.mtime.tv_nsec != directoryStat.st_mtim.tv_nsec);
+    if (changed) {
+        std::vector<Entry> entries;
+        if (!scan(directoryPath, entries)) {
+            Logger::instance().log(ERROR, "Failed to open directory: " + directoryPath);
+            return NULL;
+        }
+        if (it == _directories.end()) {
+            if (_directories.size() >= LISTING_CACHE_MAX) {
+                evict();
+            }
+            it = _directories.insert(std::make_pair(directoryPath, Directory())).first;
+        }
+        Directory& directory = it->second;
+        dropPages(directory);
+        directory.entries.swap(entries);
+        directory.mtime = directoryStat.st_mtim;
+        directory.inode = directoryStat.st_ino;
+        Logger::instance().log(DEBUG, "Directory listing cached for " + directoryPath + " (" + to_string(directory.entries.size()) + " entries)");
+    }
+    Directory& directory = it->second;
+    directory.lastUse = ++_clock;
+
+    std::string prefix = requestPath;
+    if (prefix.empty() || prefix[prefix.size() - 1] != '/') {
+        prefix += '/';
+    }
+    if (prefix != directory.prefix) {
+        dropPages(directory); // Liens a refaire, les entrees restent valables
+        directory.prefix = prefix;
+    }
+
+    char column = queryFlag(query, 'C', 'N');
+    if (column != 'M' && column != 'S') {
+        column = 'N';
+    }
+    bool descending = (queryFlag(query, 'O', 'A') == 'D');
+    int variant = static_cast<int>(format) * 256 + column * 2 + (descending ? 1 : 0);
+    std::map<int, SharedBuffer*>::iterator cached = directory.pages.find(variant);
+    Metrics::cacheLookup(CACHE_LISTING, cached != directory.pages.end());
+    if (cached == directory.pages.end()) {
+        SharedBuffer* rendered = new SharedBuffer();
+        render(directory, format, column, descending, rendered->data);
+        cached = directory.pages.insert(std::make_pair(variant, rendered)).first;
+    }
+    cached->second->retain();
+    return cached->second;
+}
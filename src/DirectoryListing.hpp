@@ -0,0 +1,64 @@
+// DirectoryListing.hpp
+#ifndef DIRECTORYLISTING_HPP
+#define DIRECTORYLISTING_HPP
+
+#include "ResponseBody.hpp"
+#include <string>
+#include <vector>
+#include <map>
+#include <sys/stat.h>
+#include <ctime>
+
+#define LISTING_CACHE_MAX 64 // Repertoires gardes par server
+
+enum ListingFormat { LISTING_HTML, LISTING_JSON };
+
+/*
+ * Cache des listings autoindex d'un server. Les entrees d'un repertoire
+ * (d_type, puis fstatat relatif au repertoire pour taille et date) sont
+ * relues seulement quand son mtime change ; chaque variante (format, tri)
+ * est rendue une fois puis envoyee depuis la memoire du cache.
+ * Le mtime d'un repertoire ne bouge pas quand un fichier est reecrit sur
+ * place : taille et date peuvent alors rester anciennes jusqu'au prochain
+ * ajout ou retrait.
+ */
+class DirectoryListing {
+public:
+    DirectoryListing();
+    ~DirectoryListing();
+
+    // Page retenue pour l'appelant (a rendre par release()), NULL si le repertoire ne peut pas etre lu.
+    // `query` : tri facon Apache, C=N|M|S (nom, date, taille) et O=A|D
+    SharedBuffer* page(const std::string& directoryPath, const struct stat& directoryStat,
+                       const std::string& requestPath, const std::string& query, ListingFormat format);
+
+private:
+    DirectoryListing(const DirectoryListing&);
+    DirectoryListing& operator=(const DirectoryListing&);
+
+    struct Entry {
+        std::string name;
+        bool isDirectory;
+        off_t size;
+        time_t mtime;
+    };
+
+    struct Directory {
+        struct timespec mtime;
+        ino_t inode;
+        std::string prefix; // Chemin de requete avec '/' final, base des liens
+        std::vector<Entry> entries;
+        std::map<int, SharedBuffer*> pages; // Par variante format/tri
+        unsigned long lastUse;
+    };
+
+    static bool scan(const std::string& directoryPath, std::vector<Entry>& entries);
+    static void render(const Directory& directory, ListingFormat format, char column, bool descending, std::string& out);
+    static void dropPages(Directory& directory);
+    void evict();
+
+    std::map<std::string, Directory> _directories;
+    unsigned long _clock;
+};
+
+#endif
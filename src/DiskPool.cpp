@@ -0,0 +1,296 @@
+// DiskPool.cpp
+#include "DiskPool.hpp"
+#include "Logger.hpp"
+#include "Utils.hpp"
+#include "FsStats.hpp"
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <stdint.h>
+
+DiskJob::DiskJob(int clientFd, unsigned long ticket) : _clientFd(clientFd), _ticket(ticket), _submittedNs(0), _ringPending(0) {}
+
+DiskJob::~DiskJob() {}
+
+unsigned DiskJob::ringOps() const {
+    return 0;
+}
+
+unsigned DiskJob::ringFiles() const {
+    return 0;
+}
+
+void DiskJob::prepareRing(DiskPool& pool) {
+    (void)pool;
+}
+
+void DiskJob::ringResult(unsigned step, int result) {
+    (void)step;
+    (void)result;
+}
+
+void DiskJob::finishDetached() {}
+
+int DiskJob::clientFd() const {
+    return _clientFd;
+}
+
+unsigned long DiskJob::ticket() const {
+    return _ticket;
+}
+
+const std::string& DiskJob::serialKey() const {
+    return _serialKey;
+}
+
+void DiskJob::serializeOn(const std::string& key) {
+    _serialKey = key;
+}
+
+DiskPool& DiskPool::instance() {
+    static DiskPool pool;
+    return pool;
+}
+
+DiskPool::DiskPool() : _eventFd(-1), _stopping(false), _ringInflight(0) {
+    pthread_mutex_init(&_lock, NULL);
+    pthread_cond_init(&_ready, NULL);
+}
+
+DiskPool::~DiskPool() {
+    stop();
+    pthread_cond_destroy(&_ready);
+    pthread_mutex_destroy(&_lock);
+}
+
+bool DiskPool::start(int threads) {
+    if (_eventFd == -1) {
+        _eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (_eventFd == -1) {
+            Logger::instance().log(ERROR, std::string("Disk pool: eventfd failed: ") + strerror(errno));
+            return false;
+        }
+    }
+    _stopping = false;
+    for (int i = 0; i < threads; ++i) {
+        pthread_t thread;
+        int error = pthread_create(&thread, NULL, &DiskPool::workerMain, this);
+        if (error != 0) {
+            Logger::instance().log(ERROR, std::string("Disk pool: pthread_create failed: ") + strerror(error));
+            break;
+        }
+        _threads.push_back(thread);
+    }
+
+    const char* forced = std::getenv("WEBSERV_IO_URING");
+    if (!_ring.ready() && (forced == NULL || std::strcmp(forced, "off") != 0)) {
+        if (_ring.setup(IO_URING_ENTRIES, IO_URING_FILES, _eventFd)) {
+            // Au plus une completion par emplacement : la file de completion ne deborde pas
+            _ringOps.resize(_ring.cqEntries());
+            for (unsigned i = _ring.cqEntries(); i > 0; --i) {
+                _freeOps.push_back(i - 1);
+            }
+            for (unsigned i = IO_URING_FILES; i > 0; --i) {
+                _freeFiles.push_back(i - 1);
+            }
+        } else {
+            Logger::instance().log(WARNING, std::string("Disk pool: io_uring unavailable, using threads only: ") + strerror(errno));
+        }
+    }
+    Logger::instance().log(INFO, "Disk pool started with " + to_string(_threads.size()) + " threads"
+        + (_ring.ready() ? ", io_uring enabled" : ""));
+    return !_threads.empty() || _ring.ready();
+}
+
+void DiskPool::stop() {
+    pthread_mutex_lock(&_lock);
+    _stopping = true;
+    pthread_cond_broadcast(&_ready);
+    pthread_mutex_unlock(&_lock);
+    for (size_t i = 0; i < _threads.size(); ++i) {
+        pthread_join(_threads[i], NULL);
+    }
+    _threads.clear();
+
+    std::vector<DiskJob*> finished;
+    while (true) {
+        resumeRing();
+        if (_ringInflight == 0 || _ring.submit(1) == -1) {
+            break;
+        }
+        reapRing(finished); // Uploads deja soumis menes a terme
+    }
+    for (size_t i = 0; i < _ringWaiting.size(); ++i) {
+        delete _ringWaiting[i]; // Ring fermee en erreur
+    }
+    _ringWaiting.clear();
+    _ring.close();
+    for (size_t i = 0; i < finished.size(); ++i) {
+        delete finished[i];
+    }
+    for (size_t i = 0; i < _done.size(); ++i) {
+        if (_done[i]->clientFd() == -1) {
+            _done[i]->finishDetached(); // Compte rendu encore possible : stop() tourne sur le thread principal
+        }
+        delete _done[i]; // Plus personne pour les attendre
+    }
+    _done.clear();
+    if (_eventFd != -1) {
+        close(_eventFd);
+        _eventFd = -1;
+    }
+}
+
+bool DiskPool::submit(DiskJob* job) {
+    job->_submittedNs = FsStats::nowNs();
+    if (submitRing(job)) {
+        return true;
+    }
+    if (_threads.empty()) {
+        job->run(); // Repli : ecriture bloquante sur la boucle, comme avant le pool
+        complete(job);
+        return true;
+    }
+    pthread_mutex_lock(&_lock);
+    bool accepted = _queue.size() < DISK_POOL_QUEUE_MAX;
+    if (accepted) {
+        _queue.push_back(job);
+        pthread_cond_signal(&_ready);
+    }
+    pthread_mutex_unlock(&_lock);
+    return accepted;
+}
+
+// Tout ou rien : un job n'est jamais coupe entre la ring et un thread
+bool DiskPool::submitRing(DiskJob* job) {
+    unsigned ops = job->ringOps();
+    unsigned files = job->ringFiles();
+    if (ops == 0 || !_ring.ready() || _ring.sqSpace() < ops || _freeOps.size() < ops || _freeFiles.size() < files) {
+        return false;
+    }
+    job->_ringFiles.clear();
+    for (unsigned i = 0; i < files; ++i) {
+        job->_ringFiles.push_back(_freeFiles.back());
+        _freeFiles.pop_back();
+    }
+    job->_ringPending = ops;
+    job->prepareRing(*this);
+    return true;
+}
+
+struct io_uring_sqe* DiskPool::ringOp(DiskJob* job, unsigned step) {
+    unsigned index = _freeOps.back();
+    _freeOps.pop_back();
+    _ringOps[index].job = job;
+    _ringOps[index].step = step;
+    ++_ringInflight;
+    struct io_uring_sqe* sqe = _ring.sqe(); // Place verifiee par submitRing
+    sqe->user_data = index;
+    return sqe;
+}
+
+unsigned DiskPool::ringFile(const DiskJob* job, unsigned index) const {
+    return job->_ringFiles[index];
+}
+
+void DiskPool::resumeRing() {
+    while (!_ringWaiting.empty() && submitRing(_ringWaiting.front())) {
+        _ringWaiting.pop_front();
+    }
+}
+
+void DiskPool::flush() {
+    resumeRing();
+    if (_ring.ready() && _ring.submit() == -1) {
+        Logger::instance().log(ERROR, std::string("Disk pool: io_uring_enter failed: ") + strerror(errno));
+    }
+}
+
+int DiskPool::notifyFd() const {
+    return _eventFd;
+}
+
+void DiskPool::reapRing(std::vector<DiskJob*>& finished) {
+    unsigned long userData;
+    int result;
+    while (_ring.reap(userData, result)) {
+        RingOp& op = _ringOps[userData];
+        DiskJob* job = op.job;
+        job->ringResult(op.step, result);
+        _freeOps.push_back(static_cast<unsigned>(userData));
+        --_ringInflight;
+        if (--job->_ringPending == 0) {
+            for (size_t i = 0; i < job->_ringFiles.size(); ++i) {
+                _freeFiles.push_back(job->_ringFiles[i]);
+            }
+            job->_ringFiles.clear();
+            if (job->ringOps() > 0) {
+                _ringWaiting.push_back(job); // Reste a ecrire : soumis au prochain flush()
+                continue;
+            }
+            FsStats::record(FS_RING_JOB, FsStats::nowNs() - job->_submittedNs);
+            finished.push_back(job);
+        }
+    }
+}
+
+void DiskPool::collect(std::vector<DiskJob*>& finished) {
+    uint64_t count;
+    ssize_t drained = read(_eventFd, &count, sizeof(count));
+    (void)drained;
+    pthread_mutex_lock(&_lock);
+    finished.swap(_done);
+    _done.clear();
+    pthread_mutex_unlock(&_lock);
+    reapRing(finished);
+}
+
+void DiskPool::complete(DiskJob* job) {
+    pthread_mutex_lock(&_lock);
+    _done.push_back(job);
+    pthread_mutex_unlock(&_lock);
+    uint64_t one = 1;
+    // Compteur sature : un reveil est deja en attente
+    ssize_t written = write(_eventFd, &one, sizeof(one));
+    (void)written;
+}
+
+DiskJob* DiskPool::takeRunnable() {
+    for (std::deque<DiskJob*>::iterator it = _queue.begin(); it != _queue.end(); ++it) {
+        DiskJob* job = *it;
+        if (job->_serialKey.empty() || _busyKeys.insert(job->_serialKey).second) {
+            _queue.erase(it);
+            return job;
+        }
+    }
+    return NULL;
+}
+
+void* DiskPool::workerMain(void* arg) {
+    DiskPool* pool = static_cast<DiskPool*>(arg);
+    while (true) {
+        pthread_mutex_lock(&pool->_lock);
+        DiskJob* job = pool->takeRunnable();
+        while (job == NULL && !(pool->_queue.empty() && pool->_stopping)) {
+            pthread_cond_wait(&pool->_ready, &pool->_lock);
+            job = pool->takeRunnable();
+        }
+        pthread_mutex_unlock(&pool->_lock);
+        if (job == NULL) {
+            return NULL; // Arret, file videe
+        }
+        FsStats::record(FS_QUEUE_WAIT, FsStats::nowNs() - job->_submittedNs);
+
+        job->run();
+        if (!job->_serialKey.empty()) {
+            // Avant complete() : le job peut etre detruit des qu'il est rendu
+            pthread_mutex_lock(&pool->_lock);
+            pool->_busyKeys.erase(job->_serialKey);
+            pthread_cond_broadcast(&pool->_ready); // Le suivant de meme cle attend peut-etre
+            pthread_mutex_unlock(&pool->_lock);
+        }
+        pool->complete(job);
+    }
+}
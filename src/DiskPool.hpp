@@ -0,0 +1,139 @@
+// DiskPool.hpp
+#ifndef DISKPOOL_HPP
+#define DISKPOOL_HPP
+
+#include "IoUring.hpp"
+#include <pthread.h>
+#include <deque>
+#include <set>
+#include <string>
+#include <vector>
+
+#define DISK_POOL_THREADS 4
+#define DISK_POOL_QUEUE_MAX 1024 // Jobs en attente d'un thread ; au-dela submit() refuse
+
+class Server;
+class HTTPRequest;
+class ResponseWriter;
+class DiskPool;
+
+/*
+ * Travail disque execute hors de la boucle d'evenements. run() tourne sur
+ * un thread du pool : appels systeme seulement, ni Logger ni etat partage ;
+ * finish() est appele ensuite sur le thread principal si la connexion
+ * attend toujours ce job (meme fd, meme ticket de ResponseWriter::defer()).
+ * Un job peut aussi se decrire en operations io_uring (ringOps() > 0) :
+ * il ne passe alors par aucun thread. Sans connexion (clientFd -1),
+ * finishDetached() le remplace pour rendre compte sur le thread principal.
+ */
+class DiskJob {
+public:
+    DiskJob(int clientFd, unsigned long ticket);
+    virtual ~DiskJob();
+
+    virtual void run() = 0;
+    virtual void finish(Server& server, int clientFd, HTTPRequest& request, ResponseWriter& output) = 0;
+    // Job sans connexion, sur le thread principal une fois run() termine (erreur a logger...)
+    virtual void finishDetached();
+
+    // Chemin io_uring : SQE et descripteurs fixes necessaires, 0 si le job n'en a pas.
+    // Rappele une fois toutes les operations terminees : non nul, le job repart dans la ring
+    // pour ce qui reste (ecriture courte...).
+    virtual unsigned ringOps() const;
+    virtual unsigned ringFiles() const;
+    // Prepare exactement ringOps() SQE par pool.ringOp(this, step)
+    virtual void prepareRing(DiskPool& pool);
+    // cqe->res de l'operation `step`, sur le thread principal
+    virtual void ringResult(unsigned step, int result);
+
+    int clientFd() const;
+    unsigned long ticket() const;
+    const std::string& serialKey() const;
+
+protected:
+    // Les jobs d'une meme cle passent un par un, dans l'ordre de submit() (ex. ajouts a un meme fichier)
+    void serializeOn(const std::string& key);
+
+private:
+    DiskJob(const DiskJob&);
+    DiskJob& operator=(const DiskJob&);
+
+    friend class DiskPool;
+
+    int _clientFd;
+    unsigned long _ticket;
+    std::string _serialKey; // Vide : aucun ordre impose
+    unsigned long _submittedNs;
+    unsigned _ringPending;         // Operations io_uring pas encore terminees
+    std::vector<unsigned> _ringFiles; // Descripteurs fixes reserves au job
+};
+
+/*
+ * E/S disque hors de la boucle. Avec io_uring (noyau 5.19+, sauf
+ * WEBSERV_IO_URING=off), les jobs qui le permettent partent en SQE,
+ * soumises ensemble par flush() avant chaque poll() ; les autres, ou ceux
+ * qui ne tiennent plus dans la ring, vont aux threads. Toute completion
+ * est signalee par le meme eventfd, puis recuperee par collect() sur le
+ * thread principal. Sans thread (echec de start()), submit() execute sur place.
+ * La file des threads est bornee : un disque qui ne suit plus se traduit
+ * par des refus (503 cote appelant) plutot que par une memoire sans limite.
+ */
+class DiskPool {
+public:
+    static DiskPool& instance();
+
+    bool start(int threads);
+    // Termine les jobs en cours (threads et ring) puis joint les threads
+    void stop();
+
+    // Le pool prend possession du job jusqu'a collect() ; false si la file est pleine
+    // (le job reste a l'appelant)
+    bool submit(DiskJob* job);
+    // Un io_uring_enter pour les SQE preparees depuis le dernier appel
+    void flush();
+    // eventfd a surveiller dans poll(), -1 avant start()
+    int notifyFd() const;
+    void collect(std::vector<DiskJob*>& finished);
+
+    // Pour DiskJob::prepareRing : SQE de l'operation `step`, et descripteur fixe n° `index` du job
+    struct io_uring_sqe* ringOp(DiskJob* job, unsigned step);
+    unsigned ringFile(const DiskJob* job, unsigned index) const;
+
+private:
+    DiskPool();
+    ~DiskPool();
+    DiskPool(const DiskPool&);
+    DiskPool& operator=(const DiskPool&);
+
+    struct RingOp {
+        DiskJob* job;
+        unsigned step;
+    };
+
+    static void* workerMain(void* pool);
+    // Sous _lock : premier job de la file dont la cle n'est pas deja en cours, NULL sinon
+    DiskJob* takeRunnable();
+    void complete(DiskJob* job);
+    bool submitRing(DiskJob* job);
+    // Jobs de _ringWaiting remis dans la ring tant qu'il y a de la place
+    void resumeRing();
+    void reapRing(std::vector<DiskJob*>& finished);
+
+    pthread_mutex_t _lock;
+    pthread_cond_t _ready;
+    std::deque<DiskJob*> _queue;
+    std::set<std::string> _busyKeys; // serialKey() des jobs en cours sur un thread
+    std::vector<DiskJob*> _done;
+    std::vector<pthread_t> _threads;
+    int _eventFd;
+    bool _stopping;
+
+    IoUring _ring;
+    std::vector<RingOp> _ringOps;      // Indexe par user_data
+    std::vector<unsigned> _freeOps;
+    std::vector<unsigned> _freeFiles;
+    std::deque<DiskJob*> _ringWaiting; // Suite d'un job io_uring, en attente de place dans la ring
+    unsigned _ringInflight;
+};
+
+#endif
@@ -0,0 +1,125 @@
+// FsStats.cpp
+#include "FsStats.hpp"
+#include "Logger.hpp"
+#include "Utils.hpp"
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+namespace {
+    struct Histogram {
+        unsigned long count;
+        unsigned long totalNs;
+        unsigned long maxNs;
+        unsigned long buckets[FS_HISTOGRAM_BUCKETS];
+    };
+
+    Histogram g_histograms[FS_OP_COUNT];
+
+    const char* g_names[FS_OP_COUNT] = {
+        "stat", "access", "realpath", "open", "opendir", "remove",
+        "session_load", "session_persist", "upload_write", "ring_job", "queue_wait"
+    };
+}
+
+namespace FsStats {
+
+unsigned long nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<unsigned long>(ts.tv_sec) * 1000000000UL + static_cast<unsigned long>(ts.tv_nsec);
+}
+
+void record(FsOp op, unsigned long ns) {
+    Histogram& h = g_histograms[op];
+    unsigned long us = ns / 1000;
+    int index = 0;
+    while (index < FS_HISTOGRAM_BUCKETS - 1 && us >= (1UL << index)) {
+        ++index;
+    }
+    __sync_fetch_and_add(&h.buckets[index], 1);
+    __sync_fetch_and_add(&h.count, 1);
+    __sync_fetch_and_add(&h.totalNs, ns);
+    unsigned long seen = h.maxNs;
+    while (ns > seen && !__sync_bool_compare_and_swap(&h.maxNs, seen, ns)) {
+        seen = h.maxNs;
+    }
+}
+
+const char* name(FsOp op) {
+    return g_names[op];
+}
+
+unsigned long count(FsOp op) {
+    return __sync_fetch_and_add(&g_histograms[op].count, 0);
+}
+
+unsigned long totalNs(FsOp op) {
+    return __sync_fetch_and_add(&g_histograms[op].totalNs, 0);
+}
+
+unsigned long maxNs(FsOp op) {
+    return __sync_fetch_and_add(&g_histograms[op].maxNs, 0);
+}
+
+unsigned long bucket(FsOp op, int index) {
+    return __sync_fetch_and_add(&g_histograms[op].buckets[index], 0);
+}
+
+unsigned long quantileUs(FsOp op, double q) {
+    unsigned long total = count(op);
+    if (total == 0) {
+        return 0;
+    }
+    unsigned long rank = static_cast<unsigned long>(q * total);
+    unsigned long seen = 0;
+    for (int i = 0; i < FS_HISTOGRAM_BUCKETS; ++i) {
+        seen += bucket(op, i);
+        if (seen > rank) {
+            return 1UL << i;
+        }
+    }
+    return maxNs(op) / 1000;
+}
+
+void report() {
+    for (int i = 0; i < FS_OP_COUNT; ++i) {
+        FsOp op = static_cast<FsOp>(i);
+        unsigned long n = count(op);
+        if (n == 0) {
+            continue;
+        }
+        Logger::instance().log(INFO, std::string("fs ") + name(op) + ": " + to_string(n) + " ops, mean "
+            + to_string(totalNs(op) / n / 1000) + "us, p50 <" + to_string(quantileUs(op, 0.5))
+            + "us, p99 <" + to_string(quantileUs(op, 0.99)) + "us, max " + to_string(maxNs(op) / 1000) + "us");
+    }
+}
+
+int stat(const char* path, struct stat* st) {
+    FsTimer timer(FS_STAT);
+    return ::stat(path, st);
+}
+
+int access(const char* path, int mode) {
+    FsTimer timer(FS_ACCESS);
+    return ::access(path, mode);
+}
+
+char* realpath(const char* path, char* resolved) {
+    FsTimer timer(FS_REALPATH);
+    return ::realpath(path, resolved);
+}
+
+int remove(const char* path) {
+    FsTimer timer(FS_REMOVE);
+    return std::remove(path);
+}
+
+}
+
+FsTimer::FsTimer(FsOp op) : _op(op), _start(FsStats::nowNs()) {}
+
+FsTimer::~FsTimer() {
+    FsStats::record(_op, FsStats::nowNs() - _start);
+}
@@ -0,0 +1,63 @@
+// FsStats.hpp
+#ifndef FSSTATS_HPP
+#define FSSTATS_HPP
+
+#include <sys/stat.h>
+#include <string>
+
+#define FS_HISTOGRAM_BUCKETS 24 // Puissances de 2 en microsecondes : 1us .. ~8s, la derniere sans borne
+
+// Operations de systeme de fichiers suivies
+enum FsOp {
+    FS_STAT,
+    FS_ACCESS,
+    FS_REALPATH,
+    FS_OPEN,
+    FS_OPENDIR,
+    FS_REMOVE,
+    FS_SESSION_LOAD,
+    FS_SESSION_PERSIST,
+    FS_UPLOAD_WRITE,   // Un fichier d'upload, sur un thread
+    FS_RING_JOB,       // Job io_uring complet, de la soumission a la derniere completion
+    FS_QUEUE_WAIT,     // Attente d'un job dans la file du DiskPool
+    FS_OP_COUNT
+};
+
+/*
+ * Latences des operations de fichiers, en histogramme log2 par operation.
+ * Sur la boucle, une mesure = le temps pendant lequel aucune connexion
+ * n'a ete servie ; les threads du DiskPool enregistrent aussi (increments
+ * atomiques). Resume logge a l'arret.
+ */
+namespace FsStats {
+    unsigned long nowNs(); // CLOCK_MONOTONIC
+
+    void record(FsOp op, unsigned long ns);
+    const char* name(FsOp op);
+    unsigned long count(FsOp op);
+    unsigned long totalNs(FsOp op);
+    unsigned long maxNs(FsOp op);
+    unsigned long bucket(FsOp op, int index);
+    // Borne haute du quantile `q` (0..1) en microsecondes, d'apres les buckets
+    unsigned long quantileUs(FsOp op, double q);
+    void report();
+
+    // Appels mesures, memes retours que les originaux
+    int stat(const char* path, struct stat* st);
+    int access(const char* path, int mode);
+    char* realpath(const char* path, char* resolved);
+    int remove(const char* path);
+}
+
+// Mesure la portee courante
+class FsTimer {
+public:
+    explicit FsTimer(FsOp op);
+    ~FsTimer();
+
+private:
+    FsOp _op;
+    unsigned long _start;
+};
+
+#endif
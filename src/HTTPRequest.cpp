@@ -2,144 +2,195 @@
 #include "Utils.hpp"
 #include "Location.hpp"
 #include "Logger.hpp"
+#include "Scan.hpp"
 #include <sstream>
 #include <iostream>
 #include <cstdlib>
+#include <cctype>
+#include <cstring>
+#include <strings.h>
+
+#define REQUEST_RESERVE_MAX (8 * 1024 * 1024) // Au-dela, croissance normale de la string
+#define REQUEST_KEEP_CAPACITY (64 * 1024)     // Capacite conservee d'une requete a l'autre
 
 HTTPRequest::HTTPRequest()
     : _complete(false), _connectionClosed(false), _maxBodySize(0),
-      _contentLength(0), _bodyReceived(0), _headersParsed(false), _requestTooLarge(false) {}
+      _contentLength(0), _bodyReceived(0), _headersParsed(false), _requestTooLarge(false), _keepAlive(false), _headValid(false), _headerEnd(SCAN_NPOS) {
+    clearKnownHeaders();
+}
 
 HTTPRequest::HTTPRequest(int max_body_size)
     : _complete(false), _connectionClosed(false), _maxBodySize(max_body_size),
-      _contentLength(0), _bodyReceived(0), _headersParsed(false), _requestTooLarge(false) {}
+      _contentLength(0), _bodyReceived(0), _headersParsed(false), _requestTooLarge(false), _keepAlive(false), _headValid(false), _headerEnd(SCAN_NPOS) {
+    clearKnownHeaders();
+}
 
 HTTPRequest::~HTTPRequest() {}
 
+void HTTPRequest::clearKnownHeaders() {
+    for (int id = 0; id < HEADER_COUNT; ++id) {
+        _known[id] = -1;
+    }
+}
+
+// Headers connus : indice direct ; autres : recherche lineaire insensible a la casse
+const HTTPRequest::HeaderField* HTTPRequest::findHeader(const char* name, size_t length) const {
+    HeaderId id = headerIdFor(name, length);
+    if (id != HEADER_OTHER) {
+        return findHeader(id);
+    }
+    for (size_t i = 0; i < _headers.size(); ++i) {
+        if (_headers[i].id == HEADER_OTHER && headerNameEquals(_headers[i].name, _headers[i].nameLength, name, length)) {
+            return &_headers[i];
+        }
+    }
+    return NULL;
+}
+
+const HTTPRequest::HeaderField* HTTPRequest::findHeader(HeaderId id) const {
+    if (id == HEADER_OTHER || _known[id] == -1) {
+        return NULL;
+    }
+    return &_headers[_known[id]];
+}
+
+// Occurrences multiples fusionnees comme le permet la RFC 9110 (Cookie avec "; ")
+std::string HTTPRequest::joinValues(const HeaderField* field) const {
+    if (field == NULL)
+        return "";
+    std::string value(field->value, field->valueLength);
+    const char* separator = headerJoinSeparator(field->id);
+    while (field->next != -1) {
+        field = &_headers[field->next];
+        value += separator;
+        value.append(field->value, field->valueLength);
+    }
+    return value;
+}
+
 bool HTTPRequest::hasHeader(std::string header) const {
-    std::map<std::string, std::string>::const_iterator it = _headers.find(header);
-    if (it != _headers.end())
-        return true;
-    return false;
+    return findHeader(header.data(), header.size()) != NULL;
+}
+
+bool HTTPRequest::hasHeader(HeaderId id) const {
+    return findHeader(id) != NULL;
 }
 
 std::string HTTPRequest::getStrHeader(std::string header) const {
-    std::map<std::string, std::string>::const_iterator it = _headers.find(header);
-    if (it == _headers.end())
-        return "";
-    return it->second;
+    return joinValues(findHeader(header.data(), header.size()));
 }
 
-void HTTPRequest::parseRawRequest(const ServerConfig& config) {
+std::string HTTPRequest::getStrHeader(HeaderId id) const {
+    return joinValues(findHeader(id));
+}
+
+void HTTPRequest::getHeaderValues(const std::string& header, std::vector<std::string>& values) const {
+    for (const HeaderField* field = findHeader(header.data(), header.size()); field != NULL;
+         field = (field->next != -1) ? &_headers[field->next] : NULL) {
+        values.push_back(std::string(field->value, field->valueLength));
+    }
+}
+
+// Analyse en place de la ligne de requete et des headers des qu'ils sont complets :
+// aucune sous-chaine temporaire, noms et valeurs copies dans l'arena de la requete
+void HTTPRequest::parseRawRequest() {
     // Check if headers are fully received
-    size_t header_end_pos = _rawRequest.find("\r\n\r\n");
+    const char* raw = _rawRequest.data();
+    size_t header_end_pos = Scan::findHeaderEnd(raw, _rawRequest.size());
 
-    if (header_end_pos == std::string::npos) {
+    if (header_end_pos == SCAN_NPOS) {
         return;
     }
+    _headerEnd = header_end_pos;
 
     // Parse the request line
-    size_t line_end_pos = _rawRequest.find("\r\n");
-    std::string request_line = _rawRequest.substr(0, line_end_pos);
-    std::istringstream iss(request_line);
-    iss >> _method >> _path;
-
-    // Determine max_body_size based on location
-    const Location* location = config.findLocation(_path);
-    if (location && location->clientMaxBodySize != -1) {
-        _maxBodySize = location->clientMaxBodySize;
-    }
+    size_t line_end_pos = Scan::findCRLF(raw, header_end_pos + 2);
+    _headValid = parseRequestLine(raw, line_end_pos);
 
     // Parse headers
-    std::string headers = getRawRequest().substr(0, header_end_pos);
-    std::istringstream headers_stream(headers);
-    std::string header_line;
-    while (std::getline(headers_stream, header_line)) {
-        if (!header_line.empty() && header_line[header_line.size() - 1] == '\r') {
-        	header_line.erase(header_line.size() - 1); //?? CHECK IF MODIFICATION IS GOOD !
-    	}
-        size_t colon_pos = header_line.find(":");
-        if (colon_pos != std::string::npos) {
-            std::string header_name = header_line.substr(0, colon_pos);
-            std::string header_value = header_line.substr(colon_pos + 1);
-            // Trim whitespace
-            header_name.erase(0, header_name.find_first_not_of(" \t"));
-            header_name.erase(header_name.find_last_not_of(" \t") + 1);
-            header_value.erase(0, header_value.find_first_not_of(" \t"));
-            header_value.erase(header_value.find_last_not_of(" \t") + 1);
-
-            if (header_name == "Content-Length") {
-                _contentLength = static_cast<size_t>(atoi(header_value.c_str()));
-            }
-        }
+    size_t pos = line_end_pos + 2;
+    while (pos < header_end_pos) {
+        size_t eol = Scan::findCRLF(raw + pos, header_end_pos + 2 - pos);
+        eol = (eol == SCAN_NPOS) ? header_end_pos : pos + eol;
+        parseHeaderLine(raw + pos, eol - pos);
+        pos = eol + 2;
     }
 
     _headersParsed = true;
+}
+
+void HTTPRequest::applyBodyLimit(const ServerConfig& config) {
+    // Determine max_body_size based on the virtual host and its location
+    _maxBodySize = config.clientMaxBodySize;
+    const Location* location = config.findLocation(_path);
+    if (location && location->clientMaxBodySize != -1) {
+        _maxBodySize = location->clientMaxBodySize;
+    }
 
     // Check for request too large
     if (_maxBodySize > 0 && _contentLength > static_cast<size_t>(_maxBodySize)) {
         Logger::instance().log(WARNING, "Content-Length exceeds the configured maximum.");
         _requestTooLarge = true;
+        return;
+    }
+
+    // Taille finale connue : une seule allocation pour tout le body
+    if (_contentLength > 0 && _contentLength <= REQUEST_RESERVE_MAX) {
+        _rawRequest.reserve(_headerEnd + 4 + _contentLength);
     }
 }
 
 bool HTTPRequest::parse() {
-    size_t header_end_pos = _rawRequest.find("\r\n\r\n");
-    if (header_end_pos == std::string::npos) {
+    if (!_headersParsed) {
+        parseRawRequest();
+    }
+    if (!_headersParsed) {
         Logger::instance().log(ERROR, "Invalid HTTP request: missing header-body separator.");
         return false;
     }
-
-    std::string headers_part = _rawRequest.substr(0, header_end_pos);
-    std::string body_part = _rawRequest.substr(header_end_pos + 4);
-
-    std::istringstream header_stream(headers_part);
-    std::string line;
-
-    if (std::getline(header_stream, line)) {
-        if (!parseRequestLine(line)) {
-            return false;
-        }
-    } else {
-        Logger::instance().log(ERROR, "Invalid HTTP request: missing request line.");
+    if (!_headValid) {
         return false;
     }
 
-    // Parse headers
-    while (std::getline(header_stream, line) && !line.empty()) {
-        parseHeaders(line);
-    }
-
     // Handle the body if there's a Content-Length
-    std::map<std::string, std::string>::iterator it = _headers.find("Content-Length");
-    if (it != _headers.end()) {
-        int content_length = std::atoi(it->second.c_str());
-        if (body_part.size() < static_cast<size_t>(content_length)) {
+    if (findHeader(HEADER_CONTENT_LENGTH) != NULL) {
+        size_t body_start = _headerEnd + 4;
+        if (_rawRequest.size() - body_start < _contentLength) {
             Logger::instance().log(ERROR, "Failed to read the entire body");
             return false;
         }
-        parseBody(body_part.substr(0, content_length));
+        _body.assign(_rawRequest, body_start, _contentLength);
     }
 
     return true;
 }
 
 // Parse the request line and extract method, path, and version
-bool HTTPRequest::parseRequestLine(const std::string& line) {
-    std::istringstream iss(line);
-    std::string version;
-    iss >> _method >> _path >> version;
-
-    if (_method.empty() || _path.empty() || version.empty()) {
+bool HTTPRequest::parseRequestLine(const char* line, size_t length) {
+    size_t first = 0;
+    while (first < length && line[first] != ' ') {
+        ++first;
+    }
+    size_t second = first + 1;
+    while (second < length && line[second] != ' ') {
+        ++second;
+    }
+    if (first == 0 || first >= length || second >= length || second == first + 1 || second + 1 >= length) {
         Logger::instance().log(ERROR, "Invalid HTTP Request");
         return false;
     }
+    _method.assign(line, first);
+    _path.assign(line + first + 1, second - first - 1);
+    const char* version = line + second + 1;
+    size_t versionLength = length - second - 1;
 
     // Extract query string if present
     parseQueryString();
 
-    if (version != "HTTP/1.1") {
-        Logger::instance().log(ERROR, "Unsupported HTTP version: " + version);
+    bool http11 = (versionLength == 8 && std::memcmp(version, "HTTP/1.1", 8) == 0);
+    _keepAlive = http11; // Persistante par defaut en HTTP/1.1
+    if (!http11) {
+        Logger::instance().log(ERROR, "Unsupported HTTP version: " + std::string(version, versionLength));
         return false;
     }
     return true;
@@ -149,56 +200,115 @@ bool HTTPRequest::parseRequestLine(const std::string& line) {
 void HTTPRequest::parseQueryString() {
     size_t pos = _path.find('?');
     if (pos != std::string::npos) {
-        _queryString = _path.substr(pos + 1);
-        _path = _path.substr(0, pos);
+        _queryString.assign(_path, pos + 1, std::string::npos);
+        _path.erase(pos);
     } else {
-        _queryString = "";
+        _queryString.erase();
     }
 }
 
-void HTTPRequest::parseHeaders(const std::string& headers_line) {
-    size_t pos = headers_line.find(":");
-    if (pos != std::string::npos) {
-        std::string key = headers_line.substr(0, pos);
-        std::string value = headers_line.substr(pos + 1);
-        trim(key);
-        trim(value);
-        _headers[key] = value;
+void HTTPRequest::parseHeaderLine(const char* line, size_t length) {
+    size_t colonPos = Scan::findByte(line, length, ':');
+    if (colonPos == SCAN_NPOS) {
+        return;
+    }
+    // Nom = token strict : un espace avant ':' ou un caractere de controle rend la requete invalide (RFC 9112)
+    if (colonPos == 0 || Scan::tokenLength(line, colonPos) != colonPos) {
+        Logger::instance().log(ERROR, "Invalid header field name: " + std::string(line, colonPos));
+        _headValid = false;
+        return;
+    }
+    const char* nameStart = line;
+    const char* nameEnd = line + colonPos;
+    const char* valueStart = nameEnd + 1;
+    const char* valueEnd = line + length;
+    // Trim whitespace
+    while (valueStart < valueEnd && (*valueStart == ' ' || *valueStart == '\t')) ++valueStart;
+    while (valueEnd > valueStart && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t' || valueEnd[-1] == '\r')) --valueEnd;
+
+    HeaderField field;
+    field.nameLength = nameEnd - nameStart;
+    field.valueLength = valueEnd - valueStart;
+    field.name = _arena.copy(nameStart, field.nameLength);
+    field.value = _arena.copy(valueStart, field.valueLength);
+
+    field.id = headerIdFor(field.name, field.nameLength);
+    field.next = -1;
+
+    if (field.id == HEADER_CONTENT_LENGTH) {
+        size_t contentLength = static_cast<size_t>(atoi(field.value));
+        if (_known[HEADER_CONTENT_LENGTH] != -1 && contentLength != _contentLength) {
+            // Deux longueurs differentes : corps ambigu (request smuggling), requete refusee
+            Logger::instance().log(ERROR, "Conflicting Content-Length headers");
+            _headValid = false;
+        }
+        _contentLength = contentLength;
+    } else if (field.id == HEADER_CONNECTION) {
+        // Un seul passage sur la valeur deja en arena, pas de copie en minuscules
+        for (size_t i = 0; i < field.valueLength; ++i) {
+            if (strncasecmp(field.value + i, "close", 5) == 0) {
+                _keepAlive = false;
+                break;
+            }
+            if (strncasecmp(field.value + i, "keep-alive", 10) == 0) {
+                _keepAlive = true;
+                break;
+            }
+        }
     }
-}
 
-std::string HTTPRequest::getHost() const {
-    std::map<std::string, std::string>::const_iterator it = _headers.find("Host");
-    if (it != _headers.end()) {
-        return it->second;
+    // Les occurrences repetees sont gardees et chainees a la premiere
+    int index = static_cast<int>(_headers.size());
+    const HeaderField* first = findHeader(field.name, field.nameLength);
+    if (first == NULL) {
+        if (field.id != HEADER_OTHER) {
+            _known[field.id] = index;
+        }
+    } else {
+        HeaderField* last = &_headers[first - &_headers[0]];
+        while (last->next != -1) {
+            last = &_headers[last->next];
+        }
+        last->next = index;
     }
-    return "";
+    _headers.push_back(field);
 }
 
-void HTTPRequest::parseBody(const std::string& body) {
-    _body = body;
+std::string HTTPRequest::getHost() const {
+    return getStrHeader(HEADER_HOST);
 }
 
-std::string HTTPRequest::getMethod() const {
+const std::string& HTTPRequest::getMethod() const {
     return _method;
 }
 
-std::string HTTPRequest::getPath() const {
+const std::string& HTTPRequest::getPath() const {
     return _path;
 }
 
-std::string HTTPRequest::getQueryString() const {
+const std::string& HTTPRequest::getQueryString() const {
     return _queryString;
 }
 
 std::map<std::string, std::string> HTTPRequest::getHeaders() const {
-    return _headers;
+    std::map<std::string, std::string> headers;
+    for (size_t i = 0; i < _headers.size(); ++i) {
+        std::string name(_headers[i].name, _headers[i].nameLength);
+        if (headers.find(name) == headers.end()) {
+            headers[name] = joinValues(&_headers[i]);
+        }
+    }
+    return headers;
 }
 
-std::string HTTPRequest::getBody() const {
+const std::string& HTTPRequest::getBody() const {
     return _body;
 }
 
+void HTTPRequest::swapBody(std::string& body) {
+    _body.swap(body);
+}
+
 void HTTPRequest::trim(std::string& s) const {
     size_t start = s.find_first_not_of(" \t\r\n");
     size_t end = s.find_last_not_of(" \t\r\n");
@@ -210,12 +320,14 @@ void HTTPRequest::trim(std::string& s) const {
 }
 
 std::string HTTPRequest::toStringHeaders() const {
-    std::ostringstream oss;
-
-    for (std::map<std::string, std::string>::const_iterator it = _headers.begin(); it != _headers.end(); ++it) {
-        oss << it->first << ": " << it->second << "\r\n";
+    std::string out;
+    for (size_t i = 0; i < _headers.size(); ++i) {
+        out.append(_headers[i].name, _headers[i].nameLength);
+        out += ": ";
+        out.append(_headers[i].value, _headers[i].valueLength);
+        out += "\r\n";
     }
-    return oss.str();
+    return out;
 }
 
 std::string HTTPRequest::toString() const {
@@ -229,11 +341,12 @@ std::string HTTPRequest::toString() const {
 }
 
 bool HTTPRequest::getHeadersParsed() const { return _headersParsed; }
+size_t HTTPRequest::getBodyOffset() const { return _headerEnd + 4; }
 bool HTTPRequest::getRequestTooLarge() const { return _requestTooLarge; }
 size_t HTTPRequest::getContentLength() const { return _contentLength; }
 size_t HTTPRequest::getBodyReceived() const { return _bodyReceived; }
 int HTTPRequest::getMaxBodySize() const { return _maxBodySize; }
-std::string HTTPRequest::getRawRequest() const { return _rawRequest; }
+const std::string& HTTPRequest::getRawRequest() const { return _rawRequest; }
 bool HTTPRequest::getConnectionClosed() const { return _connectionClosed; }
 unsigned long HTTPRequest::getLastActivity() const {return _lastActivity; }
 bool HTTPRequest::isComplete() const { return _complete; }
@@ -244,3 +357,63 @@ void HTTPRequest::setConnectionClosed(bool value) { _connectionClosed = value; }
 void HTTPRequest::setComplete(bool value) { _complete = value; }
 
 void HTTPRequest::setLastActivity(unsigned long timestamp) { _lastActivity = timestamp; }
+bool HTTPRequest::getKeepAlive() const { return _keepAlive; }
+void HTTPRequest::setKeepAlive(bool value) { _keepAlive = value; }
+
+std::string HTTPRequest::getPipelinedData() const {
+    if (_headerEnd == SCAN_NPOS) {
+        return "";
+    }
+    size_t request_end = _headerEnd + 4 + _contentLength;
+    if (request_end >= _rawRequest.size()) {
+        return "";
+    }
+    return _rawRequest.substr(request_end);
+}
+
+int HTTPRequest::checkHeaderLimits(size_t lineMax, size_t totalMax) const {
+    if (_headersParsed) {
+        return 0;
+    }
+    size_t header_end_pos = Scan::findHeaderEnd(_rawRequest.data(), _rawRequest.size());
+    size_t header_size = (header_end_pos == SCAN_NPOS) ? _rawRequest.size() : header_end_pos + 4;
+    size_t line_end_pos = Scan::findCRLF(_rawRequest.data(), _rawRequest.size());
+    size_t line_size = (line_end_pos == SCAN_NPOS) ? _rawRequest.size() : line_end_pos;
+    if (line_size > lineMax) {
+        return 414;
+    }
+    if (header_size > totalMax) {
+        return 431;
+    }
+    return 0;
+}
+
+void HTTPRequest::reset() {
+    if (_rawRequest.capacity() > REQUEST_KEEP_CAPACITY) {
+        std::string().swap(_rawRequest); // Ne pas garder indefiniment le buffer d'un gros upload
+    } else {
+        _rawRequest.erase();
+    }
+    if (_body.capacity() > REQUEST_KEEP_CAPACITY) {
+        std::string().swap(_body);
+    } else {
+        _body.erase();
+    }
+    _method.erase();
+    _path.erase();
+    _queryString.erase();
+    _headers.clear(); // Capacite du vecteur conservee, les champs vivaient dans l'arena
+    clearKnownHeaders();
+    _arena.reset();
+    _headerEnd = SCAN_NPOS;
+    _headValid = false;
+    _complete = false;
+    _connectionClosed = false;
+    _maxBodySize = 0;
+    _contentLength = 0;
+    _bodyReceived = 0;
+    _headersParsed = false;
+    _requestTooLarge = false;
+    _keepAlive = false;
+    _lastActivity = 0;
+}
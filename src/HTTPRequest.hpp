@@ -2,7 +2,10 @@
 #define HTTPREQUEST_HPP
 
 #include "ServerConfig.hpp"
+#include "Arena.hpp"
+#include "HeaderTable.hpp"
 #include <string>
+#include <vector>
 #include <map>
 
 
@@ -12,31 +15,42 @@ public:
 	HTTPRequest(int def_max_body_size);
 	~HTTPRequest();
 
-	std::string getMethod() const;
-	std::string getPath() const;
-	std::string getQueryString() const;
+	const std::string& getMethod() const;
+	const std::string& getPath() const;
+	const std::string& getQueryString() const;
+	// Copie construite a la demande : preferer getStrHeader/hasHeader
 	std::map<std::string, std::string> getHeaders() const;
 
+	// Noms insensibles a la casse ; occurrences multiples fusionnees (", ", ou "; " pour Cookie)
 	std::string getStrHeader(std::string header) const;
+	std::string getStrHeader(HeaderId id) const;
 	bool hasHeader(std::string header) const;
+	bool hasHeader(HeaderId id) const;
+	// Chaque occurrence separement, dans l'ordre de reception
+	void getHeaderValues(const std::string& header, std::vector<std::string>& values) const;
 
-	std::string getBody() const;
+	const std::string& getBody() const;
+	// Reprise du corps sans copie (upload confie au DiskPool)
+	void swapBody(std::string& body);
 	std::string getHost() const;
 	void trim(std::string& s) const;
 
 	bool parse();
     std::string toString() const;
     std::string toStringHeaders() const;
-	void parseRawRequest(const ServerConfig& config);
+	void parseRawRequest();
+	void applyBodyLimit(const ServerConfig& config);
 
 	std::string _rawRequest;
 
 	bool getHeadersParsed() const;
+	// Debut du corps dans _rawRequest (headers parses uniquement)
+	size_t getBodyOffset() const;
     bool getRequestTooLarge() const;
     size_t getContentLength() const;
 	size_t getBodyReceived() const;
 	int	getMaxBodySize() const;
-	std::string getRawRequest() const;
+	const std::string& getRawRequest() const;
 	unsigned long getLastActivity() const;
 
 
@@ -48,14 +62,37 @@ public:
     bool getConnectionClosed() const;
     void setConnectionClosed(bool value);
 	void setLastActivity(unsigned long timestamp);
+	bool getKeepAlive() const;
+	void setKeepAlive(bool value);
+	// Octets recus au-dela de cette requete (pipelining), debut de la suivante
+	std::string getPipelinedData() const;
+	// 0, 414 (ligne de requete > lineMax) ou 431 (headers > totalMax) tant que les headers ne sont pas parses
+	int checkHeaderLimits(size_t lineMax, size_t totalMax) const;
+	// Requete suivante sur la meme connexion : garde la capacite de _rawRequest
+	void reset();
 
 
 private:
+	HTTPRequest(const HTTPRequest&);
+	HTTPRequest& operator=(const HTTPRequest&);
+
+	// Nom et valeur alloues dans _arena, liberes en bloc par reset()
+	struct HeaderField {
+		HeaderId id;
+		const char* name;
+		size_t nameLength;
+		const char* value;
+		size_t valueLength;
+		int next; // Occurrence suivante du meme header, -1 sinon
+	};
+
+	Arena _arena;
+	std::vector<HeaderField> _headers; // Ordre de reception
+	int _known[HEADER_COUNT];          // Premiere occurrence de chaque header connu, -1 si absent
 	std::string _method;
 	std::string _path;
 	std::string _queryString;
 	std::string _body;
-	std::map<std::string, std::string> _headers;
 	bool _complete;
     bool _connectionClosed;
 
@@ -64,13 +101,19 @@ private:
     size_t _bodyReceived;
     bool _headersParsed;
     bool _requestTooLarge;
+    bool _keepAlive;
+    bool _headValid; // Ligne de requete et headers acceptables
+    size_t _headerEnd; // Position de "\r\n\r\n", SCAN_NPOS tant que les headers sont incomplets
 
 	unsigned long _lastActivity;
 
 
-	bool parseRequestLine(const std::string& line);
-	void parseHeaders(const std::string& headers);
-	void parseBody(const std::string& body);
+	void clearKnownHeaders();
+	const HeaderField* findHeader(const char* name, size_t length) const;
+	const HeaderField* findHeader(HeaderId id) const;
+	std::string joinValues(const HeaderField* field) const;
+	bool parseRequestLine(const char* line, size_t length);
+	void parseHeaderLine(const char* line, size_t length);
 	void parseQueryString();
 };
 
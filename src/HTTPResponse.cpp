@@ -2,48 +2,26 @@
 #include "Server.hpp"
 #include <sstream>
 #include "Utils.hpp"
+#include "StatusLine.hpp"
 
-HTTPResponse::HTTPResponse() : _statusCode(200), _reasonPhrase("OK") {}
+HTTPResponse::HTTPResponse() : _statusCode(200), _status(statusLineFor(200)), _source(NULL) {}
 
-HTTPResponse::~HTTPResponse() {}
+HTTPResponse::~HTTPResponse() {
+	delete _source;
+}
 
 void HTTPResponse::setStatusCode(int code) {
 	_statusCode = code;
-	// Vous pouvez définir la raison en fonction du code
-	switch (code) {
-		case 200: _reasonPhrase = "OK"; break;
-		case 201: _reasonPhrase = "Created"; break;
-		case 301: _reasonPhrase = "Moved Permanently"; break; // indique que la ressource a définitivement été déplacée à l'URL contenue dans l'en-tête Location
-		case 303: _reasonPhrase = "See Other"; break; // renvoyé comme résultat d'une opération PUT ou POST, indique que la redirection ne fait pas le lien vers la ressource nouvellement téléversée mais vers une autre page
-		case 307: _reasonPhrase = "Temporary Redirect"; break; // indique que la ressource demandée est temporairement déplacée vers l'URL contenue dans l'en-tête Location
-		case 308: _reasonPhrase = "Permanent Redirect"; break; // indique que la ressource demandée à définitivement été déplacée vers l'URL contenue dans l'en-tête Location. Un navigateur redirigera vers cette page et les moteurs de recherche mettront à jour leurs liens vers la ressource
-		case 400: _reasonPhrase = "Bad Request"; break;
-		case 401: _reasonPhrase = "Unauthorized"; break;
-		case 403: _reasonPhrase = "Forbidden"; break;
-		case 404: _reasonPhrase = "Not Found"; break;
-		case 405: _reasonPhrase = "Method Not Allowed"; break;
-		case 408: _reasonPhrase = "Request Timeout"; break; // le serveur ne reçoit pas de requête complète dans un délai défini.
-		case 413: _reasonPhrase = "Payload Too Large"; break; // fichier téléchargé dépasse la limite autorisée.
-		case 415: _reasonPhrase = "Unsupported Media Type"; break; // Si certains types de fichiers ne sont pas acceptés.
-		case 418: _reasonPhrase = "I'm a teapot"; break; //?? Where should we implement it ?
-		case 429: _reasonPhrase = "Too Many Requests"; break; // trop grand nombre de requêtes en peu de temps (si limite)
-		case 500: _reasonPhrase = "Internal Server Error"; break;
-		case 501: _reasonPhrase = "Method Not Implemented"; break;
-		case 502: _reasonPhrase = "Bad Gateway"; break; // un serveur (agissant comme une passerelle ou un proxy, style NGINX) a reçu une réponse invalide ou inattendue d'un autre serveur en amont
-		case 503: _reasonPhrase = "Service Unavailable"; break; // le serveur n'est pas prêt à traiter la requête (surcharge, maintenance, etc.).
-		case 504: _reasonPhrase = "Gateway Timeout"; break; //un des serveurs, passerelle ou proxy, n'a pas reçu une réponse à temps de la part d'un autre serveur (ou interface) qu'il a interrogé pour obtenir une réponse à la requête
-
-		default: _reasonPhrase = "Unknown";
-	}
+	_status = statusLineFor(code); // Ligne et raison precalculees, NULL si code inconnu
 }
 
 std::string HTTPResponse::generateErrorPage(std::string infos) {
 	std::stringstream page;
 	page << "<html><head><title>Error " << _statusCode << "</title>";
 	page << "<link rel=\"stylesheet\" href=\"../css/err_style.css\"><meta charset=UTF-8></head>";
-	page << "<body><h1>Error " << _statusCode << ": " << _reasonPhrase << "</h1>";
+	page << "<body><h1>Error " << _statusCode << ": " << getReasonPhrase() << "</h1>";
 	page << "<h3>" + infos + "</h3>";
-	page << "<img src=\"" << getSorryPath() << "\" alt=\"Error Image\">";
+	page << "<img src=\"" << getSorryPath(_statusCode) << "\" alt=\"Error Image\">";
 	page << "<p>The server encountered an issue processing your request.</p>";
 	page << "</body></html>";
 	return page.str();
@@ -53,8 +31,8 @@ std::string HTTPResponse::generateErrorPage() {
 	std::stringstream page;
 	page << "<html><head><title>Error " << _statusCode << "</title>";
 	page << "<link rel=\"stylesheet\" href=\"../css/err_style.css\"><meta charset=UTF-8></head>";
-	page << "<body><h1>Error " << _statusCode << ": " << _reasonPhrase << "</h1>";
-	page << "<img src=\"" << getSorryPath() << "\" alt=\"Error Image\">";
+	page << "<body><h1>Error " << _statusCode << ": " << getReasonPhrase() << "</h1>";
+	page << "<img src=\"" << getSorryPath(_statusCode) << "\" alt=\"Error Image\">";
 	page << "<a href=\"index.html\">Retour à l'accueil</a>";
 	page << "<p>The server encountered an issue processing your request.</p>";
 	page << "</body></html>";
@@ -73,52 +51,95 @@ HTTPResponse& HTTPResponse::beError(int err_code, const std::string& errorConten
 	return *this;
 }
 
-void HTTPResponse::setReasonPhrase(const std::string& reason) {
-	_reasonPhrase = reason;
+void HTTPResponse::setHeader(const std::string& key, const std::string& value) {
+	_headers.set(key, value);
 }
 
-void HTTPResponse::setHeader(const std::string& key, const std::string& value) {
-	_headers[key] = value;
+void HTTPResponse::addHeader(const std::string& key, const std::string& value) {
+	_headers.add(key, value);
 }
 
 void HTTPResponse::setBody(const std::string& body) {
+	setBodySource(NULL);
 	_body = body;
 }
 
+void HTTPResponse::swapBody(std::string& body) {
+	setBodySource(NULL);
+	_body.swap(body);
+}
+
+void HTTPResponse::setBodySource(BodySource* source) {
+	if (source != _source) {
+		delete _source;
+		_source = source;
+	}
+	if (_source != NULL) {
+		_body.erase();
+	}
+}
+
 int HTTPResponse::getStatusCode() const {
 	return _statusCode;
 }
 
-std::string HTTPResponse::getReasonPhrase() const {
-	return _reasonPhrase;
+const char* HTTPResponse::getReasonPhrase() const {
+	return (_status != NULL) ? _status->reason : "Unknown";
+}
+
+const StatusLine* HTTPResponse::getStatusLine() const {
+	return _status;
 }
 
-std::map<std::string, std::string> HTTPResponse::getHeaders() const {
+const HeaderTable& HTTPResponse::getHeaders() const {
 	return _headers;
 }
 
-std::string HTTPResponse::getBody() const {
+const std::string& HTTPResponse::getBody() const {
 	return _body;
 }
 
+BodySource* HTTPResponse::getBodySource() const {
+	return _source;
+}
+
+off_t HTTPResponse::getBodySize() const {
+	if (_source != NULL) {
+		return _source->size();
+	}
+	return static_cast<off_t>(_body.size());
+}
+
 std::string HTTPResponse::getStrHeader(std::string header) const {
-	std::map<std::string, std::string>::const_iterator it = _headers.find(header);
-	if (it == _headers.end())
-		return ""; // Retourner une chaîne vide si l'en-tête n'existe pas
-	return it->second;
+	return _headers.get(header); // Chaine vide si l'en-tete n'existe pas
 }
 
 std::string HTTPResponse::toStringHeaders() const {
 	std::ostringstream oss;
-	oss << "HTTP/1.1 " << _statusCode << " " << _reasonPhrase << "\r\n";
+	if (_status != NULL) {
+		oss.write(_status->line, _status->length);
+	} else {
+		oss << "HTTP/1.1 " << _statusCode << " Unknown\r\n";
+	}
+	oss.write(DateCache::headers(), DateCache::length());
 
 	// Ajouter les en-têtes
-	for (std::map<std::string, std::string>::const_iterator it = _headers.begin(); it != _headers.end(); ++it) {
-		oss << it->first << ": " << it->second << "\r\n";
+	for (size_t i = 0; i < _headers.size(); ++i) {
+		oss << _headers.entry(i).name << ": " << _headers.entry(i).value << "\r\n";
 	}
 	return oss.str();
 }
 
+void HTTPResponse::swapHeaders(HeaderTable& headers) {
+	_headers.swap(headers);
+}
+
+BodySource* HTTPResponse::releaseBodySource() {
+	BodySource* source = _source;
+	_source = NULL;
+	return source;
+}
+
 std::string HTTPResponse::toString() const {
 	std::ostringstream oss;
 	oss << toStringHeaders();
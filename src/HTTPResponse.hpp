@@ -3,6 +3,9 @@
 
 #include <string>
 #include <map>
+#include "ResponseBody.hpp"
+#include "HeaderTable.hpp"
+#include "StatusLine.hpp"
 
 class HTTPResponse {
 public:
@@ -10,29 +13,47 @@ public:
     ~HTTPResponse();
 
     void setStatusCode(int code);
-    void setReasonPhrase(const std::string& reason);
+    // Remplace toutes les occurrences (nom insensible a la casse)
     void setHeader(const std::string& key, const std::string& value);
+    // Ajoute une occurrence, pour les headers repetables comme Set-Cookie
+    void addHeader(const std::string& key, const std::string& value);
     void setBody(const std::string& body);
+    // Echange avec `body` au lieu de copier (l'appelant recupere l'ancien corps)
+    void swapBody(std::string& body);
+    // Corps produit a l'envoi (fichier, flux, generateur) ; la reponse en prend possession
+    void setBodySource(BodySource* source);
     HTTPResponse& beError(int err_code, const std::string& errorContent = "");
 
     int getStatusCode() const;
-    std::string getReasonPhrase() const;
+    const char* getReasonPhrase() const;
+    // Ligne de statut precalculee, NULL si le code n'est pas dans la table
+    const StatusLine* getStatusLine() const;
     std::string generateErrorPage();
     std::string generateErrorPage(std::string infos);
-    std::map<std::string, std::string> getHeaders() const;
-    std::string getBody() const;
+    const HeaderTable& getHeaders() const;
+    const std::string& getBody() const;
+    BodySource* getBodySource() const;
+    // Taille du corps en memoire ou de la source, -1 si inconnue
+    off_t getBodySize() const;
     std::string getStrHeader(std::string header) const;
 
     std::string toString() const;
     std::string toStringHeaders() const;
+    // Reprise du contenu par ResponseWriter, sans copie
+    void swapHeaders(HeaderTable& headers);
+    BodySource* releaseBodySource();
 
 private:
+    HTTPResponse(const HTTPResponse&);
+    HTTPResponse& operator=(const HTTPResponse&);
+
     int _statusCode;
-    std::string _reasonPhrase;
-    std::map<std::string, std::string> _headers;
+    const StatusLine* _status;
+    HeaderTable _headers;
     std::string _body;
+    BodySource* _source; // Prioritaire sur _body quand present
 };
 
-std::string getSorryPath();
+std::string getSorryPath(int code);
 
 #endif
@@ -0,0 +1,140 @@
+// HeaderTable.cpp
+#include "HeaderTable.hpp"
+#include <strings.h>
+
+namespace {
+    struct KnownHeader {
+        const char* name;
+        size_t length;
+    };
+
+    // Meme ordre que l'enum HeaderId
+    const KnownHeader g_knownHeaders[HEADER_COUNT] = {
+        { "Host", 4 },
+        { "Content-Length", 14 },
+        { "Content-Type", 12 },
+        { "Cookie", 6 },
+        { "Connection", 10 },
+        { "Range", 5 },
+        { "Transfer-Encoding", 17 },
+        { "User-Agent", 10 },
+        { "Accept", 6 },
+        { "Accept-Encoding", 15 },
+        { "If-Modified-Since", 17 },
+        { "If-None-Match", 13 },
+        { "Authorization", 13 },
+        { "Expect", 6 },
+        { "Set-Cookie", 10 },
+        { "Location", 8 },
+        { "Content-Encoding", 16 },
+        { "Last-Modified", 13 },
+        { "Date", 4 },
+        { "Server", 6 }
+    };
+}
+
+bool headerNameEquals(const char* a, size_t aLength, const char* b, size_t bLength) {
+    return aLength == bLength && strncasecmp(a, b, aLength) == 0;
+}
+
+HeaderId headerIdFor(const char* name, size_t length) {
+    // Table courte : la longueur elimine presque tous les candidats avant la comparaison
+    for (int id = 0; id < HEADER_COUNT; ++id) {
+        if (g_knownHeaders[id].length == length && strncasecmp(g_knownHeaders[id].name, name, length) == 0) {
+            return static_cast<HeaderId>(id);
+        }
+    }
+    return HEADER_OTHER;
+}
+
+HeaderId headerIdFor(const std::string& name) {
+    return headerIdFor(name.data(), name.size());
+}
+
+const char* headerName(HeaderId id) {
+    if (static_cast<int>(id) < 0 || id >= HEADER_COUNT) {
+        return "";
+    }
+    return g_knownHeaders[id].name;
+}
+
+const char* headerJoinSeparator(HeaderId id) {
+    return id == HEADER_COOKIE ? "; " : ", ";
+}
+
+HeaderTable::HeaderTable() {}
+
+int HeaderTable::find(HeaderId id, const std::string& name) const {
+    for (size_t i = 0; i < _entries.size(); ++i) {
+        if (id != HEADER_OTHER) {
+            if (_entries[i].id == id) {
+                return static_cast<int>(i);
+            }
+        } else if (_entries[i].id == HEADER_OTHER
+                   && headerNameEquals(_entries[i].name.data(), _entries[i].name.size(), name.data(), name.size())) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void HeaderTable::set(const std::string& name, const std::string& value) {
+    HeaderId id = headerIdFor(name);
+    int index = find(id, name);
+    if (index == -1) {
+        add(name, value);
+        return;
+    }
+    _entries[index].value = value;
+    // Les occurrences suivantes disparaissent : set() remplace le header entier
+    for (size_t i = _entries.size(); i-- > static_cast<size_t>(index) + 1; ) {
+        if (_entries[i].id == id && (id != HEADER_OTHER
+                || headerNameEquals(_entries[i].name.data(), _entries[i].name.size(), name.data(), name.size()))) {
+            _entries.erase(_entries.begin() + i);
+        }
+    }
+}
+
+void HeaderTable::add(const std::string& name, const std::string& value) {
+    Entry entry;
+    entry.id = headerIdFor(name);
+    entry.name = (entry.id != HEADER_OTHER) ? std::string(headerName(entry.id)) : name;
+    entry.value = value;
+    _entries.push_back(entry);
+}
+
+void HeaderTable::remove(const std::string& name) {
+    HeaderId id = headerIdFor(name);
+    int index;
+    while ((index = find(id, name)) != -1) {
+        _entries.erase(_entries.begin() + index);
+    }
+}
+
+std::string HeaderTable::get(const std::string& name) const {
+    int index = find(headerIdFor(name), name);
+    if (index == -1) {
+        return "";
+    }
+    return _entries[index].value;
+}
+
+bool HeaderTable::has(const std::string& name) const {
+    return find(headerIdFor(name), name) != -1;
+}
+
+size_t HeaderTable::size() const {
+    return _entries.size();
+}
+
+const HeaderTable::Entry& HeaderTable::entry(size_t index) const {
+    return _entries[index];
+}
+
+void HeaderTable::clear() {
+    _entries.clear();
+}
+
+void HeaderTable::swap(HeaderTable& other) {
+    _entries.swap(other._entries);
+}
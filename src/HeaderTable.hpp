@@ -0,0 +1,78 @@
+// HeaderTable.hpp
+#ifndef HEADERTABLE_HPP
+#define HEADERTABLE_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Headers connus, resolus une fois au parsing pour un acces direct par indice
+enum HeaderId {
+    HEADER_HOST,
+    HEADER_CONTENT_LENGTH,
+    HEADER_CONTENT_TYPE,
+    HEADER_COOKIE,
+    HEADER_CONNECTION,
+    HEADER_RANGE,
+    HEADER_TRANSFER_ENCODING,
+    HEADER_USER_AGENT,
+    HEADER_ACCEPT,
+    HEADER_ACCEPT_ENCODING,
+    HEADER_IF_MODIFIED_SINCE,
+    HEADER_IF_NONE_MATCH,
+    HEADER_AUTHORIZATION,
+    HEADER_EXPECT,
+    HEADER_SET_COOKIE,
+    HEADER_LOCATION,
+    HEADER_CONTENT_ENCODING,
+    HEADER_LAST_MODIFIED,
+    HEADER_DATE,
+    HEADER_SERVER,
+    HEADER_COUNT,
+    HEADER_OTHER = HEADER_COUNT
+};
+
+// HEADER_OTHER si le nom n'est pas un header connu (comparaison insensible a la casse)
+HeaderId headerIdFor(const char* name, size_t length);
+HeaderId headerIdFor(const std::string& name);
+// Nom canonique d'un header connu
+const char* headerName(HeaderId id);
+bool headerNameEquals(const char* a, size_t aLength, const char* b, size_t bLength);
+// Separateur pour fusionner les occurrences multiples : "; " pour Cookie, ", " sinon
+const char* headerJoinSeparator(HeaderId id);
+
+/*
+ * Headers d'une reponse : tableau plat dans l'ordre d'insertion, recherche
+ * insensible a la casse. set() remplace toutes les occurrences, add() en
+ * ajoute une (Set-Cookie doit rester en lignes separees).
+ */
+class HeaderTable {
+public:
+    struct Entry {
+        HeaderId id;
+        std::string name;
+        std::string value;
+    };
+
+    HeaderTable();
+
+    void set(const std::string& name, const std::string& value);
+    void add(const std::string& name, const std::string& value);
+    void remove(const std::string& name);
+    // Premiere occurrence, "" si absent
+    std::string get(const std::string& name) const;
+    bool has(const std::string& name) const;
+
+    size_t size() const;
+    const Entry& entry(size_t index) const;
+    void clear();
+    void swap(HeaderTable& other);
+
+private:
+    // Indice de la premiere occurrence, -1 si absent
+    int find(HeaderId id, const std::string& name) const;
+
+    std::vector<Entry> _entries;
+};
+
+#endif
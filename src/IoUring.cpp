@@ -0,0 +1,180 @@
+// IoUring.cpp
+#include "IoUring.hpp"
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#include <cerrno>
+
+// Memes numeros sur toutes les architectures sauf alpha
+#ifndef __NR_io_uring_setup
+# define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+# define __NR_io_uring_enter 426
+#endif
+#ifndef __NR_io_uring_register
+# define __NR_io_uring_register 427
+#endif
+
+IoUring::IoUring()
+    : _fd(-1), _sqRing(MAP_FAILED), _sqRingSize(0), _cqRing(MAP_FAILED), _cqRingSize(0),
+      _sqes(NULL), _sqesSize(0), _sqHead(NULL), _sqTail(NULL), _sqMask(0), _sqEntries(0),
+      _sqLocalTail(0), _sqSubmitted(0), _cqHead(NULL), _cqTail(NULL), _cqMask(0), _cqEntries(0), _cqes(NULL) {}
+
+IoUring::~IoUring() {
+    close();
+}
+
+bool IoUring::setup(unsigned entries, unsigned files, int eventFd) {
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd == -1) {
+        return false;
+    }
+    _fd = fd;
+
+    _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single && _cqRingSize > _sqRingSize) {
+        _sqRingSize = _cqRingSize;
+    }
+    _sqRing = mmap(NULL, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (_sqRing == MAP_FAILED) {
+        close();
+        return false;
+    }
+    if (single) {
+        _cqRing = _sqRing;
+        _cqRingSize = 0; // Une seule projection a defaire
+    } else {
+        _cqRing = mmap(NULL, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (_cqRing == MAP_FAILED) {
+            close();
+            return false;
+        }
+    }
+    _sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(NULL, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        close();
+        return false;
+    }
+    _sqes = static_cast<struct io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(_sqRing);
+    _sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    _sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    _sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    _sqEntries = params.sq_entries;
+    // Indirection SQ identite : l'entree i de la ring designe la SQE i
+    unsigned* array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    for (unsigned i = 0; i < _sqEntries; ++i) {
+        array[i] = i;
+    }
+    _sqLocalTail = *_sqTail;
+    _sqSubmitted = _sqLocalTail;
+
+    char* cq = static_cast<char*>(_cqRing);
+    _cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    _cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    _cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    _cqEntries = params.cq_entries;
+    _cqes = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // Table creuse (5.19+) : les openat y installent leur fichier directement
+    struct io_uring_rsrc_register table;
+    std::memset(&table, 0, sizeof(table));
+    table.nr = files;
+    table.flags = IORING_RSRC_REGISTER_SPARSE;
+    if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_FILES2, &table, sizeof(table)) == -1
+        || syscall(__NR_io_uring_register, fd, IORING_REGISTER_EVENTFD, &eventFd, 1) == -1) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool IoUring::ready() const {
+    return _fd != -1;
+}
+
+void IoUring::close() {
+    if (_sqes != NULL) {
+        munmap(_sqes, _sqesSize);
+        _sqes = NULL;
+    }
+    if (_cqRing != MAP_FAILED && _cqRing != _sqRing) {
+        munmap(_cqRing, _cqRingSize);
+    }
+    _cqRing = MAP_FAILED;
+    if (_sqRing != MAP_FAILED) {
+        munmap(_sqRing, _sqRingSize);
+        _sqRing = MAP_FAILED;
+    }
+    if (_fd != -1) {
+        ::close(_fd);
+        _fd = -1;
+    }
+}
+
+struct io_uring_sqe* IoUring::sqe() {
+    if (sqSpace() == 0) {
+        return NULL;
+    }
+    struct io_uring_sqe* entry = &_sqes[_sqLocalTail & _sqMask];
+    ++_sqLocalTail;
+    std::memset(entry, 0, sizeof(*entry));
+    return entry;
+}
+
+unsigned IoUring::sqSpace() const {
+    if (_fd == -1) {
+        return 0;
+    }
+    unsigned head = __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+    return _sqEntries - (_sqLocalTail - head);
+}
+
+unsigned IoUring::cqEntries() const {
+    return _cqEntries;
+}
+
+int IoUring::submit(unsigned wait) {
+    if (_fd == -1) {
+        return -1;
+    }
+    unsigned count = _sqLocalTail - _sqSubmitted;
+    if (count == 0 && wait == 0) {
+        return 0;
+    }
+    // Les SQE ecrites avant la publication de la queue
+    __atomic_store_n(_sqTail, _sqLocalTail, __ATOMIC_RELEASE);
+    unsigned flags = (wait > 0) ? IORING_ENTER_GETEVENTS : 0;
+    long submitted;
+    do {
+        submitted = syscall(__NR_io_uring_enter, _fd, count, wait, flags, NULL, 0);
+    } while (submitted == -1 && errno == EINTR);
+    if (submitted == -1) {
+        return -1;
+    }
+    _sqSubmitted += static_cast<unsigned>(submitted);
+    return static_cast<int>(submitted);
+}
+
+bool IoUring::reap(unsigned long& userData, int& result) {
+    if (_fd == -1) {
+        return false;
+    }
+    unsigned head = *_cqHead;
+    if (head == __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    const struct io_uring_cqe& cqe = _cqes[head & _cqMask];
+    userData = static_cast<unsigned long>(cqe.user_data);
+    result = cqe.res;
+    __atomic_store_n(_cqHead, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
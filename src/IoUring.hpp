@@ -0,0 +1,64 @@
+// IoUring.hpp
+#ifndef IOURING_HPP
+#define IOURING_HPP
+
+#include <linux/io_uring.h>
+#include <cstddef>
+
+#define IO_URING_ENTRIES 256 // SQE ; le noyau double pour la file de completion
+#define IO_URING_FILES 64    // Descripteurs fixes : fichiers ouverts en meme temps par la ring
+
+/*
+ * io_uring minimal par appels systeme directs (pas de liburing) : les
+ * rings sont mappees une fois, les SQE preparees s'accumulent et partent
+ * ensemble au prochain submit(). Table de descripteurs fixes creuse, pour
+ * que openat/write/close d'une meme chaine se referencent sans fd.
+ * Un seul thread l'utilise (la boucle principale).
+ */
+class IoUring {
+public:
+    IoUring();
+    ~IoUring();
+
+    // false si le noyau n'a pas io_uring (ENOSYS, seccomp, table creuse non geree) ;
+    // `eventFd` est signale a chaque completion
+    bool setup(unsigned entries, unsigned files, int eventFd);
+    bool ready() const;
+    void close();
+
+    // SQE suivante, remise a zero ; NULL si la file est pleine
+    struct io_uring_sqe* sqe();
+    unsigned sqSpace() const;
+    unsigned cqEntries() const;
+    // Un io_uring_enter pour toutes les SQE preparees ; `wait` completions attendues
+    int submit(unsigned wait = 0);
+    // Completion suivante, false si aucune
+    bool reap(unsigned long& userData, int& result);
+
+private:
+    IoUring(const IoUring&);
+    IoUring& operator=(const IoUring&);
+
+    int _fd;
+    void* _sqRing;
+    size_t _sqRingSize;
+    void* _cqRing;
+    size_t _cqRingSize;
+    struct io_uring_sqe* _sqes;
+    size_t _sqesSize;
+
+    unsigned* _sqHead;
+    unsigned* _sqTail;
+    unsigned _sqMask;
+    unsigned _sqEntries;
+    unsigned _sqLocalTail;  // SQE preparees, publiees par submit()
+    unsigned _sqSubmitted;
+
+    unsigned* _cqHead;
+    unsigned* _cqTail;
+    unsigned _cqMask;
+    unsigned _cqEntries;
+    struct io_uring_cqe* _cqes;
+};
+
+#endif
@@ -0,0 +1,69 @@
+// LatencyHistogram.cpp
+#include "LatencyHistogram.hpp"
+
+LatencyHistogram::LatencyHistogram() : _count(0), _sumNs(0), _maxNs(0) {
+    for (size_t i = 0; i < LATENCY_BUCKETS; ++i) {
+        _counts[i] = 0;
+    }
+}
+
+// Valeurs < LATENCY_SUB_BUCKETS exactes ; sinon les 4 bits sous le bit de poids fort choisissent la tranche
+size_t LatencyHistogram::index(unsigned long ns) {
+    if (ns < LATENCY_SUB_BUCKETS) {
+        return ns;
+    }
+    int shift = static_cast<int>(sizeof(unsigned long) * 8) - __builtin_clzl(ns) - 5;
+    if (shift >= LATENCY_MAGNITUDES) {
+        return LATENCY_BUCKETS - 1;
+    }
+    return LATENCY_SUB_BUCKETS + shift * LATENCY_SUB_BUCKETS + ((ns >> shift) - LATENCY_SUB_BUCKETS);
+}
+
+unsigned long LatencyHistogram::upper(size_t index) {
+    if (index < LATENCY_SUB_BUCKETS) {
+        return index;
+    }
+    size_t shift = (index - LATENCY_SUB_BUCKETS) / LATENCY_SUB_BUCKETS;
+    size_t sub = (index - LATENCY_SUB_BUCKETS) % LATENCY_SUB_BUCKETS;
+    return ((LATENCY_SUB_BUCKETS + sub + 1UL) << shift) - 1;
+}
+
+void LatencyHistogram::record(unsigned long ns) {
+    ++_counts[index(ns)];
+    ++_count;
+    _sumNs += ns;
+    if (ns > _maxNs) {
+        _maxNs = ns;
+    }
+}
+
+unsigned long LatencyHistogram::count() const {
+    return _count;
+}
+
+unsigned long LatencyHistogram::sumNs() const {
+    return _sumNs;
+}
+
+unsigned long LatencyHistogram::maxNs() const {
+    return _maxNs;
+}
+
+unsigned long LatencyHistogram::quantileNs(double q) const {
+    if (_count == 0) {
+        return 0;
+    }
+    unsigned long rank = static_cast<unsigned long>(q * _count);
+    if (rank >= _count) {
+        rank = _count - 1;
+    }
+    unsigned long seen = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS; ++i) {
+        seen += _counts[i];
+        if (seen > rank) {
+            unsigned long bound = upper(i);
+            return bound < _maxNs ? bound : _maxNs;
+        }
+    }
+    return _maxNs;
+}
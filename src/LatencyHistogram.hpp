@@ -0,0 +1,38 @@
+// LatencyHistogram.hpp
+#ifndef LATENCYHISTOGRAM_HPP
+#define LATENCYHISTOGRAM_HPP
+
+#include <cstddef>
+
+#define LATENCY_SUB_BUCKETS 16 // Par puissance de 2 : erreur relative ~6 %
+#define LATENCY_MAGNITUDES 36  // ns exactes jusqu'a 16, puis jusqu'a 2^40 ns (~18 min), au-dela bornees
+#define LATENCY_BUCKETS (LATENCY_SUB_BUCKETS * (LATENCY_MAGNITUDES + 1))
+
+/*
+ * Histogramme log-lineaire facon HdrHistogram : chaque puissance de 2
+ * est coupee en LATENCY_SUB_BUCKETS tranches egales, la precision est
+ * donc relative et constante de la ns a la minute. Taille fixe, pas
+ * d'allocation a l'enregistrement.
+ */
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(unsigned long ns);
+    unsigned long count() const;
+    unsigned long sumNs() const;
+    unsigned long maxNs() const;
+    // Borne haute du bucket qui contient le quantile `q` (0..1), sans depasser le maximum observe
+    unsigned long quantileNs(double q) const;
+
+private:
+    static size_t index(unsigned long ns);
+    static unsigned long upper(size_t index);
+
+    unsigned long _counts[LATENCY_BUCKETS];
+    unsigned long _count;
+    unsigned long _sumNs;
+    unsigned long _maxNs;
+};
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef LISTENDIRECTIVE_HPP
+#define LISTENDIRECTIVE_HPP
+
+#include <string>
+
+// Une directive `listen [address:]port [options];`
+// address : IPv4, [IPv6] ou nom d'hote ; vide ou "*" = toutes les interfaces IPv4
+struct ListenDirective {
+	std::string host;
+	int port;
+	int backlog;		// backlog=N (defaut SOMAXCONN)
+	bool reusePort;		// reuseport : SO_REUSEPORT
+	int deferAccept;	// deferred / deferred=N : TCP_DEFER_ACCEPT (secondes)
+	int fastOpen;		// fastopen=N : TCP_FASTOPEN (taille de la file)
+	bool defaultServer;	// default_server : server par defaut du listener
+	bool hasOptions;
+
+	ListenDirective() : port(0), backlog(-1), reusePort(false), deferAccept(0), fastOpen(0),
+		defaultServer(false), hasOptions(false) {}
+};
+
+#endif
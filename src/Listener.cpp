@@ -0,0 +1,53 @@
+// Listener.cpp
+#include "Listener.hpp"
+#include "Logger.hpp"
+#include "Utils.hpp"
+#include <netdb.h>
+
+Listener::Listener(const std::string& key, const ListenDirective& listen) : _key(key), _listen(listen), _socket(NULL) {}
+
+Listener::~Listener() {
+    delete _socket;
+}
+
+std::string Listener::makeKey(ListenDirective& listen) {
+    sockaddr_storage addr;
+    socklen_t len;
+    if (!Socket::resolveAddress(listen.host, listen.port, addr, len)) {
+        return listen.host + ":" + to_string(listen.port);
+    }
+    // Adresse numerique : open() et les reloads suivants ne refont pas de requete DNS
+    char numeric[NI_MAXHOST];
+    if (getnameinfo(reinterpret_cast<sockaddr*>(&addr), len, numeric, sizeof(numeric), NULL, 0, NI_NUMERICHOST) == 0) {
+        listen.host = numeric;
+    }
+    return Socket::formatAddress(addr) + ":" + to_string(listen.port);
+}
+
+bool Listener::open() {
+    _socket = new Socket(_listen);
+    _socket->build_sockets();
+    if (_socket->getSocket() == -1) {
+        Logger::instance().log(ERROR, "Unable to open listener " + _key);
+        return false;
+    }
+    Logger::instance().log(INFO, "Listener " + _key + " opened on FD " + to_string(_socket->getSocket()));
+    return true;
+}
+
+void Listener::adopt(int fd) {
+    _socket = new Socket(_listen, fd);
+    Logger::instance().log(INFO, "Listener " + _key + " inherited on FD " + to_string(fd));
+}
+
+int Listener::getFd() const {
+    return _socket ? _socket->getSocket() : -1;
+}
+
+const std::string& Listener::getKey() const {
+    return _key;
+}
+
+const ListenDirective& Listener::getListen() const {
+    return _listen;
+}
@@ -0,0 +1,39 @@
+// Listener.hpp
+#ifndef LISTENER_HPP
+#define LISTENER_HPP
+
+#include "Socket.hpp"
+#include "ListenDirective.hpp"
+#include <string>
+
+/*
+ * Un Listener correspond a un couple address:port unique et survit aux
+ * reloads de configuration tant qu'une directive listen y fait reference.
+ * Le choix du server (header Host) est fait par le ConfigSnapshot.
+ */
+class Listener {
+public:
+    Listener(const std::string& key, const ListenDirective& listen);
+    ~Listener();
+
+    // Cle canonique "address:port" (adresse resolue), pour dedupliquer les listeners ;
+    // listen.host est remplace par l'adresse numerique
+    static std::string makeKey(ListenDirective& listen);
+
+    bool open();
+    void adopt(int fd); // Socket heritee de l'ancien processus, deja bindee et en ecoute
+
+    int getFd() const;
+    const std::string& getKey() const;
+    const ListenDirective& getListen() const;
+
+private:
+    Listener(const Listener&);
+    Listener& operator=(const Listener&);
+
+    std::string _key;
+    ListenDirective _listen;
+    Socket* _socket;
+};
+
+#endif
@@ -16,8 +16,10 @@ struct Location {
 	std::string uploadPath;
 	bool uploadOn;
 	int autoindex;
+	std::string autoindexFormat; // Vide : celui du server
+	bool stubStatus; // Compteurs du serveur (Metrics) au lieu des fichiers
 
-	Location() : clientMaxBodySize(-1), returnCode(0), uploadOn(false), autoindex(-1) {}
+	Location() : clientMaxBodySize(-1), returnCode(0), uploadOn(false), autoindex(-1), stubStatus(false) {}
 };
 
 #endif
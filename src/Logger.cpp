@@ -12,6 +12,7 @@ Logger& Logger::instance() {
 }
 
 Logger::Logger() : repeatCount(0), logToStderr(false) {
+    pthread_key_create(&_captureKey, NULL);
     struct stat st;
     if (stat("logs", &st) != 0) {
         mkdir("logs", 0755);
@@ -38,14 +39,17 @@ Logger::Logger() : repeatCount(0), logToStderr(false) {
     std::string infoFilename = _logsDir + "/info.log";
     std::string warningFilename = _logsDir + "/warning.log";
     std::string errorFilename = _logsDir + "/error.log";
+    std::string accessFilename = _logsDir + "/access.log";
 
-	debugFile.open(debugFilename.c_str(), std::ofstream::out | std::ofstream::trunc);
-    infoFile.open(infoFilename.c_str(), std::ofstream::out | std::ofstream::trunc);
-    warningFile.open(warningFilename.c_str(), std::ofstream::out | std::ofstream::trunc);
-    errorFile.open(errorFilename.c_str(), std::ofstream::out | std::ofstream::trunc);
+    // Ajout plutot que troncature : apres un binary upgrade, les deux processus peuvent partager le repertoire
+	debugFile.open(debugFilename.c_str(), std::ofstream::out | std::ofstream::app);
+    infoFile.open(infoFilename.c_str(), std::ofstream::out | std::ofstream::app);
+    warningFile.open(warningFilename.c_str(), std::ofstream::out | std::ofstream::app);
+    errorFile.open(errorFilename.c_str(), std::ofstream::out | std::ofstream::app);
+    accessFile.open(accessFilename.c_str(), std::ofstream::out | std::ofstream::app);
 
     // Vérifier si tous les fichiers sont ouverts avec succès
-    if (!debugFile.is_open() || !infoFile.is_open() || !warningFile.is_open() || !errorFile.is_open()) {
+    if (!debugFile.is_open() || !infoFile.is_open() || !warningFile.is_open() || !errorFile.is_open() || !accessFile.is_open()) {
         std::cerr << "Erreur lors de l'ouverture des fichiers de log. Les logs seront redirigés vers std::cerr." << std::endl;
         logToStderr = true;
 
@@ -54,6 +58,7 @@ Logger::Logger() : repeatCount(0), logToStderr(false) {
         if (infoFile.is_open()) infoFile.close();
         if (warningFile.is_open()) warningFile.close();
         if (errorFile.is_open()) errorFile.close();
+        if (accessFile.is_open()) accessFile.close();
     } else {
         this->log(INFO, std::string("Starting Program logs at : ") + timestamp);
     }
@@ -62,42 +67,54 @@ Logger::Logger() : repeatCount(0), logToStderr(false) {
 #include <iostream>
 #include <string>
 #include <cstdio> // pour std::remove
+#include <unistd.h> // pour isatty
 
 Logger::~Logger() {
-    std::string user_input;
+    std::string user_input = "k";
 
-    // Boucle pour valider l'entrée
-    while (true) {
+    // Question posee seulement en interactif : sous un superviseur (stdin non tty), les logs sont gardes
+    while (isatty(STDIN_FILENO)) {
         std::cout << "Would you like to [K]eep this session logs or [D]elete? (d/k): ";
-        std::getline(std::cin, user_input);
-
+        if (!std::getline(std::cin, user_input)) {
+            user_input = "k";
+            break;
+        }
         if (user_input == "d" || user_input == "D" || user_input == "k" || user_input == "K") {
-            if (debugFile.is_open())
-                debugFile.close();
-            if (infoFile.is_open())
-                infoFile.close();
-            if (warningFile.is_open())
-                warningFile.close();
-            if (errorFile.is_open())
-                errorFile.close();
-            if (user_input == "d" || user_input == "D") {
-                if (std::remove(std::string(_logsDir + "/debug.log").c_str()) == 0)
-                    std::cout << "Debug log deleted successfully.\n";
-                if (std::remove(std::string(_logsDir + "/info.log").c_str()) == 0)
-                    std::cout << "Info log deleted successfully.\n";
-                if (std::remove(std::string(_logsDir + "/warning.log").c_str()) == 0)
-                    std::cout << "Warning log deleted successfully.\n";
-                if (std::remove(std::string(_logsDir + "/error.log").c_str()) == 0)
-                    std::cout << "Error log deleted successfully.\n";
-                break;
-            } else {
-                std::cout << "Invalid option. Please enter 'd' to delete or 'k' to keep.\n";
-            }
+            break;
         }
+        std::cout << "Invalid option. Please enter 'd' to delete or 'k' to keep.\n";
+    }
+
+    if (debugFile.is_open())
+        debugFile.close();
+    if (infoFile.is_open())
+        infoFile.close();
+    if (warningFile.is_open())
+        warningFile.close();
+    if (errorFile.is_open())
+        errorFile.close();
+    if (accessFile.is_open())
+        accessFile.close();
+    if (user_input == "d" || user_input == "D") {
+        if (std::remove(std::string(_logsDir + "/debug.log").c_str()) == 0)
+            std::cout << "Debug log deleted successfully.\n";
+        if (std::remove(std::string(_logsDir + "/info.log").c_str()) == 0)
+            std::cout << "Info log deleted successfully.\n";
+        if (std::remove(std::string(_logsDir + "/warning.log").c_str()) == 0)
+            std::cout << "Warning log deleted successfully.\n";
+        if (std::remove(std::string(_logsDir + "/error.log").c_str()) == 0)
+            std::cout << "Error log deleted successfully.\n";
+        if (std::remove(std::string(_logsDir + "/access.log").c_str()) == 0)
+            std::cout << "Access log deleted successfully.\n";
     }
 }
 
 void Logger::log(LoggerLevel level, const std::string& message) {
+    Captured* sink = static_cast<Captured*>(pthread_getspecific(_captureKey));
+    if (sink != NULL) {
+        sink->push_back(std::make_pair(level, message));
+        return;
+    }
     if (repeatCount == 0) {
         std::string output = getLevelString(level) + ": " + message + "\n";
         writeToLogs(level, output);
@@ -129,6 +146,19 @@ void Logger::log(LoggerLevel level, const std::string& message) {
     }
 }
 
+void Logger::access(const std::string& line) {
+    if (logToStderr) {
+        std::cerr << line << '\n';
+        return;
+    }
+    accessFile << line << '\n';
+    accessFile.flush();
+}
+
+void Logger::capture(Captured* sink) {
+    pthread_setspecific(_captureKey, sink);
+}
+
 std::string Logger::getLevelString(LoggerLevel level) {
     switch (level) {
         case DEBUG:   return "DEBUG";
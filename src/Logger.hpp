@@ -13,6 +13,9 @@
  * - WARNING : écrit dans warning.log, info.log, et debug.log
  * - INFO : écrit dans info.log et debug.log
  * - DEBUG : écrit uniquement dans debug.log
+ *
+ * `access()` écrit une ligne par requête servie dans access.log,
+ * hors cascade et sans regroupement des lignes répétées.
  * 
  * La classe propose deux principales méthodes d’écriture:
  * 
@@ -72,6 +75,8 @@
 #include <fstream>
 #include <iostream>
 #include <vector>
+#include <utility>
+#include <pthread.h>
 
 class Logger {
 public:
@@ -106,6 +111,13 @@ public:
 
     // Méthode pour enregistrer un message avec un niveau spécifique
     void log(LoggerLevel level, const std::string& message);
+    // Une ligne par requete servie (RequestTrace::accessLine)
+    void access(const std::string& line);
+
+    typedef std::vector<std::pair<LoggerLevel, std::string> > Captured;
+    // Messages du thread appelant retenus dans `sink` au lieu d'etre ecrits, jusqu'a capture(NULL) :
+    // un job du DiskPool les confie ainsi au thread principal, qui les rejoue par log()
+    void capture(Captured* sink);
 
 
     template <typename T>
@@ -155,6 +167,7 @@ private:
     std::ofstream infoFile;
     std::ofstream warningFile;
     std::ofstream errorFile;
+    std::ofstream accessFile;
 
     std::string lastMessage;
     LoggerLevel lastLevel;
@@ -163,6 +176,7 @@ private:
     std::string _logsDir;
 
 	bool logToStderr;
+    pthread_key_t _captureKey;
 };
 
 #endif // LOGGER_HPP
@@ -0,0 +1,267 @@
+// Metrics.cpp
+#include "Metrics.hpp"
+#include "ConnectionTable.hpp"
+#include "FsStats.hpp"
+#include "AllocStats.hpp"
+#include "Utils.hpp"
+#include <cstdio>
+#include <map>
+
+namespace {
+    struct Histogram {
+        unsigned long count;
+        unsigned long sumNs;
+        unsigned long buckets[FS_HISTOGRAM_BUCKETS]; // Memes bornes que FsStats
+    };
+
+    const ConnectionTable* g_connections = NULL;
+    unsigned long g_accepted = 0;
+    unsigned long g_rejected[REJECT_COUNT] = { 0, 0 };
+    unsigned long g_bytesIn = 0;
+    unsigned long g_bytesOut = 0;
+    unsigned long g_statusClasses[6] = { 0, 0, 0, 0, 0, 0 }; // 1xx..5xx, [0] : code hors classes
+    Histogram g_requests;
+    unsigned long g_cgiSpawns = 0;
+    Histogram g_cgi;
+    unsigned long g_cacheHits[CACHE_COUNT] = { 0, 0 };
+    unsigned long g_cacheMisses[CACHE_COUNT] = { 0, 0 };
+    unsigned long g_uploadBytes = 0;
+
+    const char* g_cacheNames[CACHE_COUNT] = { "error_page", "autoindex" };
+    const char* g_rejectNames[REJECT_COUNT] = { "worker_connections", "nofile" };
+
+    struct LocationTimings {
+        LatencyHistogram phases[PHASE_COUNT];
+    };
+    // Cles issues de la configuration : nombre borne
+    std::map<std::pair<std::string, std::string>, LocationTimings> g_locations;
+
+    void record(Histogram& h, unsigned long ns) {
+        unsigned long us = ns / 1000;
+        int index = 0;
+        while (index < FS_HISTOGRAM_BUCKETS - 1 && us >= (1UL << index)) {
+            ++index;
+        }
+        ++h.buckets[index];
+        ++h.count;
+        h.sumNs += ns;
+    }
+
+    std::string seconds(unsigned long ns) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.9g", static_cast<double>(ns) / 1e9);
+        return buffer;
+    }
+
+    // Valeur de label : '\\', '"' et saut de ligne echappes
+    std::string label(const char* name, const std::string& value) {
+        std::string out = name;
+        out += "=\"";
+        for (size_t i = 0; i < value.size(); ++i) {
+            if (value[i] == '\\' || value[i] == '"') {
+                out += '\\';
+                out += value[i];
+            } else if (value[i] == '\n') {
+                out += "\\n";
+            } else {
+                out += value[i];
+            }
+        }
+        out += '"';
+        return out;
+    }
+
+    void header(std::string& out, const char* name, const char* type, const char* help) {
+        out += "# HELP ";
+        out += name;
+        out += ' ';
+        out += help;
+        out += "\n# TYPE ";
+        out += name;
+        out += ' ';
+        out += type;
+        out += '\n';
+    }
+
+    void sample(std::string& out, const char* name, const std::string& labels, const std::string& value) {
+        out += name;
+        if (!labels.empty()) {
+            out += '{';
+            out += labels;
+            out += '}';
+        }
+        out += ' ';
+        out += value;
+        out += '\n';
+    }
+
+    // Buckets cumulatifs ; les bornes sont les puissances de 2 en microsecondes
+    void histogram(std::string& out, const char* name, const std::string& labels,
+                   const unsigned long* buckets, unsigned long count, unsigned long sumNs) {
+        std::string prefix = labels.empty() ? "" : labels + ",";
+        std::string bucketName = std::string(name) + "_bucket";
+        unsigned long cumulative = 0;
+        for (int i = 0; i < FS_HISTOGRAM_BUCKETS - 1; ++i) {
+            cumulative += buckets[i];
+            sample(out, bucketName.c_str(), prefix + "le=\"" + seconds((1UL << i) * 1000) + "\"", to_string(cumulative));
+        }
+        sample(out, bucketName.c_str(), prefix + "le=\"+Inf\"", to_string(count));
+        sample(out, (std::string(name) + "_sum").c_str(), labels, seconds(sumNs));
+        sample(out, (std::string(name) + "_count").c_str(), labels, to_string(count));
+    }
+}
+
+namespace Metrics {
+
+void watch(const ConnectionTable* connections) {
+    g_connections = connections;
+}
+
+void connectionAccepted() {
+    ++g_accepted;
+}
+
+void connectionRejected(MetricsReject reason) {
+    ++g_rejected[reason];
+}
+
+void bytesIn(size_t bytes) {
+    g_bytesIn += bytes;
+}
+
+void bytesOut(size_t bytes) {
+    g_bytesOut += bytes;
+}
+
+void requestServed(int statusCode) {
+    int statusClass = statusCode / 100;
+    ++g_statusClasses[(statusClass >= 1 && statusClass <= 5) ? statusClass : 0];
+}
+
+void requestDuration(unsigned long ns) {
+    record(g_requests, ns);
+}
+
+void cgiSpawned() {
+    ++g_cgiSpawns;
+}
+
+void cgiDuration(unsigned long ns) {
+    record(g_cgi, ns);
+}
+
+void cacheLookup(MetricsCache cache, bool hit) {
+    ++(hit ? g_cacheHits : g_cacheMisses)[cache];
+}
+
+void uploadBytes(size_t bytes) {
+    g_uploadBytes += bytes;
+}
+
+void requestTraced(const std::string& server, const std::string& location, const RequestTrace& trace) {
+    LocationTimings& timings = g_locations[std::make_pair(server, location)];
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        if (trace.has(static_cast<TracePhase>(p))) {
+            timings.phases[p].record(trace.phase(static_cast<TracePhase>(p)));
+        }
+    }
+}
+
+void render(std::string& out) {
+    out.reserve(16384);
+
+    unsigned long reading = 0;
+    unsigned long writing = 0;
+    unsigned long idle = 0;
+    unsigned long active = 0;
+    for (size_t s = 0; g_connections != NULL && s < g_connections->capacity(); ++s) {
+        const Connection* conn = g_connections->slot(s);
+        if (!conn->inUse) {
+            continue;
+        }
+        ++active;
+        if (conn->timer.phase == TIMER_SEND) {
+            ++writing;
+        } else if (conn->timer.phase == TIMER_KEEPALIVE) {
+            ++idle;
+        } else {
+            ++reading;
+        }
+    }
+    header(out, "webserv_connections", "gauge", "Client connections by state.");
+    sample(out, "webserv_connections", "state=\"active\"", to_string(active));
+    sample(out, "webserv_connections", "state=\"reading\"", to_string(reading));
+    sample(out, "webserv_connections", "state=\"writing\"", to_string(writing));
+    sample(out, "webserv_connections", "state=\"idle\"", to_string(idle));
+    header(out, "webserv_connections_accepted_total", "counter", "Accepted client connections.");
+    sample(out, "webserv_connections_accepted_total", "", to_string(g_accepted));
+    header(out, "webserv_connections_rejected_total", "counter", "Connections answered 503 and closed at accept, by reason.");
+    for (int r = 0; r < REJECT_COUNT; ++r) {
+        sample(out, "webserv_connections_rejected_total", std::string("reason=\"") + g_rejectNames[r] + "\"", to_string(g_rejected[r]));
+    }
+
+    header(out, "webserv_requests_total", "counter", "Responses sent, by status class.");
+    static const char* classes[6] = { "other", "1xx", "2xx", "3xx", "4xx", "5xx" };
+    for (int i = 1; i <= 6; ++i) {
+        int index = i % 6; // "other" en dernier
+        sample(out, "webserv_requests_total", std::string("class=\"") + classes[index] + "\"", to_string(g_statusClasses[index]));
+    }
+    header(out, "webserv_request_duration_seconds", "histogram", "From the first request byte to the last response byte.");
+    histogram(out, "webserv_request_duration_seconds", "", g_requests.buckets, g_requests.count, g_requests.sumNs);
+
+    header(out, "webserv_received_bytes_total", "counter", "Bytes read from client sockets.");
+    sample(out, "webserv_received_bytes_total", "", to_string(g_bytesIn));
+    header(out, "webserv_sent_bytes_total", "counter", "Bytes written to client sockets.");
+    sample(out, "webserv_sent_bytes_total", "", to_string(g_bytesOut));
+    header(out, "webserv_upload_bytes_total", "counter", "Bytes of uploaded files written to disk.");
+    sample(out, "webserv_upload_bytes_total", "", to_string(g_uploadBytes));
+
+    header(out, "webserv_cgi_spawns_total", "counter", "CGI processes started.");
+    sample(out, "webserv_cgi_spawns_total", "", to_string(g_cgiSpawns));
+    header(out, "webserv_cgi_duration_seconds", "histogram", "CGI run time, fork to exit.");
+    histogram(out, "webserv_cgi_duration_seconds", "", g_cgi.buckets, g_cgi.count, g_cgi.sumNs);
+
+    header(out, "webserv_cache_lookups_total", "counter", "In-memory cache lookups.");
+    for (int c = 0; c < CACHE_COUNT; ++c) {
+        std::string cache = std::string("cache=\"") + g_cacheNames[c] + "\",";
+        sample(out, "webserv_cache_lookups_total", cache + "result=\"hit\"", to_string(g_cacheHits[c]));
+        sample(out, "webserv_cache_lookups_total", cache + "result=\"miss\"", to_string(g_cacheMisses[c]));
+    }
+
+    header(out, "webserv_location_phase_seconds", "summary", "Request phases by server and location (log-linear histograms).");
+    static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+    for (std::map<std::pair<std::string, std::string>, LocationTimings>::const_iterator it = g_locations.begin();
+         it != g_locations.end(); ++it) {
+        std::string where = label("server", it->first.first) + "," + label("location", it->first.second);
+        for (int p = 0; p < PHASE_COUNT; ++p) {
+            const LatencyHistogram& h = it->second.phases[p];
+            std::string labels = where + "," + label("phase", RequestTrace::phaseName(static_cast<TracePhase>(p)));
+            for (size_t q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); ++q) {
+                char quantile[16];
+                std::snprintf(quantile, sizeof(quantile), "%g", quantiles[q]);
+                sample(out, "webserv_location_phase_seconds", labels + ",quantile=\"" + quantile + "\"", seconds(h.quantileNs(quantiles[q])));
+            }
+            sample(out, "webserv_location_phase_seconds_sum", labels, seconds(h.sumNs()));
+            sample(out, "webserv_location_phase_seconds_count", labels, to_string(h.count()));
+        }
+    }
+
+    // Threads du DiskPool compris : lecture des compteurs atomiques de FsStats
+    header(out, "webserv_fs_duration_seconds", "histogram", "Filesystem operation latency.");
+    for (int i = 0; i < FS_OP_COUNT; ++i) {
+        FsOp op = static_cast<FsOp>(i);
+        unsigned long buckets[FS_HISTOGRAM_BUCKETS];
+        for (int b = 0; b < FS_HISTOGRAM_BUCKETS; ++b) {
+            buckets[b] = FsStats::bucket(op, b);
+        }
+        histogram(out, "webserv_fs_duration_seconds", std::string("op=\"") + FsStats::name(op) + "\"",
+                  buckets, FsStats::count(op), FsStats::totalNs(op));
+    }
+
+    if (AllocStats::enabled()) {
+        header(out, "webserv_allocations_total", "counter", "Heap allocations since start.");
+        sample(out, "webserv_allocations_total", "", to_string(AllocStats::allocations()));
+    }
+}
+
+}
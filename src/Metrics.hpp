@@ -0,0 +1,52 @@
+// Metrics.hpp
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include "RequestTrace.hpp"
+#include "LatencyHistogram.hpp"
+#include <string>
+#include <cstddef>
+
+class ConnectionTable;
+
+enum MetricsCache {
+    CACHE_ERROR_PAGE,
+    CACHE_LISTING,
+    CACHE_COUNT
+};
+
+// Connexions refusees a l'accept
+enum MetricsReject {
+    REJECT_LIMIT,  // worker_connections atteint : 503
+    REJECT_NOFILE, // Plus de fd (EMFILE, ENFILE) : 503 via le fd de reserve
+    REJECT_COUNT
+};
+
+/*
+ * Compteurs du serveur, exposes au format texte Prometheus par les
+ * locations `stub_status on;`. Ils ne sont modifies que par la boucle
+ * principale (un seul worker) : increments simples, sans verrou ni
+ * atomique. Les threads du DiskPool ne touchent qu'a FsStats, lu et
+ * agrege ici au moment du scrape, comme l'etat des connexions.
+ */
+namespace Metrics {
+    // Connexions lues au scrape (phase du timer de chaque slot)
+    void watch(const ConnectionTable* connections);
+
+    void connectionAccepted();
+    void connectionRejected(MetricsReject reason);
+    void bytesIn(size_t bytes);
+    void bytesOut(size_t bytes);
+    void requestServed(int statusCode);
+    void requestDuration(unsigned long ns);  // Premier octet recu -> dernier octet envoye
+    void cgiSpawned();
+    void cgiDuration(unsigned long ns);      // fork -> fin du script
+    void cacheLookup(MetricsCache cache, bool hit);
+    void uploadBytes(size_t bytes);
+    // Phases d'une requete terminee, par server (premier server_name) et location ("" : aucune)
+    void requestTraced(const std::string& server, const std::string& location, const RequestTrace& trace);
+
+    void render(std::string& out);
+}
+
+#endif
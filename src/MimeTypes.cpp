@@ -0,0 +1,183 @@
+// MimeTypes.cpp
+#include "MimeTypes.hpp"
+#include <fstream>
+#include <sstream>
+#include <cctype>
+
+#define MIME_INITIAL_SLOTS 128
+
+// FNV-1a sur les octets en minuscules
+static size_t hashExtension(const char* extension, size_t length) {
+    size_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(std::tolower(static_cast<unsigned char>(extension[i])));
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool sameExtension(const std::string& stored, const char* extension, size_t length) {
+    if (stored.size() != length) {
+        return false;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        if (stored[i] != std::tolower(static_cast<unsigned char>(extension[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+MimeTypes::MimeTypes() : _slots(MIME_INITIAL_SLOTS), _count(0) {}
+
+const MimeTypes& MimeTypes::defaults() {
+    static MimeTypes types;
+    if (types.size() == 0) {
+        static const char* builtin[] = {
+            "text/html html htm shtml",
+            "text/css css",
+            "text/plain txt",
+            "text/xml xml",
+            "text/csv csv",
+            "text/markdown md",
+            "application/javascript js mjs",
+            "application/json json map",
+            "application/wasm wasm",
+            "application/pdf pdf",
+            "application/zip zip",
+            "application/gzip gz",
+            "application/x-tar tar",
+            "application/xhtml+xml xhtml",
+            "application/rss+xml rss",
+            "application/atom+xml atom",
+            "application/manifest+json webmanifest",
+            "image/png png",
+            "image/jpeg jpg jpeg",
+            "image/gif gif",
+            "image/webp webp",
+            "image/avif avif",
+            "image/svg+xml svg svgz",
+            "image/x-icon ico",
+            "image/bmp bmp",
+            "image/tiff tif tiff",
+            "font/woff woff",
+            "font/woff2 woff2",
+            "font/ttf ttf",
+            "font/otf otf",
+            "audio/mpeg mp3",
+            "audio/ogg ogg",
+            "audio/wav wav",
+            "audio/aac aac",
+            "video/mp4 mp4",
+            "video/webm webm",
+            "video/ogg ogv",
+            "video/quicktime mov",
+            "video/x-msvideo avi"
+        };
+        for (size_t i = 0; i < sizeof(builtin) / sizeof(builtin[0]); ++i) {
+            types.addLine(builtin[i]);
+        }
+    }
+    return types;
+}
+
+void MimeTypes::add(const std::string& extension, const std::string& type) {
+    if (extension.empty()) {
+        return;
+    }
+    if ((_count + 1) * 2 > _slots.size()) {
+        grow();
+    }
+    size_t mask = _slots.size() - 1;
+    size_t index = hashExtension(extension.data(), extension.size()) & mask;
+    while (!_slots[index].extension.empty()) {
+        if (sameExtension(_slots[index].extension, extension.data(), extension.size())) {
+            _slots[index].type = type;
+            return;
+        }
+        index = (index + 1) & mask;
+    }
+    _slots[index].extension.reserve(extension.size());
+    for (size_t i = 0; i < extension.size(); ++i) {
+        _slots[index].extension += static_cast<char>(std::tolower(static_cast<unsigned char>(extension[i])));
+    }
+    _slots[index].type = type;
+    ++_count;
+}
+
+void MimeTypes::grow() {
+    std::vector<Slot> previous(_slots.size() * 2);
+    previous.swap(_slots);
+    _count = 0;
+    for (size_t i = 0; i < previous.size(); ++i) {
+        if (!previous[i].extension.empty()) {
+            add(previous[i].extension, previous[i].type);
+        }
+    }
+}
+
+bool MimeTypes::addLine(const std::string& line) {
+    std::string entry = line;
+    size_t semicolon = entry.find(';');
+    if (semicolon != std::string::npos) {
+        entry.erase(semicolon);
+    }
+    std::istringstream tokens(entry);
+    std::string type;
+    if (!(tokens >> type) || type.find('/') == std::string::npos) {
+        return false;
+    }
+    std::string extension;
+    while (tokens >> extension) {
+        add(extension, type);
+    }
+    return true;
+}
+
+bool MimeTypes::loadFile(const std::string& path) {
+    std::ifstream file(path.c_str());
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream tokens(line);
+        std::string first;
+        if (!(tokens >> first) || first == "types" || first == "}" || first == "{") {
+            continue;
+        }
+        addLine(line);
+    }
+    return true;
+}
+
+const std::string* MimeTypes::find(const char* extension, size_t length) const {
+    if (length == 0) {
+        return NULL;
+    }
+    size_t mask = _slots.size() - 1;
+    size_t index = hashExtension(extension, length) & mask;
+    while (!_slots[index].extension.empty()) {
+        if (sameExtension(_slots[index].extension, extension, length)) {
+            return &_slots[index].type;
+        }
+        index = (index + 1) & mask;
+    }
+    return NULL;
+}
+
+const std::string* MimeTypes::forPath(const std::string& path) const {
+    size_t dot = path.find_last_of("./");
+    if (dot == std::string::npos || path[dot] != '.') {
+        return NULL;
+    }
+    return find(path.data() + dot + 1, path.size() - dot - 1);
+}
+
+size_t MimeTypes::size() const {
+    return _count;
+}
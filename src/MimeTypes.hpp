@@ -0,0 +1,50 @@
+// MimeTypes.hpp
+#ifndef MIMETYPES_HPP
+#define MIMETYPES_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#define MIME_DEFAULT_TYPE "application/octet-stream"
+
+/*
+ * Extension -> type MIME, table a adressage ouvert (sondage lineaire,
+ * capacite en puissance de 2, remplie au plus a moitie). Les extensions
+ * sont stockees en minuscules et comparees sans tenir compte de la casse :
+ * une recherche ne copie ni n'alloue rien.
+ */
+class MimeTypes {
+public:
+    MimeTypes();
+
+    // Types courants, base de chaque server avant `types {}` / `types_file`
+    static const MimeTypes& defaults();
+
+    // Remplace le type d'une extension deja connue
+    void add(const std::string& extension, const std::string& type);
+    // Ligne "type ext1 ext2;" (format nginx, ';' optionnel comme dans le mime.types d'Apache).
+    // false si la ligne n'a pas de type
+    bool addLine(const std::string& line);
+    // Fichier mime.types : lignes "type ext...", commentaires '#', enveloppe "types { }" ignoree
+    bool loadFile(const std::string& path);
+
+    // NULL si l'extension est inconnue
+    const std::string* find(const char* extension, size_t length) const;
+    // Type selon l'extension du dernier segment de `path`, NULL si inconnue ou absente
+    const std::string* forPath(const std::string& path) const;
+    size_t size() const;
+
+private:
+    struct Slot {
+        std::string extension; // Vide : slot libre
+        std::string type;
+    };
+
+    void grow();
+
+    std::vector<Slot> _slots;
+    size_t _count;
+};
+
+#endif
@@ -0,0 +1,132 @@
+// RequestTrace.cpp
+#include "RequestTrace.hpp"
+#include "HTTPRequest.hpp"
+#include "FsStats.hpp"
+#include "Utils.hpp"
+#include <cstdio>
+#include <ctime>
+
+namespace {
+    const TracePoint g_from[PHASE_COUNT] = {
+        TRACE_FIRST_BYTE, TRACE_HEADERS, TRACE_HANDLER_START, TRACE_HANDLER_END, TRACE_SEND_START, TRACE_FIRST_BYTE
+    };
+    const TracePoint g_to[PHASE_COUNT] = {
+        TRACE_HEADERS, TRACE_HANDLER_START, TRACE_HANDLER_END, TRACE_SEND_START, TRACE_SEND_END, TRACE_SEND_END
+    };
+    const char* g_phaseNames[PHASE_COUNT] = { "header", "body", "handler", "wait", "send", "total" };
+    const char* g_pointNames[TRACE_POINTS] = {
+        "accept", "first byte", "headers", "handler start", "handler end", "first send", "last send"
+    };
+
+    void appendSeconds(std::string& out, unsigned long ns) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%lu.%06lu", ns / 1000000000UL, (ns / 1000) % 1000000UL);
+        out += buffer;
+    }
+
+    // Champ entre guillemets du format combined : '"' et '\' echappes
+    void appendQuoted(std::string& out, const std::string& value) {
+        out += '"';
+        if (value.empty()) {
+            out += '-';
+        }
+        for (size_t i = 0; i < value.size(); ++i) {
+            if (value[i] == '"' || value[i] == '\\') {
+                out += '\\';
+            }
+            out += value[i];
+        }
+        out += '"';
+    }
+}
+
+RequestTrace::RequestTrace() : reused(false) {
+    for (int i = 0; i < TRACE_POINTS; ++i) {
+        at[i] = 0;
+    }
+}
+
+void RequestTrace::next() {
+    for (int i = TRACE_FIRST_BYTE; i < TRACE_POINTS; ++i) {
+        at[i] = 0;
+    }
+    reused = true;
+}
+
+void RequestTrace::mark(TracePoint point) {
+    if (at[point] == 0) {
+        at[point] = FsStats::nowNs();
+    }
+}
+
+bool RequestTrace::has(TracePhase p) const {
+    return at[g_from[p]] != 0 && at[g_to[p]] != 0 && at[g_to[p]] >= at[g_from[p]];
+}
+
+unsigned long RequestTrace::phase(TracePhase p) const {
+    return has(p) ? at[g_to[p]] - at[g_from[p]] : 0;
+}
+
+const char* RequestTrace::phaseName(TracePhase p) {
+    return g_phaseNames[p];
+}
+
+void RequestTrace::accessLine(std::string& out, const std::string& peer, const HTTPRequest& request, int status, size_t bytes) const {
+    char date[40];
+    time_t now = time(NULL);
+    struct tm utc;
+    gmtime_r(&now, &utc); // %z n'existe pas en C++98 : heure UTC
+    std::strftime(date, sizeof(date), "[%d/%b/%Y:%H:%M:%S +0000]", &utc);
+
+    out.reserve(256);
+    out += peer.empty() ? "-" : peer;
+    out += " - - ";
+    out += date;
+    out += " \"";
+    out += request.getMethod();
+    out += ' ';
+    out += request.getPath();
+    if (!request.getQueryString().empty()) {
+        out += '?';
+        out += request.getQueryString();
+    }
+    out += "\" ";
+    out += to_string(status);
+    out += ' ';
+    out += to_string(bytes);
+    out += ' ';
+    appendQuoted(out, request.getStrHeader("Referer"));
+    out += ' ';
+    appendQuoted(out, request.getStrHeader(HEADER_USER_AGENT));
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        out += ' ';
+        out += g_phaseNames[p];
+        out += '=';
+        if (has(static_cast<TracePhase>(p))) {
+            appendSeconds(out, phase(static_cast<TracePhase>(p)));
+        } else {
+            out += '-';
+        }
+    }
+}
+
+void RequestTrace::timeline(std::string& out) const {
+    unsigned long origin = at[TRACE_FIRST_BYTE];
+    for (int i = 0; i < TRACE_POINTS; ++i) {
+        if (i == TRACE_ACCEPT && reused) {
+            continue; // Instant d'une requete precedente
+        }
+        if (!out.empty()) {
+            out += " | ";
+        }
+        out += g_pointNames[i];
+        out += ' ';
+        if (at[i] == 0 || origin == 0) {
+            out += '-';
+        } else if (at[i] < origin) {
+            out += "-" + to_string((origin - at[i]) / 1000) + "us";
+        } else {
+            out += "+" + to_string((at[i] - origin) / 1000) + "us";
+        }
+    }
+}
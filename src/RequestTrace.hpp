@@ -0,0 +1,58 @@
+// RequestTrace.hpp
+#ifndef REQUESTTRACE_HPP
+#define REQUESTTRACE_HPP
+
+#include <string>
+#include <cstddef>
+
+class HTTPRequest;
+
+// Instants d'une requete, dans l'ordre
+enum TracePoint {
+    TRACE_ACCEPT,        // Connexion acceptee (premiere requete seulement)
+    TRACE_FIRST_BYTE,    // Premiere lecture de la requete
+    TRACE_HEADERS,       // Headers parses, server choisi
+    TRACE_HANDLER_START, // Dernier passage dans handleClient, celui qui a complete la requete
+    TRACE_HANDLER_END,   // Reponse confiee au ResponseWriter
+    TRACE_SEND_START,    // Premier octet accepte par la socket
+    TRACE_SEND_END,      // Dernier octet accepte par la socket
+    TRACE_POINTS
+};
+
+// Durees entre deux instants, agregees par location (Metrics)
+enum TracePhase {
+    PHASE_HEADER,   // FIRST_BYTE -> HEADERS
+    PHASE_BODY,     // HEADERS -> HANDLER_START
+    PHASE_HANDLER,  // HANDLER_START -> HANDLER_END (fs, CGI, DiskPool)
+    PHASE_WAIT,     // HANDLER_END -> SEND_START
+    PHASE_SEND,     // SEND_START -> SEND_END
+    PHASE_TOTAL,    // FIRST_BYTE -> SEND_END
+    PHASE_COUNT
+};
+
+/*
+ * Horodatage d'une requete en ns (FsStats::nowNs, CLOCK_MONOTONIC), porte
+ * par la connexion. Un instant a 0 n'a pas ete atteint ; une phase dont
+ * une borne manque vaut 0 et n'est pas comptee.
+ */
+struct RequestTrace {
+    unsigned long at[TRACE_POINTS];
+    bool reused; // Requete suivante d'une connexion keep-alive : TRACE_ACCEPT est ancien
+
+    RequestTrace();
+
+    // Nouvelle requete sur la meme connexion
+    void next();
+    void mark(TracePoint point);
+    bool has(TracePhase phase) const;
+    unsigned long phase(TracePhase phase) const;
+
+    static const char* phaseName(TracePhase phase);
+
+    // Ligne d'access.log : format combined de nginx suivi des durees par phase
+    void accessLine(std::string& out, const std::string& peer, const HTTPRequest& request, int status, size_t bytes) const;
+    // Chronologie lisible, decalages depuis TRACE_FIRST_BYTE
+    void timeline(std::string& out) const;
+};
+
+#endif
@@ -0,0 +1,162 @@
+// ResponseBody.cpp
+#include "ResponseBody.hpp"
+#include "FsStats.hpp"
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+BodySource::BodySource() : _done(false), _buffer(NULL), _bufferStart(0), _bufferEnd(0) {}
+
+BodySource::~BodySource() {
+    delete[] _buffer;
+}
+
+off_t BodySource::size() const {
+    return -1;
+}
+
+bool BodySource::done() const {
+    return _done;
+}
+
+ssize_t BodySource::writeTo(int socketFd) {
+    if (_bufferStart == _bufferEnd) {
+        if (_buffer == NULL) {
+            _buffer = new char[BODY_BUFFER_SIZE];
+        }
+        ssize_t bytesRead = read(_buffer, BODY_BUFFER_SIZE);
+        if (bytesRead <= 0) {
+            _done = (bytesRead == 0);
+            return bytesRead;
+        }
+        _bufferStart = 0;
+        _bufferEnd = bytesRead;
+    }
+    ssize_t bytesWritten = ::write(socketFd, _buffer + _bufferStart, _bufferEnd - _bufferStart);
+    if (bytesWritten > 0) {
+        _bufferStart += bytesWritten;
+    }
+    return bytesWritten;
+}
+
+FileBodySource::FileBodySource(int fd, off_t size) : _fd(fd), _size(size), _offset(0), _sendfile(true) {
+    _done = (_size == 0);
+}
+
+FileBodySource::~FileBodySource() {
+    if (_fd != -1) {
+        close(_fd);
+    }
+}
+
+FileBodySource* FileBodySource::open(const std::string& path) {
+    FsTimer timer(FS_OPEN); // open + fstat
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return NULL;
+    }
+    return new FileBodySource(fd, st.st_size);
+}
+
+off_t FileBodySource::size() const {
+    return _size;
+}
+
+ssize_t FileBodySource::writeTo(int socketFd) {
+    if (!_sendfile) {
+        return BodySource::writeTo(socketFd);
+    }
+    if (_offset >= _size) {
+        _done = true;
+        return 0;
+    }
+    size_t count = static_cast<size_t>(_size - _offset);
+    if (count > BODY_SENDFILE_MAX) {
+        count = BODY_SENDFILE_MAX;
+    }
+    ssize_t bytesWritten = sendfile(socketFd, _fd, &_offset, count);
+    if (bytesWritten == -1 && (errno == EINVAL || errno == ENOSYS)) {
+        _sendfile = false; // sendfile indisponible : copie par tampon jusqu'a la fin
+        return BodySource::writeTo(socketFd);
+    }
+    if (bytesWritten == 0) {
+        _done = true; // Fichier tronque depuis le stat
+    } else if (_offset >= _size) {
+        _done = true;
+    }
+    return bytesWritten;
+}
+
+ssize_t FileBodySource::read(char* buffer, size_t size) {
+    if (_offset >= _size) {
+        return 0; // Ne pas envoyer plus que le Content-Length annonce
+    }
+    if (static_cast<off_t>(size) > _size - _offset) {
+        size = static_cast<size_t>(_size - _offset);
+    }
+    ssize_t bytesRead = pread(_fd, buffer, size, _offset);
+    if (bytesRead > 0) {
+        _offset += bytesRead;
+    }
+    return bytesRead;
+}
+
+SharedBuffer::SharedBuffer() : _refs(1) {}
+
+SharedBuffer::~SharedBuffer() {}
+
+void SharedBuffer::retain() {
+    ++_refs;
+}
+
+void SharedBuffer::release() {
+    if (--_refs == 0) {
+        delete this;
+    }
+}
+
+SharedBodySource::SharedBodySource(SharedBuffer* buffer) : _shared(buffer), _offset(0) {
+    _shared->retain();
+    _done = _shared->data.empty();
+}
+
+SharedBodySource::~SharedBodySource() {
+    _shared->release();
+}
+
+off_t SharedBodySource::size() const {
+    return static_cast<off_t>(_shared->data.size());
+}
+
+ssize_t SharedBodySource::writeTo(int socketFd) {
+    const std::string& data = _shared->data;
+    if (_offset >= data.size()) {
+        _done = true;
+        return 0;
+    }
+    ssize_t bytesWritten = send(socketFd, data.data() + _offset, data.size() - _offset, MSG_NOSIGNAL);
+    if (bytesWritten > 0) {
+        _offset += bytesWritten;
+        _done = (_offset >= data.size());
+    }
+    return bytesWritten;
+}
+
+ssize_t SharedBodySource::read(char* buffer, size_t size) {
+    const std::string& data = _shared->data;
+    size_t count = data.size() - _offset;
+    if (count > size) {
+        count = size;
+    }
+    data.copy(buffer, count, _offset);
+    _offset += count;
+    return static_cast<ssize_t>(count);
+}
@@ -0,0 +1,102 @@
+// ResponseBody.hpp
+#ifndef RESPONSEBODY_HPP
+#define RESPONSEBODY_HPP
+
+#include <string>
+#include <sys/types.h>
+
+#define BODY_BUFFER_SIZE 16384    // Tampon des sources lues par read(), alloue au premier usage
+#define BODY_SENDFILE_MAX 1048576 // Octets max par appel a sendfile
+
+/*
+ * Corps de reponse produit au moment de l'envoi au lieu d'etre copie dans
+ * une std::string : fichier (sendfile, aucune copie en espace utilisateur)
+ * ou tampon partage d'un cache. writeTo() est reprenable : il
+ * ecrit ce que la socket accepte et garde le reste pour l'appel suivant.
+ * Possede par HTTPResponse, detruit avec elle.
+ */
+class BodySource {
+public:
+    BodySource();
+    virtual ~BodySource();
+
+    // Taille totale si connue (Content-Length), -1 sinon : fin signalee par la fermeture
+    virtual off_t size() const;
+    // Octets ecrits (0 possible), -1 en erreur avec errno (EAGAIN : reessayer quand la socket est prete)
+    virtual ssize_t writeTo(int socketFd);
+    bool done() const;
+
+protected:
+    // Remplit jusqu'a `size` octets ; 0 a la fin, -1 en erreur
+    virtual ssize_t read(char* buffer, size_t size) = 0;
+
+    bool _done;
+
+private:
+    BodySource(const BodySource&);
+    BodySource& operator=(const BodySource&);
+
+    char* _buffer; // NULL tant que writeTo() n'est pas passe par read() (sendfile, SharedBodySource)
+    size_t _bufferStart;
+    size_t _bufferEnd;
+};
+
+// Fichier regulier envoye par sendfile depuis le cache de pages
+class FileBodySource : public BodySource {
+public:
+    // Prend possession de fd
+    FileBodySource(int fd, off_t size);
+    ~FileBodySource();
+    // NULL si le fichier ne peut pas etre ouvert
+    static FileBodySource* open(const std::string& path);
+
+    off_t size() const;
+    ssize_t writeTo(int socketFd);
+
+protected:
+    ssize_t read(char* buffer, size_t size);
+
+private:
+    int _fd;
+    off_t _size;
+    off_t _offset;
+    bool _sendfile;
+};
+
+// Contenu immuable partage entre un cache et les envois en cours ; detruit au dernier release()
+class SharedBuffer {
+public:
+    SharedBuffer();
+
+    void retain();
+    void release();
+
+    std::string data;
+
+private:
+    ~SharedBuffer();
+    SharedBuffer(const SharedBuffer&);
+    SharedBuffer& operator=(const SharedBuffer&);
+
+    int _refs;
+};
+
+// Envoie un SharedBuffer directement depuis sa memoire, sans le tampon de BodySource
+class SharedBodySource : public BodySource {
+public:
+    // Retient `buffer` jusqu'a la destruction de la source
+    SharedBodySource(SharedBuffer* buffer);
+    ~SharedBodySource();
+
+    off_t size() const;
+    ssize_t writeTo(int socketFd);
+
+protected:
+    ssize_t read(char* buffer, size_t size);
+
+private:
+    SharedBuffer* _shared;
+    size_t _offset;
+};
+
+#endif
@@ -0,0 +1,239 @@
+// ResponseWriter.cpp
+#include "ResponseWriter.hpp"
+#include "HTTPResponse.hpp"
+#include "Metrics.hpp"
+#include "FsStats.hpp"
+#include <sys/socket.h>
+#include <cstring>
+#include <cerrno>
+
+ResponseWriter::ResponseWriter() : _iovIndex(0), _source(NULL), _statusText(NULL), _statusLength(0), _dateLength(0), _pending(false), _deferred(0) {
+    _sent.status = 0;
+    _sent.bytes = 0;
+    _sent.queuedAt = 0;
+    _sent.firstByteAt = 0;
+    _sent.lastByteAt = 0;
+}
+
+ResponseWriter::~ResponseWriter() {
+    delete _source;
+}
+
+void ResponseWriter::push(const char* data, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    struct iovec iov;
+    iov.iov_base = const_cast<char*>(data);
+    iov.iov_len = length;
+    _iov.push_back(iov);
+}
+
+// Ligne de statut puis Date/Server en cache
+void ResponseWriter::pushStatus(int code, const StatusLine* status) {
+    if (status != NULL) {
+        _statusText = status->line;
+        _statusLength = status->length;
+    } else {
+        // Code hors table : seul cas formate a l'envoi
+        std::memcpy(_statusLine, "HTTP/1.1 ", 9);
+        size_t length = 9;
+        char digits[12];
+        size_t count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + code % 10);
+            code /= 10;
+        } while (code > 0 && count < sizeof(digits));
+        while (count > 0) {
+            _statusLine[length++] = digits[--count];
+        }
+        std::memcpy(_statusLine + length, " Unknown\r\n", 10);
+        _statusText = _statusLine;
+        _statusLength = length + 10;
+    }
+    // Copie : le cache peut changer de seconde pendant un envoi en plusieurs fois
+    _dateLength = DateCache::length();
+    std::memcpy(_dateHeaders, DateCache::headers(), _dateLength);
+
+    push(_statusText, _statusLength);
+    push(_dateHeaders, _dateLength);
+}
+
+// Nouvelle reponse : statut compte, horodatage repris a zero
+void ResponseWriter::begin(int code) {
+    Metrics::requestServed(code);
+    _sent.status = code;
+    _sent.bytes = 0;
+    _sent.queuedAt = FsStats::nowNs();
+    _sent.firstByteAt = 0;
+    _sent.lastByteAt = 0;
+}
+
+void ResponseWriter::wrote(size_t bytes) {
+    if (_sent.firstByteAt == 0) {
+        _sent.firstByteAt = FsStats::nowNs();
+    }
+    _sent.bytes += bytes;
+    Metrics::bytesOut(bytes);
+}
+
+bool ResponseWriter::queue(HTTPResponse& response) {
+    if (_pending) {
+        return false;
+    }
+    _source = response.releaseBodySource(); // Avant swapBody, qui detruirait la source
+    response.swapHeaders(_headers);
+    response.swapBody(_body);
+
+    begin(response.getStatusCode());
+    pushStatus(response.getStatusCode(), response.getStatusLine());
+    for (size_t i = 0; i < _headers.size(); ++i) {
+        const HeaderTable::Entry& entry = _headers.entry(i);
+        push(entry.name.data(), entry.name.size());
+        push(": ", 2);
+        push(entry.value.data(), entry.value.size());
+        push("\r\n", 2);
+    }
+    push("\r\n", 2);
+    push(_body.data(), _body.size());
+    _iovIndex = 0;
+    _pending = true;
+    _deferred = 0;
+    return true;
+}
+
+bool ResponseWriter::queueStatic(int code, const std::string& headers, bool keepAlive, const std::string& body) {
+    static const char keepAliveHeader[] = "Connection: keep-alive\r\n\r\n";
+    static const char closeHeader[] = "Connection: close\r\n\r\n";
+    if (_pending) {
+        return false;
+    }
+    begin(code);
+    pushStatus(code, statusLineFor(code));
+    push(headers.data(), headers.size());
+    if (keepAlive) {
+        push(keepAliveHeader, sizeof(keepAliveHeader) - 1);
+    } else {
+        push(closeHeader, sizeof(closeHeader) - 1);
+    }
+    push(body.data(), body.size());
+    _iovIndex = 0;
+    _pending = true;
+    _deferred = 0;
+    return true;
+}
+
+bool ResponseWriter::queueRaw(std::string& data) {
+    if (_pending) {
+        return false;
+    }
+    _body.swap(data);
+    _statusLength = 0;
+    // Sortie CGI : code lu dans sa ligne de statut "HTTP/1.x NNN"
+    int code = 0;
+    for (size_t i = 9; i < 12 && i < _body.size() && _body[i] >= '0' && _body[i] <= '9'; ++i) {
+        code = code * 10 + (_body[i] - '0');
+    }
+    begin(code);
+    push(_body.data(), _body.size());
+    _iovIndex = 0;
+    _pending = true;
+    _deferred = 0;
+    return true;
+}
+
+ResponseWriter::Status ResponseWriter::flush(int fd) {
+    if (!_pending) {
+        return WRITE_DONE;
+    }
+    while (_iovIndex < _iov.size()) {
+        size_t count = _iov.size() - _iovIndex;
+        if (count > WRITER_IOV_BATCH) {
+            count = WRITER_IOV_BATCH;
+        }
+        // sendmsg plutot que writev : MSG_NOSIGNAL, un client parti ne doit pas tuer le serveur
+        struct msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &_iov[_iovIndex];
+        msg.msg_iovlen = count;
+        ssize_t written = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? WRITE_AGAIN : WRITE_ERROR;
+        }
+        // Reprise : iovecs entierement envoyes sautes, le premier restant est decale
+        size_t remaining = static_cast<size_t>(written);
+        wrote(remaining);
+        while (_iovIndex < _iov.size() && remaining >= _iov[_iovIndex].iov_len) {
+            remaining -= _iov[_iovIndex].iov_len;
+            ++_iovIndex;
+        }
+        if (remaining > 0) {
+            _iov[_iovIndex].iov_base = static_cast<char*>(_iov[_iovIndex].iov_base) + remaining;
+            _iov[_iovIndex].iov_len -= remaining;
+        }
+    }
+    while (_source != NULL && !_source->done()) {
+        ssize_t written = _source->writeTo(fd);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? WRITE_AGAIN : WRITE_ERROR;
+        }
+        wrote(static_cast<size_t>(written));
+    }
+    _sent.lastByteAt = FsStats::nowNs();
+    clear();
+    return WRITE_DONE;
+}
+
+bool ResponseWriter::pending() const {
+    return _pending;
+}
+
+void ResponseWriter::clear() {
+    _iov.clear(); // Capacite conservee pour la reponse suivante
+    _iovIndex = 0;
+    _headers.clear();
+    if (_body.capacity() > WRITER_KEEP_CAPACITY) {
+        std::string().swap(_body); // Ne pas garder le tampon d'un gros listing ou d'une sortie CGI
+    } else {
+        _body.erase();
+    }
+    delete _source;
+    _source = NULL;
+    _statusLength = 0;
+    _pending = false;
+    _deferred = 0;
+}
+
+unsigned long ResponseWriter::defer() {
+    static unsigned long tickets = 0;
+    if (++tickets == 0) {
+        ++tickets; // 0 reste "aucun"
+    }
+    _deferred = tickets;
+    return _deferred;
+}
+
+bool ResponseWriter::deferred() const {
+    return _deferred != 0;
+}
+
+bool ResponseWriter::awaiting(unsigned long ticket) const {
+    return _deferred != 0 && _deferred == ticket;
+}
+
+const ResponseWriter::Sent& ResponseWriter::sent() const {
+    return _sent;
+}
+
+std::string ResponseWriter::statusLine() const {
+    if (_statusLength < 2) {
+        return "";
+    }
+    return std::string(_statusText, _statusLength - 2);
+}
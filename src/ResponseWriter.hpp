@@ -0,0 +1,86 @@
+// ResponseWriter.hpp
+#ifndef RESPONSEWRITER_HPP
+#define RESPONSEWRITER_HPP
+
+#include "HeaderTable.hpp"
+#include "ResponseBody.hpp"
+#include "StatusLine.hpp"
+#include <sys/uio.h>
+#include <string>
+#include <vector>
+
+class HTTPResponse;
+
+#define WRITER_IOV_BATCH 64              // iovecs max par sendmsg (bien en dessous de IOV_MAX)
+#define WRITER_KEEP_CAPACITY (64 * 1024) // Corps conserve d'une reponse a l'autre
+
+/*
+ * Sortie d'une connexion : la reponse est decrite par une liste d'iovecs
+ * (ligne de statut precalculee, Date/Server en cache, fragments de
+ * headers, corps) qui pointent directement dans les headers et le corps
+ * repris a HTTPResponse par echange, sans copie. flush() envoie ce que la socket accepte et reprend au meme
+ * endroit au prochain POLLOUT ; une BodySource eventuelle suit les iovecs.
+ * Un seul envoi en cours a la fois, reutilise d'une requete a l'autre.
+ */
+class ResponseWriter {
+public:
+    enum Status { WRITE_DONE, WRITE_AGAIN, WRITE_ERROR };
+
+    // Derniere reponse, gardee apres l'envoi pour l'access log et RequestTrace (ns, FsStats::nowNs)
+    struct Sent {
+        int status;
+        size_t bytes;
+        unsigned long queuedAt;    // Reponse confiee au writer
+        unsigned long firstByteAt; // Premier octet accepte par la socket, 0 si aucun
+        unsigned long lastByteAt;  // Envoi termine, 0 avant
+    };
+
+    ResponseWriter();
+    ~ResponseWriter();
+
+    // Vide `response` (headers, corps, source) ; false si un envoi est deja en cours
+    bool queue(HTTPResponse& response);
+    // Headers et corps deja serialises (pages d'erreur), non copies : ils doivent survivre a l'envoi.
+    // Connection est choisi ici, pour chaque reponse.
+    bool queueStatic(int code, const std::string& headers, bool keepAlive, const std::string& body);
+    // Octets deja formates (sortie CGI brute), echanges avec `data`
+    bool queueRaw(std::string& data);
+    Status flush(int fd);
+    bool pending() const;
+    void clear();
+
+    // Reponse attendue d'un DiskJob : ticket a lui confier, leve par queue*() ou clear().
+    // Un ticket perime (connexion fermee puis fd reutilise) ne correspond plus a rien.
+    unsigned long defer();
+    bool deferred() const;
+    bool awaiting(unsigned long ticket) const;
+
+    // Pour les logs : ligne de statut sans le CRLF
+    std::string statusLine() const;
+    const Sent& sent() const;
+
+private:
+    ResponseWriter(const ResponseWriter&);
+    ResponseWriter& operator=(const ResponseWriter&);
+
+    void push(const char* data, size_t length);
+    void pushStatus(int code, const StatusLine* status);
+    void begin(int code);
+    void wrote(size_t bytes);
+
+    std::vector<struct iovec> _iov;
+    size_t _iovIndex;    // Premier iovec pas encore entierement envoye
+    HeaderTable _headers;
+    std::string _body;
+    BodySource* _source;
+    const char* _statusText;   // Ligne de la table de StatusLine, ou _statusLine pour un code inconnu
+    size_t _statusLength;
+    char _statusLine[32];
+    char _dateHeaders[DATE_HEADERS_MAX];
+    size_t _dateLength;
+    bool _pending;
+    unsigned long _deferred; // Ticket attendu, 0 si aucun
+    Sent _sent;
+};
+
+#endif
@@ -0,0 +1,394 @@
+// Scan.cpp
+#include "Scan.hpp"
+#include <cstring>
+#include <cstdlib>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define SCAN_X86 1
+# include <immintrin.h>
+#endif
+
+namespace {
+
+struct Kernels {
+    Scan::Level level;
+    size_t (*findHeaderEnd)(const char*, size_t);
+    size_t (*findCRLF)(const char*, size_t);
+    size_t (*findByte)(const char*, size_t, char);
+    size_t (*tokenLength)(const char*, size_t);
+    size_t (*find)(const char*, size_t, const char*, size_t);
+};
+
+// Separateurs interdits dans un token, en plus des controles, de l'espace et de DEL
+const char g_delimiters[] = "\"(),/:;<=>?@[\\]{}";
+const size_t g_delimiterCount = sizeof(g_delimiters) - 1;
+
+bool isTokenChar(unsigned char c) {
+    return c > 0x20 && c < 0x7F && std::memchr(g_delimiters, c, g_delimiterCount) == NULL;
+}
+
+// ---- Scalaire ----
+
+size_t scalarFindHeaderEnd(const char* data, size_t length) {
+    for (size_t i = 0; i + 3 < length; ++i) {
+        if (data[i] == '\r' && data[i + 1] == '\n' && data[i + 2] == '\r' && data[i + 3] == '\n') {
+            return i;
+        }
+    }
+    return SCAN_NPOS;
+}
+
+size_t scalarFindCRLF(const char* data, size_t length) {
+    for (size_t i = 0; i + 1 < length; ++i) {
+        if (data[i] == '\r' && data[i + 1] == '\n') {
+            return i;
+        }
+    }
+    return SCAN_NPOS;
+}
+
+size_t scalarFindByte(const char* data, size_t length, char c) {
+    for (size_t i = 0; i < length; ++i) {
+        if (data[i] == c) {
+            return i;
+        }
+    }
+    return SCAN_NPOS;
+}
+
+size_t scalarTokenLength(const char* data, size_t length) {
+    size_t i = 0;
+    while (i < length && isTokenChar(static_cast<unsigned char>(data[i]))) {
+        ++i;
+    }
+    return i;
+}
+
+size_t scalarFind(const char* data, size_t length, const char* needle, size_t needleLength) {
+    if (needleLength == 0) {
+        return 0;
+    }
+    for (size_t i = 0; i + needleLength <= length; ++i) {
+        if (data[i] == needle[0] && std::memcmp(data + i, needle, needleLength) == 0) {
+            return i;
+        }
+    }
+    return SCAN_NPOS;
+}
+
+// Queue (< un bloc) traitee en scalaire a partir de `from`
+size_t offsetResult(size_t found, size_t from) {
+    return found == SCAN_NPOS ? SCAN_NPOS : found + from;
+}
+
+#ifdef SCAN_X86
+
+// ---- SSE2 (16 octets par iteration, toujours present en x86-64) ----
+
+size_t sse2FindHeaderEnd(const char* data, size_t length) {
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    size_t i = 0;
+    // Quatre chargements decales : bit k de mask = "\r\n\r\n" commence en i + k
+    for (; i + 3 + 16 <= length; i += 16) {
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1));
+        __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 2));
+        __m128i b3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 3));
+        __m128i match = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(b0, cr), _mm_cmpeq_epi8(b1, lf)),
+                                      _mm_and_si128(_mm_cmpeq_epi8(b2, cr), _mm_cmpeq_epi8(b3, lf)));
+        int mask = _mm_movemask_epi8(match);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return offsetResult(scalarFindHeaderEnd(data + i, length - i), i);
+}
+
+size_t sse2FindCRLF(const char* data, size_t length) {
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 1 + 16 <= length; i += 16) {
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1));
+        int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(b0, cr), _mm_cmpeq_epi8(b1, lf)));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return offsetResult(scalarFindCRLF(data + i, length - i), i);
+}
+
+size_t sse2FindByte(const char* data, size_t length, char c) {
+    const __m128i needle = _mm_set1_epi8(c);
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return offsetResult(scalarFindByte(data + i, length - i, c), i);
+}
+
+size_t sse2TokenLength(const char* data, size_t length) {
+    // Comparaison signee : < 0x21 attrape aussi les octets >= 0x80
+    const __m128i low = _mm_set1_epi8(0x21);
+    const __m128i del = _mm_set1_epi8(0x7F);
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i invalid = _mm_or_si128(_mm_cmplt_epi8(block, low), _mm_cmpeq_epi8(block, del));
+        for (size_t d = 0; d < g_delimiterCount; ++d) {
+            invalid = _mm_or_si128(invalid, _mm_cmpeq_epi8(block, _mm_set1_epi8(g_delimiters[d])));
+        }
+        int mask = _mm_movemask_epi8(invalid);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + scalarTokenLength(data + i, length - i);
+}
+
+// Filtre premier/dernier octet du motif sur 16 positions, memcmp seulement sur les candidats
+size_t sse2Find(const char* data, size_t length, const char* needle, size_t needleLength) {
+    if (needleLength < 2 || length < needleLength) {
+        return needleLength == 1 ? sse2FindByte(data, length, needle[0]) : scalarFind(data, length, needle, needleLength);
+    }
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[needleLength - 1]);
+    size_t i = 0;
+    for (; i + needleLength - 1 + 16 <= length; i += 16) {
+        __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + needleLength - 1));
+        unsigned int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last)));
+        while (mask != 0) {
+            unsigned int bit = __builtin_ctz(mask);
+            if (std::memcmp(data + i + bit + 1, needle + 1, needleLength - 2) == 0) {
+                return i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return offsetResult(scalarFind(data + i, length - i, needle, needleLength), i);
+}
+
+// ---- AVX2 (32 octets par iteration, selectionne a l'execution) ----
+// Queues en scalaire : appeler le code SSE2 (encodage non VEX) depuis ici coute une transition d'etat AVX
+
+__attribute__((target("avx2")))
+size_t avx2FindHeaderEnd(const char* data, size_t length) {
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 3 + 32 <= length; i += 32) {
+        __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 1));
+        __m256i b2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 2));
+        __m256i b3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 3));
+        __m256i match = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(b0, cr), _mm256_cmpeq_epi8(b1, lf)),
+                                         _mm256_and_si256(_mm256_cmpeq_epi8(b2, cr), _mm256_cmpeq_epi8(b3, lf)));
+        unsigned int mask = _mm256_movemask_epi8(match);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return offsetResult(scalarFindHeaderEnd(data + i, length - i), i);
+}
+
+__attribute__((target("avx2")))
+size_t avx2FindCRLF(const char* data, size_t length) {
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 1 + 32 <= length; i += 32) {
+        __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 1));
+        unsigned int mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(b0, cr), _mm256_cmpeq_epi8(b1, lf)));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    // Lignes de headers souvent < 32 octets : un pas de 16 (encode VEX ici) avant le scalaire
+    if (i + 1 + 16 <= length) {
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1));
+        int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(b0, _mm256_castsi256_si128(cr)), _mm_cmpeq_epi8(b1, _mm256_castsi256_si128(lf))));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+        i += 16;
+    }
+    return offsetResult(scalarFindCRLF(data + i, length - i), i);
+}
+
+__attribute__((target("avx2")))
+size_t avx2FindByte(const char* data, size_t length, char c) {
+    const __m256i needle = _mm256_set1_epi8(c);
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        unsigned int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return offsetResult(scalarFindByte(data + i, length - i, c), i);
+}
+
+__attribute__((target("avx2")))
+size_t avx2TokenLength(const char* data, size_t length) {
+    const __m256i low = _mm256_set1_epi8(0x21);
+    const __m256i del = _mm256_set1_epi8(0x7F);
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i invalid = _mm256_or_si256(_mm256_cmpgt_epi8(low, block), _mm256_cmpeq_epi8(block, del));
+        for (size_t d = 0; d < g_delimiterCount; ++d) {
+            invalid = _mm256_or_si256(invalid, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(g_delimiters[d])));
+        }
+        unsigned int mask = _mm256_movemask_epi8(invalid);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    // Noms de headers souvent < 32 octets : meme test sur 16 octets avant le scalaire
+    if (i + 16 <= length) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i invalid = _mm_or_si128(_mm_cmplt_epi8(block, _mm256_castsi256_si128(low)), _mm_cmpeq_epi8(block, _mm256_castsi256_si128(del)));
+        for (size_t d = 0; d < g_delimiterCount; ++d) {
+            invalid = _mm_or_si128(invalid, _mm_cmpeq_epi8(block, _mm_set1_epi8(g_delimiters[d])));
+        }
+        int mask = _mm_movemask_epi8(invalid);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+        i += 16;
+    }
+    return i + scalarTokenLength(data + i, length - i);
+}
+
+__attribute__((target("avx2")))
+size_t avx2Find(const char* data, size_t length, const char* needle, size_t needleLength) {
+    if (needleLength < 2 || length < needleLength) {
+        return needleLength == 1 ? avx2FindByte(data, length, needle[0]) : scalarFind(data, length, needle, needleLength);
+    }
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[needleLength - 1]);
+    size_t i = 0;
+    for (; i + needleLength - 1 + 32 <= length; i += 32) {
+        __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + needleLength - 1));
+        unsigned int mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first), _mm256_cmpeq_epi8(blockLast, last)));
+        while (mask != 0) {
+            unsigned int bit = __builtin_ctz(mask);
+            if (std::memcmp(data + i + bit + 1, needle + 1, needleLength - 2) == 0) {
+                return i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return offsetResult(scalarFind(data + i, length - i, needle, needleLength), i);
+}
+
+#endif
+
+const Kernels g_scalar = { Scan::SCAN_SCALAR, scalarFindHeaderEnd, scalarFindCRLF, scalarFindByte, scalarTokenLength, scalarFind };
+#ifdef SCAN_X86
+const Kernels g_sse2 = { Scan::SCAN_SSE2, sse2FindHeaderEnd, sse2FindCRLF, sse2FindByte, sse2TokenLength, sse2Find };
+const Kernels g_avx2 = { Scan::SCAN_AVX2, avx2FindHeaderEnd, avx2FindCRLF, avx2FindByte, avx2TokenLength, avx2Find };
+#endif
+
+const Kernels* g_kernels = NULL;
+
+Scan::Level bestLevel() {
+#ifdef SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return Scan::SCAN_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return Scan::SCAN_SSE2;
+    }
+#endif
+    return Scan::SCAN_SCALAR;
+}
+
+const Kernels* kernelsFor(Scan::Level level) {
+#ifdef SCAN_X86
+    if (level > bestLevel()) {
+        level = bestLevel();
+    }
+    if (level == Scan::SCAN_AVX2) {
+        return &g_avx2;
+    }
+    if (level == Scan::SCAN_SSE2) {
+        return &g_sse2;
+    }
+#else
+    (void)level;
+#endif
+    return &g_scalar;
+}
+
+const Kernels& kernels() {
+    if (g_kernels == NULL) {
+        Scan::Level level = bestLevel();
+        const char* forced = std::getenv("WEBSERV_SCAN");
+        if (forced != NULL) {
+            if (std::strcmp(forced, "scalar") == 0) {
+                level = Scan::SCAN_SCALAR;
+            } else if (std::strcmp(forced, "sse2") == 0) {
+                level = Scan::SCAN_SSE2;
+            } else if (std::strcmp(forced, "avx2") == 0) {
+                level = Scan::SCAN_AVX2; // Ramene au meilleur niveau du CPU par kernelsFor()
+            }
+        }
+        g_kernels = kernelsFor(level);
+    }
+    return *g_kernels;
+}
+
+}
+
+namespace Scan {
+
+Level level() {
+    return kernels().level;
+}
+
+const char* levelName(Level level) {
+    switch (level) {
+        case SCAN_AVX2: return "avx2";
+        case SCAN_SSE2: return "sse2";
+        default:        return "scalar";
+    }
+}
+
+void forceLevel(Level level) {
+    g_kernels = kernelsFor(level);
+}
+
+size_t findHeaderEnd(const char* data, size_t length) {
+    return kernels().findHeaderEnd(data, length);
+}
+
+size_t findCRLF(const char* data, size_t length) {
+    return kernels().findCRLF(data, length);
+}
+
+size_t findByte(const char* data, size_t length, char c) {
+    return kernels().findByte(data, length, c);
+}
+
+size_t tokenLength(const char* data, size_t length) {
+    return kernels().tokenLength(data, length);
+}
+
+size_t find(const char* data, size_t length, const char* needle, size_t needleLength) {
+    return kernels().find(data, length, needle, needleLength);
+}
+
+}
@@ -0,0 +1,37 @@
+// Scan.hpp
+#ifndef SCAN_HPP
+#define SCAN_HPP
+
+#include <cstddef>
+
+#define SCAN_NPOS (static_cast<size_t>(-1))
+
+/*
+ * Recherches chaudes du parsing HTTP sur des blocs de 16 (SSE2) ou 32 (AVX2)
+ * octets au lieu d'un octet a la fois. Le noyau est choisi une fois au
+ * premier appel selon le CPU (__builtin_cpu_supports), avec une version
+ * scalaire en repli hors x86. WEBSERV_SCAN=scalar|sse2|avx2 force un noyau.
+ * Toutes les fonctions retournent un indice relatif a `data`, SCAN_NPOS si absent.
+ */
+namespace Scan {
+
+enum Level { SCAN_SCALAR, SCAN_SSE2, SCAN_AVX2 };
+
+Level level();
+const char* levelName(Level level);
+// Pour les benchmarks : ignore si le CPU ne supporte pas le niveau demande
+void forceLevel(Level level);
+
+// Debut de "\r\n\r\n" (fin des headers)
+size_t findHeaderEnd(const char* data, size_t length);
+// Debut du prochain "\r\n"
+size_t findCRLF(const char* data, size_t length);
+size_t findByte(const char* data, size_t length, char c);
+// Longueur du plus long prefixe de caracteres "tchar" (RFC 9110), pour valider un nom de header
+size_t tokenLength(const char* data, size_t length);
+// Sous-chaine, utilisee pour les boundaries multipart
+size_t find(const char* data, size_t length, const char* needle, size_t needleLength);
+
+}
+
+#endif
@@ -6,7 +6,12 @@
 #include "CGIHandler.hpp"
 #include "ServerConfig.hpp"
 #include "UploadHandler.hpp"
+#include "DiskPool.hpp"
+#include "DeleteHandler.hpp"
+#include "FsStats.hpp"
+#include "Metrics.hpp"
 #include "Logger.hpp"
+#include "Scan.hpp"
 #include <sys/stat.h>  // Pour utiliser la fonction stat
 #include <sstream>
 #include <fcntl.h>
@@ -14,18 +19,30 @@
 #include "Utils.hpp"
 #include <limits.h>    // Pour PATH_MAX
 #include <stdlib.h>    // Pour realpath
-#include <dirent.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <sys/uio.h>
 
-Server::Server(const ServerConfig& config) : _config(config) {
+#define READ_MIN_ROOM 16384 // Place libre minimale avant un recv, sinon le buffer grandit
+#define READ_MAX_ROOM 65536 // Octets max par recv
+#define READ_MAX_ROUNDS 16  // 1 MiB max par evenement
+
+Server::Server(const ServerConfig& config) : _config(config), _keepAlive(false), _writer(NULL) {
 	if (!_config.isValid()) {
         Logger::instance().log(ERROR, "Server configuration is invalid.");
 	} else {
         Logger::instance().log(INFO, "Server configuration is valid.");
 	}
+	loadErrorPages();
 }
 
 Server::~Server() {}
 
+const ServerConfig& Server::getConfig() const {
+	return _config;
+}
+
 void setNonBlocking(int fd) {
 	int flags = fcntl(fd, F_GETFL, 0);
 	if (flags == -1) {
@@ -39,27 +56,50 @@ void setNonBlocking(int fd) {
 	}
 }
 
-std::string getSorryPath() {
-	srand(time(NULL));
-	int num = rand() % 6;
-	num++;
-    std::string path = "images/" + to_string(num) + "-sorry.gif";
-    Logger::instance().log(DEBUG, "path for error sorry gif : " + path);
-	return path;
+// Image choisie par le code, sans tirage : la page d'erreur reste la meme d'un envoi a l'autre
+std::string getSorryPath(int code) {
+	return "images/" + to_string(code % 6 + 1) + "-sorry.gif";
 }
 
 void readFromSocket(int client_fd, HTTPRequest& request) {
-    char buffer[1024];
-    int bytes_received = read(client_fd, buffer, sizeof(buffer));
-
-    if (bytes_received == 0) {
-        Logger::instance().log(WARNING, "Client closed the connection: FD " + to_string(client_fd));
-        request.setConnectionClosed(true);
-    } else if (bytes_received < 0) {
-        Logger::instance().log(ERROR, "Error reading from client.");
-        request.setConnectionClosed(true);
-    } else {
-        request._rawRequest.append(buffer, bytes_received);
+    // Lectures jusqu'a EAGAIN, bornees par evenement pour ne pas affamer
+    // les autres connexions (poll() est level-triggered)
+    std::string& buffer = request._rawRequest;
+    for (int round = 0; round < READ_MAX_ROUNDS; ++round) {
+        // recv directement dans la capacite libre du buffer (reservee a l'accept et
+        // au Content-Length), agrandie au besoin : aucun tampon intermediaire
+        size_t used = buffer.size();
+        size_t room = buffer.capacity() - used;
+        if (room < READ_MIN_ROOM) {
+            room = READ_MIN_ROOM;
+        } else if (room > READ_MAX_ROOM) {
+            room = READ_MAX_ROOM;
+        }
+        buffer.resize(used + room);
+        ssize_t bytes_received = recv(client_fd, &buffer[used], room, MSG_DONTWAIT);
+        buffer.resize(used + (bytes_received > 0 ? static_cast<size_t>(bytes_received) : 0));
+        if (bytes_received > 0) {
+            Metrics::bytesIn(static_cast<size_t>(bytes_received));
+        }
+
+        if (bytes_received == 0) {
+            Logger::instance().log(WARNING, "Client closed the connection: FD " + to_string(client_fd));
+            request.setConnectionClosed(true);
+            return;
+        }
+        if (bytes_received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                Logger::instance().log(ERROR, "Error reading from client.");
+                request.setConnectionClosed(true);
+            }
+            return;
+        }
+        if (static_cast<size_t>(bytes_received) < room) {
+            return; // Socket videe, inutile d'attendre EAGAIN
+        }
     }
 }
 
@@ -70,21 +110,15 @@ void Server::receiveRequest(int client_fd, HTTPRequest& request) {
         return;
     }
 
-    readFromSocket(client_fd, request);
+    // Les octets sont deja lus et les headers parses par le Listener (choix du virtual host)
     if (request.getRequestTooLarge()) {
+        _keepAlive = false; // Corps non lu : la connexion est fermee apres la reponse
         sendErrorResponse(client_fd, 413);
         return;
     }
-    if (!request.getHeadersParsed()) {
-        request.parseRawRequest(_config);
-        if (request.getRequestTooLarge()) {
-            sendErrorResponse(client_fd, 413);
-            return ;
-        }
-    }
     if (request.getHeadersParsed()) {
         // Calculate body received
-        size_t header_end_pos = request._rawRequest.find("\r\n\r\n") + 4;
+        size_t header_end_pos = request.getBodyOffset();
         request.setBodyReceived(request._rawRequest.size() - header_end_pos);
         // Check if full body is received
         if (request.getBodyReceived() >= request.getContentLength()) {
@@ -93,7 +127,7 @@ void Server::receiveRequest(int client_fd, HTTPRequest& request) {
             return; // Full request received
         }
         // Check if body size exceeds maximum
-        if (request.getBodyReceived() > static_cast<size_t>(request.getMaxBodySize())) {
+        if (request.getMaxBodySize() > 0 && request.getBodyReceived() > static_cast<size_t>(request.getMaxBodySize())) {
             Logger::instance().log(WARNING, "Request body size exceeds the configured maximum.");
             request.setRequestTooLarge(true);
             return;
@@ -101,17 +135,53 @@ void Server::receiveRequest(int client_fd, HTTPRequest& request) {
     }
 }
 
-void Server::sendResponse(int client_fd, HTTPResponse response) {
-	std::string responseString = response.toString();
-	int bytes_written = write(client_fd, responseString.c_str(), responseString.size()); // Check error
-    if (bytes_written == -1) {
-        sendErrorResponse(client_fd, 500); // Internal server error
-        Logger::instance().log(WARNING, "500 error (Internal Server Error) for failing to send response");
-    }
-    Logger::instance().log(WARNING, "Response sent to client; No verif on write : \n" + response.toStringHeaders());
+void Server::sendResponse(int client_fd, HTTPResponse& response) {
+	// Sans Content-Length le client ne peut pas delimiter la reponse sur une connexion persistante
+	if (response.getStrHeader("Content-Length").empty()) {
+		off_t bodySize = response.getBodySize();
+		if (bodySize >= 0) {
+			response.setHeader("Content-Length", to_string(bodySize));
+		} else {
+			_keepAlive = false; // Taille inconnue : la fermeture marque la fin du corps
+		}
+	}
+	response.setHeader("Connection", _keepAlive ? "keep-alive" : "close");
+	ResponseWriter& writer = output();
+	flushOutput(client_fd, writer, writer.queue(response));
 }
 
-void Server::handleHttpRequest(int client_fd, const HTTPRequest& request, HTTPResponse& response) {
+// Sortie de la connexion servie ; hors handleClient (408, 414/431 juste avant fermeture),
+// writer propre au server pour un seul essai d'envoi, sans reprise
+ResponseWriter& Server::output() {
+	return (_writer != NULL) ? *_writer : _oneShot;
+}
+
+// Premier essai d'envoi de la reponse confiee a `writer` : la plupart partent en un appel,
+// le reste attend POLLOUT dans la boucle
+void Server::flushOutput(int client_fd, ResponseWriter& writer, bool queued) {
+	if (!queued) {
+		Logger::instance().log(ERROR, "Response dropped, another one is still being sent on client FD " + to_string(client_fd));
+		_keepAlive = false;
+		return;
+	}
+	Logger::instance().log(DEBUG, "Response queued for client FD " + to_string(client_fd) + ": " + writer.statusLine());
+	if (writer.flush(client_fd) == ResponseWriter::WRITE_ERROR) {
+		// Reponse peut-etre deja partiellement envoyee : la connexion n'est plus reutilisable
+		_keepAlive = false;
+		Logger::instance().log(WARNING, std::string("Failed to send response to client FD ") + to_string(client_fd) + ": " + strerror(errno));
+		writer.clear();
+	}
+	if (&writer == &_oneShot) {
+		writer.clear();
+	}
+}
+
+void Server::sendRawOutput(int client_fd, std::string& data) {
+	ResponseWriter& writer = output();
+	flushOutput(client_fd, writer, writer.queueRaw(data));
+}
+
+void Server::handleHttpRequest(int client_fd, HTTPRequest& request, HTTPResponse& response) {
     const Location* location = _config.findLocation(request.getPath());
 
     if (location && !location->allowedMethods.empty()) {
@@ -130,22 +200,18 @@ void Server::handleHttpRequest(int client_fd, const HTTPRequest& request, HTTPRe
         return ;
     }
 
-    // Vérification de l'hôte et du port (code existant)
-    std::string hostHeader = request.getHost();
-    if (!hostHeader.empty()) {
-        size_t colonPos = hostHeader.find(':');
-        std::string hostName = (colonPos != std::string::npos) ? hostHeader.substr(0, colonPos) : hostHeader;
-        std::string portStr = (colonPos != std::string::npos) ? hostHeader.substr(colonPos + 1) : "";
+    if (location && location->stubStatus) {
+        std::string body;
+        Metrics::render(body);
+        response.setStatusCode(200);
+        response.setHeader("Content-Type", "text/plain; version=0.0.4");
+        response.swapBody(body);
+        sendResponse(client_fd, response);
+        return;
+    }
 
-        if (!portStr.empty()) {
-            int port = std::atoi(portStr.c_str());
-            if (port != _config.ports.at(0)) {
-                sendErrorResponse(client_fd, 404); // Not Found
-                Logger::instance().log(WARNING, "404 error (Not Found) sent on request : \n" + request.toString());
-                return;
-            }
-        }
-    } else {
+    // Le port et le server_name ont deja ete resolus par le Listener ; Host reste obligatoire en HTTP/1.1
+    if (request.getHost().empty()) {
         sendErrorResponse(client_fd, 400); // Mauvaise requête
         Logger::instance().log(WARNING, "400 error (Bad Request) sent on request : \n" + request.toString());
         return;
@@ -193,12 +259,12 @@ bool Server::isPathAllowed(const std::string& path, const std::string& uploadPat
     char resolvedDirectoryPath[PATH_MAX];
     char resolvedUploadPath[PATH_MAX];
 
-    if (!realpath(directoryPath.c_str(), resolvedDirectoryPath)) {
+    if (!FsStats::realpath(directoryPath.c_str(), resolvedDirectoryPath)) {
         Logger::instance().log(ERROR, "Failed to resolve directory path: " + directoryPath + " Error: " + strerror(errno));
         return false;
     }
 
-    if (!realpath(uploadPath.c_str(), resolvedUploadPath)) {
+    if (!FsStats::realpath(uploadPath.c_str(), resolvedUploadPath)) {
         Logger::instance().log(ERROR, "Failed to resolve upload path: " + uploadPath + " Error: " + strerror(errno));
         return false;
     }
@@ -230,50 +296,21 @@ std::string Server::sanitizeFilename(const std::string& filename) {
 }
 
 
-void Server::handleFileUpload(const HTTPRequest& request, HTTPResponse& response, const std::string& boundary) {
-    std::string requestBody = request.getBody();
+// Parts fichiers d'un corps multipart : intervalles de `body`, rien n'est copie
+bool Server::parseMultipart(const std::string& requestBody, const std::string& boundary, const std::string& uploadDir,
+                            std::vector<UploadHandler::Part>& parts, HTTPResponse& response) {
     std::string boundaryMarker = "--" + boundary;
-    std::string endBoundaryMarker = boundaryMarker + "--";
     std::string filename;
     size_t pos = 0;
     size_t endPos = 0;
 
-    const Location* location = _config.findLocation(request.getPath());
-    if (!location || !location->uploadOn) {
-        Logger::instance().log(ERROR, "Upload not allowed for this location.");
-        response.setStatusCode(403);
-        response.setBody("Upload not allowed.");
-        return;
-    }
-    if (location->uploadPath.empty()) {
-        Logger::instance().log(ERROR, "Upload path not specified for this location.");
-        response.setStatusCode(403);
-        response.setBody("Upload path not specified.");
-        return;
-    }
-
-    // Prepend _config.root to uploadPath if it's a relative path
-    std::string uploadDir = location->uploadPath;
-    if (!uploadDir.empty() && uploadDir[0] != '/') {
-        uploadDir = _config.root + "/" + uploadDir;
-    }
-
-    // Ensure the upload directory exists
-    struct stat st;
-    if (stat(uploadDir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
-        Logger::instance().log(ERROR, "Upload directory does not exist or is not a directory: " + uploadDir);
-        response.setStatusCode(500);
-        response.setBody("Internal Server Error: Upload directory does not exist.");
-        return;
-    }
-
     while (true) {
-        pos = requestBody.find(boundaryMarker, endPos);
-        if (pos == std::string::npos) {
+        pos = Scan::find(requestBody.data() + endPos, requestBody.size() - endPos, boundaryMarker.data(), boundaryMarker.size());
+        if (pos == SCAN_NPOS) {
             Logger::instance().log(DEBUG, "No more parts to process.");
             break;
         }
-        pos += boundaryMarker.length();
+        pos += endPos + boundaryMarker.length();
 
         if (requestBody.substr(pos, 2) == "--") {
             Logger::instance().log(DEBUG, "End of multipart data.");
@@ -284,24 +321,26 @@ void Server::handleFileUpload(const HTTPRequest& request, HTTPResponse& response
         }
 
         // Extract headers of the part
-        size_t headersEnd = requestBody.find("\r\n\r\n", pos);
-        if (headersEnd == std::string::npos) {
+        size_t headersEnd = Scan::findHeaderEnd(requestBody.data() + pos, requestBody.size() - pos);
+        if (headersEnd == SCAN_NPOS) {
             Logger::instance().log(WARNING, "Missing \\r\\n\\r\\n in request for Upload");
             response.setStatusCode(400);
             response.setBody("Bad Request: Missing headers in request for Upload");
-            return;
+            return false;
         }
+        headersEnd += pos;
         std::string partHeaders = requestBody.substr(pos, headersEnd - pos);
         pos = headersEnd + 4; // Position of the beginning of the content
 
         // Find the next boundary
-        endPos = requestBody.find(boundaryMarker, pos);
-        if (endPos == std::string::npos) {
+        endPos = Scan::find(requestBody.data() + pos, requestBody.size() - pos, boundaryMarker.data(), boundaryMarker.size());
+        if (endPos == SCAN_NPOS) {
             Logger::instance().log(ERROR, "End Boundary Marker not found.");
             response.setStatusCode(400);
             response.setBody("Bad Request: End Boundary Marker not found.");
-            return;
+            return false;
         }
+        endPos += pos;
         size_t contentEnd = endPos;
 
         // Remove any \r\n before the boundary
@@ -309,9 +348,6 @@ void Server::handleFileUpload(const HTTPRequest& request, HTTPResponse& response
             contentEnd -= 2;
         }
 
-        // Extract the content of the part
-        std::string partContent = requestBody.substr(pos, contentEnd - pos);
-
         // Check if it's a file
         if (partHeaders.find("Content-Disposition") != std::string::npos &&
             partHeaders.find("filename=\"") != std::string::npos)
@@ -330,26 +366,95 @@ void Server::handleFileUpload(const HTTPRequest& request, HTTPResponse& response
                 Logger::instance().log(ERROR, "Attempt to upload outside of allowed path.");
                 response.setStatusCode(403);
                 response.setBody("Attempt to upload outside of allowed path.");
-                return;
+                return false;
             }
 
-            try {
-                // Save the file to the authorized path
-                UploadHandler uploadHandler(destPath, partContent, _config);
-            } catch (const std::exception& e) {
-                Logger::instance().log(ERROR, std::string("Error while saving file: ") + e.what());
-                response.setStatusCode(500);
-                response.setBody("Internal Server Error: Error during file upload.");
-                return;
-            }
+            // Contenu de la part : intervalle du corps, ecrit plus tard par le DiskPool
+            UploadHandler::Part part;
+            part.destPath = destPath;
+            part.offset = pos;
+            part.length = contentEnd - pos;
+            parts.push_back(part);
         } else {
             Logger::instance().log(ERROR, std::string("Error while parsing the file in the request:") + partHeaders);
             response.setStatusCode(400);
             response.setBody("Bad Request: File not found.");
-            return;
+            return false;
         }
         endPos = endPos + boundaryMarker.length();
     }
+    return true;
+}
+
+bool Server::handleFileUpload(int client_fd, HTTPRequest& request, HTTPResponse& response, const std::string& boundary) {
+    const std::string& requestBody = request.getBody();
+    std::vector<UploadHandler::Part> parts;
+
+    const Location* location = _config.findLocation(request.getPath());
+    if (!location || !location->uploadOn) {
+        Logger::instance().log(ERROR, "Upload not allowed for this location.");
+        response.setStatusCode(403);
+        response.setBody("Upload not allowed.");
+        return false;
+    }
+    if (location->uploadPath.empty()) {
+        Logger::instance().log(ERROR, "Upload path not specified for this location.");
+        response.setStatusCode(403);
+        response.setBody("Upload path not specified.");
+        return false;
+    }
+
+    // Prepend _config.root to uploadPath if it's a relative path
+    std::string uploadDir = location->uploadPath;
+    if (!uploadDir.empty() && uploadDir[0] != '/') {
+        uploadDir = _config.root + "/" + uploadDir;
+    }
+
+    // Ensure the upload directory exists
+    struct stat st;
+    if (FsStats::stat(uploadDir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+        Logger::instance().log(ERROR, "Upload directory does not exist or is not a directory: " + uploadDir);
+        response.setStatusCode(500);
+        response.setBody("Internal Server Error: Upload directory does not exist.");
+        return false;
+    }
+
+    if (!parseMultipart(requestBody, boundary, uploadDir, parts, response)) {
+        return false;
+    }
+    if (parts.empty()) {
+        setUploadedResponse(response);
+        return false;
+    }
+
+    // Ecriture hors de la boucle : la connexion attend la fin du job, sans lire ni ecrire
+    std::string body;
+    request.swapBody(body);
+    UploadHandler* upload = NULL;
+    try {
+        upload = new UploadHandler(client_fd, output().defer(), _config, parts, body);
+    } catch (const std::exception& e) {
+        output().clear(); // Plus de job a attendre
+        Logger::instance().log(ERROR, std::string("Error while saving file: ") + e.what());
+        response.setStatusCode(500);
+        response.setBody("Internal Server Error: Error during file upload.");
+        return false;
+    }
+    response.swapHeaders(upload->headers()); // Set-Cookie de la session, repris par completeUpload
+    if (!DiskPool::instance().submit(upload)) {
+        response.swapHeaders(upload->headers());
+        delete upload;
+        output().clear();
+        Logger::instance().log(WARNING, "503 error (Service Unavailable): disk pool queue full for upload to " + uploadDir);
+        response.setStatusCode(503);
+        response.setBody("Service Unavailable: too many uploads in progress.");
+        return false;
+    }
+    Logger::instance().log(DEBUG, "Upload of " + to_string(upload->parts()) + " file(s) to " + uploadDir + " handed to the disk pool");
+    return true;
+}
+
+void Server::setUploadedResponse(HTTPResponse& response) {
     response.setStatusCode(201);
     std::string script = "<script type=\"text/javascript\">"
                          "setTimeout(function() {"
@@ -357,10 +462,30 @@ void Server::handleFileUpload(const HTTPRequest& request, HTTPResponse& response
                          "}, 3500);"
                          "</script>";
     response.setBody(script + "<html><body><h1>File successfully uploaded, you'll be redirected on HomePage</h1></body></html>");
-    Logger::instance().log(INFO, "Successfully uploaded file: " + filename + " to " + uploadDir);
 }
 
-void Server::handleGetOrPostRequest(int client_fd, const HTTPRequest& request, HTTPResponse& response) {
+void Server::completeUpload(int client_fd, HTTPRequest& request, UploadHandler& upload, ResponseWriter& output) {
+    _writer = &output;
+    _keepAlive = request.getKeepAlive();
+
+    HTTPResponse response;
+    response.swapHeaders(upload.headers());
+    if (upload.error() != 0) {
+        Logger::instance().log(ERROR, "Error while saving file " + upload.failedPath() + ": " + strerror(upload.error()));
+        response.setStatusCode(500);
+        response.setBody("Internal Server Error: Error during file upload.");
+    } else {
+        setUploadedResponse(response);
+        Metrics::uploadBytes(upload.bytes());
+        Logger::instance().log(INFO, "Successfully uploaded file: " + upload.lastPath());
+    }
+    sendResponse(client_fd, response);
+
+    request.setKeepAlive(_keepAlive);
+    _writer = NULL;
+}
+
+void Server::handleGetOrPostRequest(int client_fd, HTTPRequest& request, HTTPResponse& response) {
     std::string fullPath = _config.root + request.getPath();
 
     // Log pour vérifier le chemin complet
@@ -372,8 +497,8 @@ void Server::handleGetOrPostRequest(int client_fd, const HTTPRequest& request, H
     if (request.getMethod() == "POST") {
         bool isFileUpload = false;
         std::string contentType;
-        if (request.hasHeader("Content-Type")) {
-            contentType = request.getStrHeader("Content-Type");
+        if (request.hasHeader(HEADER_CONTENT_TYPE)) {
+            contentType = request.getStrHeader(HEADER_CONTENT_TYPE);
             if (contentType.find("multipart/form-data") != std::string::npos) {
                 isFileUpload = true;
             }
@@ -385,10 +510,10 @@ void Server::handleGetOrPostRequest(int client_fd, const HTTPRequest& request, H
                 size_t boundaryPos = contentType.find("boundary=");
                 if (boundaryPos != std::string::npos) {
                     std::string boundary = contentType.substr(boundaryPos + 9);
-                    handleFileUpload(request, response, boundary);
-
-                    // Envoyer la réponse
-                    sendResponse(client_fd, response);
+                    if (!handleFileUpload(client_fd, request, response, boundary)) {
+                        // Envoyer la réponse
+                        sendResponse(client_fd, response);
+                    }
                     return;
                 } else {
                     // Boundary manquant dans Content-Type
@@ -407,18 +532,15 @@ void Server::handleGetOrPostRequest(int client_fd, const HTTPRequest& request, H
             // Vérifier si le fichier a une extension CGI
             if (hasCgiExtension(fullPath)) {
                 Logger::instance().log(DEBUG, "CGI extension detected for path: " + fullPath);
-                if (access(fullPath.c_str(), F_OK) == -1) {
+                if (FsStats::access(fullPath.c_str(), F_OK) == -1) {
                     Logger::instance().log(DEBUG, "CGI script not found: " + fullPath);
                     sendErrorResponse(client_fd, 404); // Not Found
                 } else {
                     CGIHandler cgiHandler;
                     std::string cgiOutput = cgiHandler.executeCGI(fullPath, request);
 
-                    int bytes_written = write(client_fd, cgiOutput.c_str(), cgiOutput.length());
-                    if (bytes_written == -1) {
-                        sendErrorResponse(client_fd, 500); // Internal Server Error
-                        Logger::instance().log(WARNING, "500 error (Internal Server Error): Failed to send CGI output response.");
-                    }
+                    _keepAlive = false; // Sortie CGI brute : fin de reponse signalee par la fermeture
+                    sendRawOutput(client_fd, cgiOutput);
                     return;
                 }
             } else {
@@ -437,18 +559,15 @@ void Server::handleGetOrPostRequest(int client_fd, const HTTPRequest& request, H
         // Vérifier si le fichier a une extension CGI
         if (hasCgiExtension(fullPath)) {
             Logger::instance().log(DEBUG, "CGI extension detected for path: " + fullPath);
-            if (access(fullPath.c_str(), F_OK) == -1) {
+            if (FsStats::access(fullPath.c_str(), F_OK) == -1) {
                 Logger::instance().log(DEBUG, "CGI script not found: " + fullPath);
                 sendErrorResponse(client_fd, 404); // Not Found
             } else {
                 CGIHandler cgiHandler;
                 std::string cgiOutput = cgiHandler.executeCGI(fullPath, request);
 
-                int bytes_written = write(client_fd, cgiOutput.c_str(), cgiOutput.length());
-                if (bytes_written == -1) {
-                    sendErrorResponse(client_fd, 500); // Internal Server Error
-                    Logger::instance().log(WARNING, "500 error (Internal Server Error): Failed to send CGI output response.");
-                }
+                _keepAlive = false; // Sortie CGI brute : fin de reponse signalee par la fermeture
+                sendRawOutput(client_fd, cgiOutput);
                 return;
             }
         } else {
@@ -465,35 +584,49 @@ void Server::handleGetOrPostRequest(int client_fd, const HTTPRequest& request, H
 
 void Server::handleDeleteRequest(int client_fd, const HTTPRequest& request) {
 	std::string fullPath = _config.root + request.getPath();
-	HTTPResponse response;
-	if (access(fullPath.c_str(), F_OK) == -1) {
-        Logger::instance().log(WARNING, "404 error (Not Found) sent on DELETE request for address: \n" + _config.root + request.getPath());
+	// access() et remove() sur un thread du DiskPool ; la reponse vient de completeDelete()
+	DeleteHandler* job = new DeleteHandler(client_fd, output().defer(), fullPath);
+	if (!DiskPool::instance().submit(job)) {
+		delete job;
+		output().clear(); // Plus de job a attendre
+		Logger::instance().log(WARNING, "503 error (Service Unavailable): disk pool queue full for DELETE " + fullPath);
+		sendErrorResponse(client_fd, 503);
+	}
+}
+
+void Server::completeDelete(int client_fd, HTTPRequest& request, DeleteHandler& job, ResponseWriter& output) {
+	_writer = &output;
+	_keepAlive = request.getKeepAlive();
+
+	if (!job.found()) {
+        Logger::instance().log(WARNING, "404 error (Not Found) sent on DELETE request for address: \n" + job.path());
 		sendErrorResponse(client_fd, 404);
+	} else if (job.error() == 0) {
+		HTTPResponse response;
+		response.setStatusCode(200);
+		response.setHeader("Content-Type", "text/html");
+		std::string body = "<html><body><h1>File deleted successfully</h1></body></html>";
+		response.setHeader("Content-Length", to_string(body.size()));
+		response.setBody(body);
+        Logger::instance().log(INFO, "Successful DELETE on resource : " + job.path());
+		sendResponse(client_fd, response);
 	} else {
-		if (remove(fullPath.c_str()) == 0) {
-			response.setStatusCode(200);
-			response.setReasonPhrase("OK");
-			response.setHeader("Content-Type", "text/html");
-			std::string body = "<html><body><h1>File deleted successfully</h1></body></html>";
-			response.setHeader("Content-Length", to_string(body.size()));
-			response.setBody(body);
-            Logger::instance().log(INFO, "Successful DELETE on resource : " + fullPath);
-			sendResponse(client_fd, response);
-		} else {
-            Logger::instance().log(WARNING, "500 error (Internal Server Error) to DELETE: " + fullPath + ": remove() failed");
-			sendErrorResponse(client_fd, 500);
-		}
+        Logger::instance().log(WARNING, "500 error (Internal Server Error) to DELETE: " + job.path() + ": remove() failed: " + strerror(job.error()));
+		sendErrorResponse(client_fd, 500);
 	}
+
+	request.setKeepAlive(_keepAlive);
+	_writer = NULL;
 }
 
 void Server::serveStaticFile(int client_fd, const std::string& filePath,
                              HTTPResponse& response, const HTTPRequest& request) {
     struct stat pathStat;
-    if (stat(filePath.c_str(), &pathStat) == 0 && S_ISDIR(pathStat.st_mode)) {
+    if (FsStats::stat(filePath.c_str(), &pathStat) == 0 && S_ISDIR(pathStat.st_mode)) {
         // Vérifier s'il existe un fichier index
         Logger::instance().log(INFO, "Request File Path is a directory, searching for an index page...");
         std::string indexPath = filePath + "/" + _config.index;
-        if (access(indexPath.c_str(), F_OK) != -1) {
+        if (FsStats::access(indexPath.c_str(), F_OK) != -1) {
             Logger::instance().log(INFO, "Found index page: " + indexPath);
             serveStaticFile(client_fd, indexPath, response, request);
         } else {
@@ -505,14 +638,22 @@ void Server::serveStaticFile(int client_fd, const std::string& filePath,
             }
 
             if (autoindex) {
-                // Générer le listing du répertoire
-                Logger::instance().log(INFO, "Index page not found. Generating directory listing for: " + filePath);
-                std::string directoryListing = generateDirectoryListing(filePath, request.getPath());
-
+                // Listing servi depuis le cache du server, relu seulement si le repertoire a change
+                Logger::instance().log(INFO, "Index page not found. Serving directory listing for: " + filePath);
+                std::string format = _config.autoindexFormat;
+                if (location && !location->autoindexFormat.empty()) {
+                    format = location->autoindexFormat;
+                }
+                ListingFormat listingFormat = (format == "json") ? LISTING_JSON : LISTING_HTML;
+                SharedBuffer* page = _listings.page(filePath, pathStat, request.getPath(), request.getQueryString(), listingFormat);
+                if (page == NULL) {
+                    sendErrorResponse(client_fd, 500);
+                    return;
+                }
                 response.setStatusCode(200);
-                response.setHeader("Content-Type", "text/html");
-                response.setBody(directoryListing);
-                response.setHeader("Content-Length", to_string(directoryListing.size()));
+                response.setHeader("Content-Type", (listingFormat == LISTING_JSON) ? "application/json" : "text/html");
+                response.setBodySource(new SharedBodySource(page));
+                page->release(); // La source garde sa propre reference
                 sendResponse(client_fd, response);
             } else {
                 // Si autoindex est désactivé, retourner une erreur 403 Forbidden
@@ -521,36 +662,18 @@ void Server::serveStaticFile(int client_fd, const std::string& filePath,
             }
         }
     } else {
-        std::ifstream file(filePath.c_str(), std::ios::binary);
+        // Le fichier n'est plus lu en memoire : envoye par sendfile depuis le cache de pages
+        FileBodySource* file = FileBodySource::open(filePath);
         if (file) {
             Logger::instance().log(INFO, "Serving static file found at: " + filePath);
-            std::stringstream buffer;
-            buffer << file.rdbuf();
-            std::string content = buffer.str();
 
             response.setStatusCode(200);
-            response.setReasonPhrase("OK");
-
-            std::string contentType = "text/html";
-            size_t extPos = filePath.find_last_of('.');
-            if (extPos != std::string::npos) {
-                std::string extension = filePath.substr(extPos);
-                if (extension == ".css")
-                    contentType = "text/css";
-                else if (extension == ".js")
-                    contentType = "application/javascript";
-                else if (extension == ".png")
-                    contentType = "image/png";
-                else if (extension == ".jpg" || extension == ".jpeg")
-                    contentType = "image/jpeg";
-                else if (extension == ".gif")
-                    contentType = "image/gif";
-                // Vous pouvez ajouter d'autres types MIME si nécessaire
-            }
 
-            response.setHeader("Content-Type", contentType);
-            response.setHeader("Content-Length", to_string(content.size()));
-            response.setBody(content);
+            // Une recherche dans la table du server, sans copie de l'extension
+            const std::string* contentType = _config.mimeTypes.forPath(filePath);
+            response.setHeader("Content-Type", (contentType != NULL) ? *contentType : _config.defaultType);
+            response.setHeader("Content-Length", to_string(file->size()));
+            response.setBodySource(file);
             Logger::instance().log(DEBUG, "Set-Cookie header: " + response.getStrHeader("Set-Cookie"));
 
             sendResponse(client_fd, response);
@@ -561,30 +684,45 @@ void Server::serveStaticFile(int client_fd, const std::string& filePath,
     }
 }
 
-int Server::acceptNewClient(int server_fd) {
-    Logger::instance().log(INFO, "Accepting new Connection on socket FD: " + to_string(server_fd));
+int Server::acceptNewClient(int server_fd, std::string& peer) {
 	if (server_fd <= 0) {
         Logger::instance().log(ERROR, "Invalid server FD: " + to_string(server_fd));
+		errno = EBADF;
 		return -1;
 	}
-	sockaddr_in client_addr;
+	// sockaddr_storage : les listeners IPv6 rendent un sockaddr_in6, tronque dans un sockaddr_in
+	sockaddr_storage client_addr;
 	memset(&client_addr, 0, sizeof(client_addr));
 	socklen_t client_len = sizeof(client_addr);
 
-	int client_fd = accept(server_fd, (struct sockaddr*)&client_addr, &client_len);
+	// Non bloquant d'emblee (ce que la socket n'accepte pas reprend sur POLLOUT), et ferme a l'exec des CGI
+	int client_fd = accept4(server_fd, (struct sockaddr*)&client_addr, &client_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
 	if (client_fd == -1) {
-        Logger::instance().log(ERROR, std::string("Error while accepting connection: ") + strerror(errno));
-		return -1;
+		return -1; // errno intact : EAGAIN termine le lot, EMFILE passe par le fd de reserve
+	}
+	// Headers et corps partent en plusieurs ecritures : sans TCP_NODELAY, Nagle et l'ACK retarde
+	// du client ajoutent ~40 ms a chaque reponse en keep-alive
+	int nodelay = 1;
+	if (setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay)) == -1) {
+        Logger::instance().log(WARNING, std::string("Failed to set TCP_NODELAY on client FD ") + to_string(client_fd) + ": " + strerror(errno));
 	}
+	peer = Socket::formatAddress(client_addr);
+    Logger::instance().log(DEBUG, "Accepted client FD " + to_string(client_fd) + " from " + peer + " on socket FD " + to_string(server_fd));
 
 	return client_fd;
 }
 
-void Server::handleClient(int client_fd, HTTPRequest* request) {
+void Server::handleClient(int client_fd, HTTPRequest* request, ResponseWriter& output) {
     if (client_fd <= 0) {
         Logger::instance().log(ERROR, "Invalid client FD: " + to_string(client_fd));
         return;
     }
+    _writer = &output;
+    handleRequest(client_fd, request);
+    _writer = NULL;
+}
+
+void Server::handleRequest(int client_fd, HTTPRequest* request) {
 
     receiveRequest(client_fd, *request);
     if (!request->isComplete()) {
@@ -593,14 +731,17 @@ void Server::handleClient(int client_fd, HTTPRequest* request) {
     }
 
     HTTPResponse response;
+    _keepAlive = request->getKeepAlive() && _config.keepaliveTimeout > 0;
 
     if (!request->parse()) {
         Logger::instance().log(ERROR, "Failed to parse client request on fd " + to_string(client_fd));
+        _keepAlive = false;
         sendErrorResponse(client_fd, 400);  // Bad Request
+        request->setKeepAlive(false);
         return;
     }
 
-    SessionManager session(request->getStrHeader("Cookie"));
+    SessionManager session(request->getStrHeader(HEADER_COOKIE));
     manageUserSession(request, response, client_fd, session);
 
     Logger::instance().log(INFO, "Parsing OK, handling request for client fd: " + to_string(client_fd));
@@ -608,6 +749,7 @@ void Server::handleClient(int client_fd, HTTPRequest* request) {
 
     // Garde la session et update les infos avant de quitter
     session.persistSession();
+    request->setKeepAlive(_keepAlive);
 }
 
 void    Server::manageUserSession(HTTPRequest* request, HTTPResponse& response, int client_fd, SessionManager& session) {
@@ -615,7 +757,7 @@ void    Server::manageUserSession(HTTPRequest* request, HTTPResponse& response,
     session.loadSession(); // Charger les données existantes
 
     if (session.getFirstCon()) {
-        response.setHeader("Set-Cookie", session.getSessionId() + "; Path=/; HttpOnly");
+        response.addHeader("Set-Cookie", session.getSessionId() + "; Path=/; HttpOnly");
         session.setData("status", "new user"); // Set up uniquement lors de la première connexion
     }
     else {
@@ -630,7 +772,7 @@ void    Server::manageUserSession(HTTPRequest* request, HTTPResponse& response,
     session.setData("last_access_time", to_string(session.curr_time()), true);
     std::string path = request->getPath();
     std::string method = request->getMethod();
-    std::string user_agent = request->getStrHeader("User-Agent");
+    std::string user_agent = request->getStrHeader(HEADER_USER_AGENT);
 
     if (!path.empty())
         session.setData("requested_pages", path, true);
@@ -648,70 +790,74 @@ void    Server::manageUserSession(HTTPRequest* request, HTTPResponse& response,
         session.setData("user_agent", user_agent, false); // False pour ne pas accumuler pls valeurs pour un user.
 }
 
+// Requete entierement lue : la connexion reste ouverte si la requete le permet.
+// Hors handleClient (408, 414/431), la connexion est fermee juste apres.
 void Server::sendErrorResponse(int client_fd, int errorCode) {
+	if (_writer == NULL) {
+		_keepAlive = false;
+	}
+	const ErrorPage& page = errorPage(errorCode);
+	ResponseWriter& writer = output();
+	flushOutput(client_fd, writer, writer.queueStatic(errorCode, page.headers, _keepAlive, page.body));
+}
+
+void Server::sendOverloaded(int client_fd) {
+	const StatusLine* status = statusLineFor(503);
+	const ErrorPage& page = errorPage(503);
+	static const char connection[] = "Connection: close\r\n\r\n";
+	struct iovec iov[5];
+	iov[0].iov_base = const_cast<char*>(status->line);
+	iov[0].iov_len = status->length;
+	iov[1].iov_base = const_cast<char*>(DateCache::headers());
+	iov[1].iov_len = DateCache::length();
+	iov[2].iov_base = const_cast<char*>(page.headers.data());
+	iov[2].iov_len = page.headers.size();
+	iov[3].iov_base = const_cast<char*>(connection);
+	iov[3].iov_len = sizeof(connection) - 1;
+	iov[4].iov_base = const_cast<char*>(page.body.data());
+	iov[4].iov_len = page.body.size();
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = 5;
+	// Sans reprise : la connexion est fermee juste apres, un envoi partiel est abandonne
+	if (sendmsg(client_fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT) == -1) {
+        Logger::instance().log(DEBUG, std::string("503 not sent to rejected FD ") + to_string(client_fd) + ": " + strerror(errno));
+	}
+}
+
+// Headers et corps d'une reponse d'erreur, serialises une fois par code pour ce server.
+// Le server vit avec son snapshot, retenu par la connexion jusqu'a la fin de l'envoi.
+const Server::ErrorPage& Server::errorPage(int errorCode) {
+	std::map<int, ErrorPage>::const_iterator cached = _errorPages.find(errorCode);
+	Metrics::cacheLookup(CACHE_ERROR_PAGE, cached != _errorPages.end());
+	if (cached != _errorPages.end()) {
+		return cached->second;
+	}
 	HTTPResponse response;
 	response.setStatusCode(errorCode);
+	return cacheErrorPage(errorCode, response.generateErrorPage());
+}
 
-	std::string errorContent;
-	std::map<int, std::string>::const_iterator it = _config.errorPages.find(errorCode);
-	if (it != _config.errorPages.end()) {
+const Server::ErrorPage& Server::cacheErrorPage(int errorCode, const std::string& body) {
+	ErrorPage& page = _errorPages[errorCode];
+	page.headers = "Content-Type: text/html\r\nContent-Length: " + to_string(body.size()) + "\r\n";
+	page.body = body;
+	return page;
+}
+
+// error_page du config lus une seule fois, au chargement du snapshot
+void Server::loadErrorPages() {
+	for (std::map<int, std::string>::const_iterator it = _config.errorPages.begin(); it != _config.errorPages.end(); ++it) {
 		std::string errorPagePath = _config.root + it->second;  // Chemin complet
 		std::ifstream errorFile(errorPagePath.c_str(), std::ios::binary);
-        Logger::instance().log(INFO, "Error page found in config file, searching for : " + errorPagePath);
-		if (errorFile) {
-			std::stringstream buffer;
-			buffer << errorFile.rdbuf();
-			errorContent = buffer.str();
-		} else {
-            Logger::instance().log(WARNING, "Failed to open custom error page : " + errorPagePath + "; Serving default");
-			// Laisser errorContent vide pour utiliser la page d'erreur par défaut
+		if (!errorFile) {
+			Logger::instance().log(WARNING, "Failed to open custom error page : " + errorPagePath + "; Serving default");
+			continue; // Page par defaut generee au premier usage
 		}
+		std::stringstream buffer;
+		buffer << errorFile.rdbuf();
+		cacheErrorPage(it->first, buffer.str());
+		Logger::instance().log(DEBUG, "Custom error page " + to_string(it->first) + " loaded from " + errorPagePath);
 	}
-
-	// Passer errorContent à beError, qui utilisera la page par défaut si errorContent
-	// est vide
-	response.beError(errorCode, errorContent);
-	sendResponse(client_fd, response);
-}
-
-std::string Server::generateDirectoryListing(const std::string& directoryPath, const std::string& requestPath) {
-    std::string listing;
-    listing += "<html><head><title>Index of " + requestPath + "</title></head><body>";
-    listing += "<h1>Index of " + requestPath + "</h1>";
-    listing += "<ul>";
-
-    DIR* dir = opendir(directoryPath.c_str());
-    if (dir) {
-        struct dirent* entry;
-        while ((entry = readdir(dir)) != NULL) {
-            std::string name = entry->d_name;
-
-            // Ignorer les entrées spéciales "." et ".."
-            if (name == "." || name == "..")
-                continue;
-
-            std::string fullPath = requestPath;
-            if (!fullPath.empty() && fullPath.size() - 1 != '/')
-                fullPath += "/";
-            fullPath += name;
-
-            // Ajouter un '/' à la fin si c'est un répertoire
-            std::string displayName = name;
-            std::string filePath = directoryPath + "/" + name;
-            struct stat st;
-            if (stat(filePath.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
-                displayName += "/";
-                fullPath += "/";
-            }
-
-            listing += "<li><a href=\"" + fullPath + "\">" + displayName + "</a></li>";
-        }
-        closedir(dir);
-    } else {
-        Logger::instance().log(ERROR, "Failed to open directory: " + directoryPath);
-        listing += "<p>Unable to access directory.</p>";
-    }
-
-    listing += "</ul></body></html>";
-    return listing;
 }
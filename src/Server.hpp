@@ -14,26 +14,51 @@
 #include "HTTPRequest.hpp"
 #include "HTTPResponse.hpp"
 #include "SessionManager.hpp"
+#include "ResponseWriter.hpp"
+#include "DirectoryListing.hpp"
+#include "UploadHandler.hpp"
 #include <algorithm>
 
 class Socket;
+class DeleteHandler;
+
+// Vide la socket client (recv non bloquant) directement a la fin du buffer de la requete
+void readFromSocket(int client_fd, HTTPRequest& request);
 
 class Server
 {
 private:
     const ServerConfig& _config;
+    bool _keepAlive; // Connexion gardee ouverte apres la reponse en cours (remis a chaque requete)
+    ResponseWriter* _writer; // Sortie de la connexion servie, le temps de handleClient
+    ResponseWriter _oneShot; // Envois hors handleClient, sans reprise
+    // Reponse d'erreur serialisee par code ; Connection est ajoute a chaque envoi
+    struct ErrorPage {
+        std::string headers; // Content-Type et Content-Length, CRLF compris
+        std::string body;
+    };
+    std::map<int, ErrorPage> _errorPages;
+    DirectoryListing _listings; // Pages autoindex, invalidees par le mtime du repertoire
 
     void receiveRequest(int client_fd, HTTPRequest& request);
-    void sendResponse(int client_fd, HTTPResponse response);
+    void sendResponse(int client_fd, HTTPResponse& response);
+    void sendRawOutput(int client_fd, std::string& data);
+    ResponseWriter& output();
+    void flushOutput(int client_fd, ResponseWriter& writer, bool queued);
+    const ErrorPage& errorPage(int errorCode);
+    const ErrorPage& cacheErrorPage(int errorCode, const std::string& body);
+    void loadErrorPages();
+    void handleRequest(int client_fd, HTTPRequest* request);
     void manageUserSession(HTTPRequest* request, HTTPResponse& response, int client_fd, SessionManager& session);
-    void handleHttpRequest(int client_fd, const HTTPRequest& request, HTTPResponse& response);
-    void handleGetOrPostRequest(int client_fd, const HTTPRequest& request, HTTPResponse& response);
+    void handleHttpRequest(int client_fd, HTTPRequest& request, HTTPResponse& response);
+    void handleGetOrPostRequest(int client_fd, HTTPRequest& request, HTTPResponse& response);
     void handleDeleteRequest(int client_fd, const HTTPRequest& request);
     void serveStaticFile(int client_fd, const std::string& filePath, HTTPResponse& response, const HTTPRequest& request);
-    void handleFileUpload(const HTTPRequest& request, HTTPResponse& response, const std::string& boundary);
+    // true si l'ecriture est confiee au DiskPool : la reponse viendra de completeUpload()
+    bool handleFileUpload(int client_fd, HTTPRequest& request, HTTPResponse& response, const std::string& boundary);
+    void setUploadedResponse(HTTPResponse& response);
 	bool isPathAllowed(const std::string& path, const std::string& uploadPath);
 	std::string sanitizeFilename(const std::string& filename);
-	std::string generateDirectoryListing(const std::string& directoryPath, const std::string& requestPath);
     // bool handleFileUpload(const HTTPRequest& request, HTTPResponse& response, const std::string& boundary);
 
     // Ajout des méthodes auxiliaires pour gérer les extensions CGI supplémentaires
@@ -46,14 +71,28 @@ public:
     Server(const ServerConfig& config);
     ~Server();
 
+    const ServerConfig& getConfig() const;
+
+    // Parts fichiers d'un corps multipart (intervalles de `requestBody`) ; false et `response` remplie si mal forme.
+    // Public pour le microbenchmark
+    bool parseMultipart(const std::string& requestBody, const std::string& boundary, const std::string& uploadDir,
+                        std::vector<UploadHandler::Part>& parts, HTTPResponse& response);
+
     // Méthodes pour la gestion des erreurs et la réception/gestion des requêtes
     void sendErrorResponse(int client_fd, int errorCode);
+    // 503 d'une connexion refusee a l'accept : un seul envoi direct, hors metriques des requetes servies
+    void sendOverloaded(int client_fd);
 
-    // Accepter une nouvelle connexion client
-    int acceptNewClient(int server_fd);
+    // Prochaine connexion en attente (non bloquante, TCP_NODELAY) ; `peer` recoit son adresse pour l'access log.
+    // -1 avec errno intact si la file est vide (EAGAIN) ou en cas d'echec (EMFILE...)
+    int acceptNewClient(int server_fd, std::string& peer);
 
-    // Gérer les requêtes d'un client connecté
-    void handleClient(int client_fd, HTTPRequest* request);
+    // Gérer les requêtes d'un client connecté ; la reponse part (ou reste en attente) dans `output`
+    void handleClient(int client_fd, HTTPRequest* request, ResponseWriter& output);
+    // Fin d'un upload ecrit par le DiskPool : 201, ou 500 si un fichier n'a pas pu etre ecrit
+    void completeUpload(int client_fd, HTTPRequest& request, UploadHandler& upload, ResponseWriter& output);
+    // Fin d'un DELETE execute par le DiskPool : 200, 404 ou 500
+    void completeDelete(int client_fd, HTTPRequest& request, DeleteHandler& job, ResponseWriter& output);
 };
 
 #endif
@@ -1,13 +1,19 @@
 #include "ServerConfig.hpp"
 #include "Logger.hpp"
+#include "Utils.hpp"
 #include <iostream>
 
-ServerConfig::ServerConfig() : root("www/"), index("index.html"), host("0.0.0.0"), clientMaxBodySize(0), autoindex(false) {
+ServerConfig::ServerConfig() : root("www/"), index("index.html"), host("0.0.0.0"), clientMaxBodySize(0), autoindex(false), autoindexFormat("html"),
+	clientHeaderTimeout(TIMEOUT_MS), clientBodyTimeout(TIMEOUT_MS), keepaliveTimeout(KEEPALIVE_TIMEOUT_MS), sendTimeout(TIMEOUT_MS),
+	clientHeaderBufferSize(1024), largeClientHeaderBuffers(4), largeClientHeaderBufferSize(8192),
+	mimeTypes(MimeTypes::defaults()), defaultType(MIME_DEFAULT_TYPE),
+	uploadFsync(false), uploadDirectIo(0), traceSample(0) {
 	serverNames.push_back("localhost");
 }
 
 ServerConfig::ServerConfig(const ServerConfig& other) {
 	ports = other.ports;
+	listens = other.listens;
 	serverNames = other.serverNames;
 	root = other.root;
 	index = other.index;
@@ -17,6 +23,19 @@ ServerConfig::ServerConfig(const ServerConfig& other) {
 	cgiExtensions = other.cgiExtensions;
 	clientMaxBodySize = other.clientMaxBodySize;
 	autoindex = other.autoindex;
+	autoindexFormat = other.autoindexFormat;
+	clientHeaderTimeout = other.clientHeaderTimeout;
+	clientBodyTimeout = other.clientBodyTimeout;
+	keepaliveTimeout = other.keepaliveTimeout;
+	sendTimeout = other.sendTimeout;
+	clientHeaderBufferSize = other.clientHeaderBufferSize;
+	largeClientHeaderBuffers = other.largeClientHeaderBuffers;
+	largeClientHeaderBufferSize = other.largeClientHeaderBufferSize;
+	mimeTypes = other.mimeTypes;
+	defaultType = other.defaultType;
+	uploadFsync = other.uploadFsync;
+	uploadDirectIo = other.uploadDirectIo;
+	traceSample = other.traceSample;
 }
 
 
@@ -33,6 +52,7 @@ const Location* ServerConfig::findLocation(const std::string& path) const {
 ServerConfig& ServerConfig::operator=(const ServerConfig& other) {
 	if (this != &other) {
 		ports = other.ports;
+		listens = other.listens;
 		serverNames = other.serverNames;
 		root = other.root;
 		index = other.index;
@@ -42,6 +62,19 @@ ServerConfig& ServerConfig::operator=(const ServerConfig& other) {
 		cgiExtensions = other.cgiExtensions;
 		clientMaxBodySize = other.clientMaxBodySize;
 		autoindex = other.autoindex;
+		autoindexFormat = other.autoindexFormat;
+		clientHeaderTimeout = other.clientHeaderTimeout;
+		clientBodyTimeout = other.clientBodyTimeout;
+		keepaliveTimeout = other.keepaliveTimeout;
+		sendTimeout = other.sendTimeout;
+		clientHeaderBufferSize = other.clientHeaderBufferSize;
+		largeClientHeaderBuffers = other.largeClientHeaderBuffers;
+		largeClientHeaderBufferSize = other.largeClientHeaderBufferSize;
+		mimeTypes = other.mimeTypes;
+		defaultType = other.defaultType;
+		uploadFsync = other.uploadFsync;
+		uploadDirectIo = other.uploadDirectIo;
+		traceSample = other.traceSample;
 	}
 	return *this;
 }
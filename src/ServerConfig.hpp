@@ -3,6 +3,8 @@
 #define SERVERCONFIG_HPP
 
 #include "Location.hpp"
+#include "ListenDirective.hpp"
+#include "MimeTypes.hpp"
 #include <string>
 #include <vector>
 #include <map>
@@ -10,6 +12,7 @@
 class ServerConfig {
 public:
     std::vector<int> ports;
+    std::vector<ListenDirective> listens;
     std::vector<std::string> serverNames;
     std::string root;
     std::string index;
@@ -18,6 +21,29 @@ public:
     std::string host;
     int clientMaxBodySize;
     bool autoindex;
+    std::string autoindexFormat; // "html" ou "json"
+
+    // Delais par phase de connexion, en ms
+    int clientHeaderTimeout; // Reception complete des headers, depuis l'accept (non prolonge par les lectures)
+    int clientBodyTimeout;   // Entre deux lectures du body
+    int keepaliveTimeout;    // Connexion inactive entre deux requetes, 0 = pas de keep-alive
+    int sendTimeout;         // Entre deux ecritures de la reponse
+
+    // Buffers de headers, en octets
+    int clientHeaderBufferSize;      // Capacite reservee a l'accept pour la requete
+    int largeClientHeaderBuffers;    // Nombre de grands buffers : total des headers <= nombre * taille
+    int largeClientHeaderBufferSize; // Taille max de la ligne de requete (414 au-dela)
+
+    // Types MIME : tables par defaut completees par `types {}` et `types_file`
+    MimeTypes mimeTypes;
+    std::string defaultType; // Extension inconnue ou absente
+
+    // Ecriture des uploads (threads du DiskPool)
+    bool uploadFsync;   // fdatasync avant de repondre 201
+    int uploadDirectIo; // O_DIRECT a partir de cette taille de fichier, 0 = jamais
+
+    // Chronologie des phases (RequestTrace) au log INFO pour une requete sur traceSample, 0 = jamais
+    int traceSample;
 
     // Ajout d'un vecteur pour les extensions CGI
     std::vector<std::string> cgiExtensions;
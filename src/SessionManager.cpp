@@ -1,5 +1,9 @@
 // Si possible, inclure une bibliothèque de hachage MD5 ou SHA1
 #include "SessionManager.hpp"
+#include "FsStats.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
 
 SessionManager::SessionManager(std::string session_id) {
     if (session_id.size() > 0) {
@@ -118,20 +122,8 @@ void SessionManager::persistSession() {
         it->second = cleanValue(it->second);
     }
 
-    // Ouvre le fichier en mode ajout
-    std::ofstream file(filepath.c_str(), std::ios::app);
-    if (!file.is_open()) {
-        std::cerr << "Erreur : impossible de sauvegarder la session dans " << filepath << std::endl;
-        return;
-    }
-
-    // Ajoute une ligne vide avant [General] si le fichier n'est pas vide
-    file.seekp(0, std::ios::end); // Place le curseur à la fin
-    if (file.tellp() > 0) {
-        file << "\n"; // Ajoute une ligne vide
-    }
-
     // Écrit les nouvelles données sous la section [General]
+    std::ostringstream file;
     file << "[General]\n";
     if (_session_data.find("last_access_time") != _session_data.end()) {
         file << "last_access_time=" << cleanValue(curr_time()) << "\n";
@@ -153,10 +145,68 @@ void SessionManager::persistSession() {
         file << "Methods=" << cleanValue(_session_data["methods"]) << "\n";
     }
 
-    file.close();
+    // L'ecriture part sur un thread ; file du pool pleine : ecriture sur place, comme avant
+    std::string record = file.str();
+    SessionWriteJob* job = new SessionWriteJob(filepath, record);
+    if (!DiskPool::instance().submit(job)) {
+        job->run();
+        job->finishDetached();
+        delete job;
+    }
+}
+
+SessionWriteJob::SessionWriteJob(const std::string& filepath, std::string& record)
+    : DiskJob(-1, 0), _filepath(filepath), _error(0) {
+    _record.swap(record);
+    serializeOn(_filepath);
+}
+
+// Thread du pool : un seul write() en O_APPEND ; l'erreur est loggee par finishDetached()
+void SessionWriteJob::run() {
+    FsTimer timer(FS_SESSION_PERSIST);
+    int fd = open(_filepath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666);
+    if (fd == -1) {
+        _error = errno;
+        return;
+    }
+    // Ajoute une ligne vide avant [General] si le fichier n'est pas vide
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        _record.insert(0, "\n");
+    }
+    const char* data = _record.data();
+    size_t length = _record.size();
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            _error = errno;
+            break;
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+    close(fd);
+}
+
+// Personne n'attend la fin de l'ecriture
+void SessionWriteJob::finish(Server& server, int clientFd, HTTPRequest& request, ResponseWriter& output) {
+    (void)server;
+    (void)clientFd;
+    (void)request;
+    (void)output;
+}
+
+void SessionWriteJob::finishDetached() {
+    if (_error != 0) {
+        Logger::instance().log(ERROR, "Unable to save session to " + _filepath + ": " + strerror(_error));
+    }
 }
 
 void SessionManager::loadSession() {
+    FsTimer timer(FS_SESSION_LOAD);
     std::string filepath = "sessions/" + _session_id + ".txt";
     std::ifstream file(filepath.c_str());
     if (!file.is_open()) {
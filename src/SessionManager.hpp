@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Logger.hpp"
+#include "DiskPool.hpp"
 #include <string>
 #include <cstring>
 #include <sstream>
@@ -39,3 +40,18 @@ public:
 	bool getFirstCon() const;	
 };
 
+// Ajout d'un enregistrement au fichier de session, sur un thread du DiskPool : la reponse ne l'attend pas.
+// Serialise sur le fichier : les enregistrements d'une session y arrivent dans l'ordre des requetes.
+class SessionWriteJob : public DiskJob {
+private:
+	std::string	_filepath;
+	std::string	_record;
+	int			_error; // errno de l'echec, 0 si l'enregistrement est ecrit
+
+public:
+	SessionWriteJob(const std::string& filepath, std::string& record);
+
+	virtual void run();
+	virtual void finish(Server& server, int clientFd, HTTPRequest& request, ResponseWriter& output);
+	virtual void finishDetached();
+};
@@ -1,6 +1,8 @@
 #include "Socket.hpp"
 #include "Logger.hpp"
 #include <fcntl.h>
+#include <netdb.h>
+#include <netinet/tcp.h>
 #include <cstring>
 #include <iostream>
 
@@ -8,14 +10,31 @@ bool Socket::operator==(int fd) const {
 	return (this->_socket_fd == fd);
 }
 
-Socket::Socket(int p_port) : _socket_fd(-1), _port(p_port) {
-	memset(&address, 0, sizeof(address));
-	address.sin_family = AF_INET;
-	address.sin_port = htons(_port);
-	address.sin_addr.s_addr = INADDR_ANY;
+Socket::Socket(int p_port) : _socket_fd(-1), _port(p_port), _address_len(0) {
+	_listen.port = p_port;
+	resolveAddress("", _port, address, _address_len);
 	socket_creation();
 }
 
+Socket::Socket(const ListenDirective& p_listen) : _socket_fd(-1), _port(p_listen.port), _address_len(0), _listen(p_listen) {
+	if (!resolveAddress(_listen.host, _port, address, _address_len)) {
+		Logger::instance().log(ERROR, "Unable to resolve listen address: " + _listen.host);
+		return;
+	}
+	socket_creation();
+}
+
+Socket::Socket(const ListenDirective& p_listen, int p_inherited_fd)
+	: _socket_fd(p_inherited_fd), _port(p_listen.port), _address_len(sizeof(address)), _listen(p_listen) {
+	memset(&address, 0, sizeof(address));
+	if (getsockname(_socket_fd, (struct sockaddr *)&address, &_address_len) == -1) {
+		Logger::instance().log(WARNING, std::string("getsockname() failed on inherited socket: ") + strerror(errno));
+	}
+	if (fcntl(_socket_fd, F_SETFL, O_NONBLOCK) == -1) {
+		Logger::instance().log(WARNING, std::string("Failed to set inherited socket non-blocking: ") + strerror(errno));
+	}
+}
+
 Socket::~Socket() {
 	if (_socket_fd != -1) {
 		// std::cout << "Fermeture du socket FD: " << _socket_fd << std::endl;
@@ -25,9 +44,9 @@ Socket::~Socket() {
 }
 
 void Socket::socket_creation() {
-	_socket_fd = socket(AF_INET, SOCK_STREAM, 0);
-	if (address.sin_family != AF_INET) {
-		Logger::instance().log(WARNING, "Erreur: mauvaise famille d'adresses pour le socket: " + to_string(address.sin_family));
+	_socket_fd = socket(address.ss_family, SOCK_STREAM, 0);
+	if (address.ss_family != AF_INET && address.ss_family != AF_INET6) {
+		Logger::instance().log(WARNING, "Erreur: mauvaise famille d'adresses pour le socket: " + to_string(address.ss_family));
 	}
 
 	if (_socket_fd == -1) {
@@ -36,27 +55,20 @@ void Socket::socket_creation() {
 	}
 	// std::cout << "Socket successfully created with FD: " << _socket_fd << " for port: " << _port << std::endl;
 
-	// Rendre le socket non bloquant
-	// int flags = fcntl(_socket_fd, F_GETFL, 0);
-	// if (flags == -1) {
-	// 	std::cerr << "fcntl(F_GETFL) failed for FD: " << _socket_fd << " Error: " << strerror(errno) << std::endl;
-	// 	close(_socket_fd);
-	// 	_socket_fd = -1;
-	// 	return;
-	// }
-
-	// if (fcntl(_socket_fd, F_SETFL, flags | O_NONBLOCK) == -1) {
-	// 	std::cerr << "fcntl(F_SETFL) failed for FD: " << _socket_fd << " Error: " << strerror(errno) << std::endl;
-	// 	close(_socket_fd);
-	// 	_socket_fd = -1;
-	// 	return;
-	// }
-	// std::cout << "Socket FD: " << _socket_fd << " set to non-blocking mode." << std::endl;
+	// Non bloquant : la boucle accepte jusqu'a EAGAIN sans risquer de se bloquer sur une file vide
+	if (fcntl(_socket_fd, F_SETFL, O_NONBLOCK) == -1) {
+		Logger::instance().log(ERROR, std::string("Failed to set listening socket non-blocking: ") + strerror(errno));
+		close(_socket_fd);
+		_socket_fd = -1;
+		return;
+	}
 }
 
 
 void Socket::socket_binding() {
-	int add_size = sizeof(address);
+	if (_socket_fd == -1) {
+		return;
+	}
 
 	// Set socket options to allow reuse of the address and port
 	int opt = 1;
@@ -67,17 +79,20 @@ void Socket::socket_binding() {
 		return;
 	}
 
-	if (bind(_socket_fd, (struct sockaddr *)&address, add_size) == -1) {
+	apply_listen_options();
+
+	if (bind(_socket_fd, (struct sockaddr *)&address, _address_len) == -1) {
 		Logger::instance().log(ERROR, std::string("Failed to bind socket to IP address and port: " ) + strerror(errno));
 		close(_socket_fd);
 		_socket_fd = -1;
 		return;
 	}
-	Logger::instance().log(INFO, "Socket " + to_string(_socket_fd) + " successfully bound to port " + to_string(_port));
+	Logger::instance().log(INFO, "Socket " + to_string(_socket_fd) + " successfully bound to " + formatAddress(address) + ":" + to_string(_port));
 }
 
 void Socket::socket_listening() {
-	int ret = listen(_socket_fd, SOMAXCONN);
+	int backlog = (_listen.backlog > 0) ? _listen.backlog : SOMAXCONN;
+	int ret = listen(_socket_fd, backlog);
 	Logger::instance().log(DEBUG, "listen() returned: " + to_string(ret));
 	if (ret == -1) {
 		Logger::instance().log(ERROR, std::string("Failed to put socket in listening mode: ") + strerror(errno));
@@ -97,10 +112,95 @@ int Socket::getPort() const {
 	return _port;
 }
 
-sockaddr_in& Socket::getAddress() {
+sockaddr_storage& Socket::getAddress() {
 	return address;
 }
 
+// Options par listen : IPV6_V6ONLY (les listeners IPv4 et IPv6 cohabitent), SO_REUSEPORT,
+// TCP_DEFER_ACCEPT et TCP_FASTOPEN. Une option non supportee n'est pas fatale.
+void Socket::apply_listen_options() {
+	int on = 1;
+	if (address.ss_family == AF_INET6) {
+		if (setsockopt(_socket_fd, IPPROTO_IPV6, IPV6_V6ONLY, &on, sizeof(on)) < 0) {
+			Logger::instance().log(WARNING, std::string("setsockopt(IPV6_V6ONLY) failed: ") + strerror(errno));
+		}
+	}
+	if (_listen.reusePort) {
+#ifdef SO_REUSEPORT
+		if (setsockopt(_socket_fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0) {
+			Logger::instance().log(WARNING, std::string("setsockopt(SO_REUSEPORT) failed: ") + strerror(errno));
+		}
+#else
+		Logger::instance().log(WARNING, "reuseport is not supported on this platform");
+#endif
+	}
+	if (_listen.deferAccept > 0) {
+#ifdef TCP_DEFER_ACCEPT
+		int seconds = _listen.deferAccept;
+		if (setsockopt(_socket_fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &seconds, sizeof(seconds)) < 0) {
+			Logger::instance().log(WARNING, std::string("setsockopt(TCP_DEFER_ACCEPT) failed: ") + strerror(errno));
+		}
+#else
+		Logger::instance().log(WARNING, "deferred is not supported on this platform");
+#endif
+	}
+	if (_listen.fastOpen > 0) {
+#ifdef TCP_FASTOPEN
+		int qlen = _listen.fastOpen;
+		if (setsockopt(_socket_fd, IPPROTO_TCP, TCP_FASTOPEN, &qlen, sizeof(qlen)) < 0) {
+			Logger::instance().log(WARNING, std::string("setsockopt(TCP_FASTOPEN) failed: ") + strerror(errno));
+		}
+#else
+		Logger::instance().log(WARNING, "fastopen is not supported on this platform");
+#endif
+	}
+}
+
+bool Socket::resolveAddress(const std::string& host, int port, sockaddr_storage& addr, socklen_t& len) {
+	memset(&addr, 0, sizeof(addr));
+	if (host.empty() || host == "0.0.0.0") {
+		sockaddr_in* in = reinterpret_cast<sockaddr_in*>(&addr);
+		in->sin_family = AF_INET;
+		in->sin_port = htons(port);
+		in->sin_addr.s_addr = INADDR_ANY;
+		len = sizeof(sockaddr_in);
+		return true;
+	}
+
+	struct addrinfo hints;
+	struct addrinfo* result = NULL;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE;
+	std::string service = to_string(port);
+	int err = getaddrinfo(host.c_str(), service.c_str(), &hints, &result);
+	if (err != 0 || result == NULL) {
+		Logger::instance().log(ERROR, "getaddrinfo(" + host + ") failed: " + gai_strerror(err));
+		return false;
+	}
+	memcpy(&addr, result->ai_addr, result->ai_addrlen);
+	len = result->ai_addrlen;
+	freeaddrinfo(result);
+	return true;
+}
+
+std::string Socket::formatAddress(const sockaddr_storage& addr) {
+	char buffer[INET6_ADDRSTRLEN];
+	if (addr.ss_family == AF_INET6) {
+		const sockaddr_in6* in6 = reinterpret_cast<const sockaddr_in6*>(&addr);
+		if (inet_ntop(AF_INET6, &in6->sin6_addr, buffer, sizeof(buffer)) == NULL) {
+			return "[?]";
+		}
+		return std::string("[") + buffer + "]";
+	}
+	const sockaddr_in* in = reinterpret_cast<const sockaddr_in*>(&addr);
+	if (inet_ntop(AF_INET, &in->sin_addr, buffer, sizeof(buffer)) == NULL) {
+		return "?";
+	}
+	return buffer;
+}
+
 void Socket::build_sockets() {
 	socket_binding();
 	if (_socket_fd != -1) {
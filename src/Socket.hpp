@@ -1,4 +1,3 @@
-
 #pragma once 
 
 #include <sys/socket.h> // Fonction socket() + types AF_INET & SOCK_STREAM
@@ -9,17 +8,24 @@
 #include <iostream>
 #include <sstream>
 #include <cerrno>
+#include "ListenDirective.hpp"
 
 class Socket
 {
 private:
     int _socket_fd;
     int _port;
-    struct sockaddr_in address;
+    struct sockaddr_storage address; // IPv4 ou IPv6
+    socklen_t _address_len;
+    ListenDirective _listen;
     // int new_sockets[10]; // Need to use vector later ?
 
+    void    apply_listen_options();
+
 public:
     Socket(int p_port);
+    Socket(const ListenDirective& p_listen);
+    Socket(const ListenDirective& p_listen, int p_inherited_fd); // Socket deja ecoutante (binary upgrade)
     ~Socket();
 
     // Socket creation
@@ -35,8 +41,12 @@ public:
     bool    operator==(int fd) const;
     int     getSocket() const;
     int     getPort() const;
-    sockaddr_in& getAddress() ;
+    sockaddr_storage& getAddress() ;
 
     void    build_sockets();
     void    close_sockets();
+
+    // Resolution "host:port" -> sockaddr (numerique ou via getaddrinfo)
+    static bool         resolveAddress(const std::string& host, int port, sockaddr_storage& addr, socklen_t& len);
+    static std::string  formatAddress(const sockaddr_storage& addr);
 };
@@ -0,0 +1,97 @@
+// StatusLine.cpp
+#include "StatusLine.hpp"
+#include <ctime>
+#include <cstring>
+
+#define STATUS(code, reason) { code, reason, "HTTP/1.1 " #code " " reason "\r\n", sizeof("HTTP/1.1 " #code " " reason "\r\n") - 1 }
+
+// Triee par code pour la recherche dichotomique
+static const StatusLine statusTable[] = {
+    STATUS(100, "Continue"),
+    STATUS(200, "OK"),
+    STATUS(201, "Created"),
+    STATUS(204, "No Content"),
+    STATUS(206, "Partial Content"),
+    STATUS(301, "Moved Permanently"),  // ressource definitivement deplacee vers l'URL du header Location
+    STATUS(302, "Found"),
+    STATUS(303, "See Other"),          // reponse a un PUT ou POST, redirige vers une autre page que la ressource televersee
+    STATUS(304, "Not Modified"),
+    STATUS(307, "Temporary Redirect"), // ressource temporairement deplacee vers l'URL du header Location
+    STATUS(308, "Permanent Redirect"), // comme 301, la methode et le corps sont conserves
+    STATUS(400, "Bad Request"),
+    STATUS(401, "Unauthorized"),
+    STATUS(403, "Forbidden"),
+    STATUS(404, "Not Found"),
+    STATUS(405, "Method Not Allowed"),
+    STATUS(408, "Request Timeout"),    // requete pas complete dans le delai
+    STATUS(411, "Length Required"),
+    STATUS(413, "Payload Too Large"),  // corps au-dela de client_max_body_size
+    STATUS(414, "URI Too Long"),       // ligne de requete plus grande qu'un large_client_header_buffers
+    STATUS(415, "Unsupported Media Type"),
+    STATUS(416, "Range Not Satisfiable"),
+    STATUS(418, "I'm a teapot"),
+    STATUS(429, "Too Many Requests"),
+    STATUS(431, "Request Header Fields Too Large"), // headers au-dela de large_client_header_buffers
+    STATUS(500, "Internal Server Error"),
+    STATUS(501, "Method Not Implemented"),
+    STATUS(502, "Bad Gateway"),        // reponse invalide d'un serveur en amont
+    STATUS(503, "Service Unavailable"), // surcharge, maintenance, arret en cours
+    STATUS(504, "Gateway Timeout"),
+    STATUS(505, "HTTP Version Not Supported")
+};
+
+#undef STATUS
+
+const StatusLine* statusLineFor(int code) {
+    size_t low = 0;
+    size_t high = sizeof(statusTable) / sizeof(statusTable[0]);
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (statusTable[middle].code == code) {
+            return &statusTable[middle];
+        }
+        if (statusTable[middle].code < code) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return NULL;
+}
+
+namespace DateCache {
+
+static char cached[DATE_HEADERS_MAX];
+static size_t cachedLength = 0;
+static time_t cachedSecond = -1;
+
+void refresh(unsigned long nowMs) {
+    time_t second = static_cast<time_t>(nowMs / 1000);
+    if (second == cachedSecond) {
+        return;
+    }
+    struct tm utc;
+    gmtime_r(&second, &utc);
+    // Locale "C" par defaut : noms de jour et de mois anglais, comme l'exige l'IMF-fixdate
+    size_t length = std::strftime(cached, sizeof(cached), "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &utc);
+    static const char server[] = "Server: " SERVER_SOFTWARE "\r\n";
+    std::memcpy(cached + length, server, sizeof(server) - 1);
+    cachedLength = length + sizeof(server) - 1;
+    cachedSecond = second;
+}
+
+const char* headers() {
+    if (cachedSecond == -1) {
+        refresh(static_cast<unsigned long>(time(NULL)) * 1000);
+    }
+    return cached;
+}
+
+size_t length() {
+    if (cachedSecond == -1) {
+        refresh(static_cast<unsigned long>(time(NULL)) * 1000);
+    }
+    return cachedLength;
+}
+
+}
@@ -0,0 +1,36 @@
+// StatusLine.hpp
+#ifndef STATUSLINE_HPP
+#define STATUSLINE_HPP
+
+#include <cstddef>
+
+#define SERVER_SOFTWARE "webserv"
+
+// Ligne de statut preformatee, envoyee telle quelle
+struct StatusLine {
+    int code;
+    const char* reason;
+    const char* line;   // "HTTP/1.1 NNN Reason\r\n"
+    size_t length;
+};
+
+// NULL si le code n'est pas dans la table (raison "Unknown", ligne formatee a l'envoi)
+const StatusLine* statusLineFor(int code);
+
+/*
+ * Headers "Date:" et "Server:" communs a toutes les reponses, formates une
+ * seule fois par seconde : refresh() est appele a chaque tour de boucle
+ * et ne reformate que si la seconde a change.
+ */
+namespace DateCache {
+
+#define DATE_HEADERS_MAX 96
+
+void refresh(unsigned long nowMs);
+// "Date: <IMF-fixdate>\r\nServer: webserv\r\n"
+const char* headers();
+size_t length();
+
+}
+
+#endif
@@ -0,0 +1,153 @@
+// TimerWheel.cpp
+#include "TimerWheel.hpp"
+
+#define TIMER_MASK (TIMER_SLOTS - 1)
+#define TIMER_MAX_DELTA ((1UL << (TIMER_LEVEL_BITS * TIMER_LEVELS)) - 1)
+
+TimerWheel::TimerWheel(unsigned long now) : _currentTick(now / TIMER_TICK_MS), _count(0) {
+    for (int level = 0; level < TIMER_LEVELS; ++level) {
+        for (int slot = 0; slot < TIMER_SLOTS; ++slot) {
+            _slots[level][slot] = NULL;
+        }
+    }
+}
+
+TimerWheel::~TimerWheel() {}
+
+bool TimerWheel::isArmed(const TimerNode& node) const {
+    return node.slot != NULL;
+}
+
+void TimerWheel::arm(TimerNode& node, TimerPhase phase, unsigned long expires) {
+    if (isArmed(node)) {
+        disarm(node);
+    }
+    node.phase = phase;
+    node.expires = expires;
+    place(node, false);
+    ++_count;
+}
+
+void TimerWheel::disarm(TimerNode& node) {
+    if (!isArmed(node)) {
+        return;
+    }
+    if (node.prev != NULL) {
+        node.prev->next = node.next;
+    } else {
+        *node.slot = node.next;
+    }
+    if (node.next != NULL) {
+        node.next->prev = node.prev;
+    }
+    node.prev = NULL;
+    node.next = NULL;
+    node.slot = NULL;
+    node.phase = TIMER_NONE;
+    --_count;
+}
+
+// `cascading` : appele par cascade() avant le traitement de la case courante, qui peut encore recevoir le noeud
+void TimerWheel::place(TimerNode& node, bool cascading) {
+    unsigned long expiresTick = (node.expires + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+    unsigned long firstTick = cascading ? _currentTick : _currentTick + 1;
+    if (expiresTick < firstTick) {
+        expiresTick = firstTick; // Deja expire : traite au plus tot
+    }
+    unsigned long delta = expiresTick - _currentTick;
+    if (delta > TIMER_MAX_DELTA) {
+        expiresTick = _currentTick + TIMER_MAX_DELTA;
+        delta = TIMER_MAX_DELTA;
+    }
+
+    int level = 0;
+    while (level < TIMER_LEVELS - 1 && delta >= (1UL << (TIMER_LEVEL_BITS * (level + 1)))) {
+        ++level;
+    }
+    TimerNode** head = &_slots[level][(expiresTick >> (TIMER_LEVEL_BITS * level)) & TIMER_MASK];
+
+    node.slot = head;
+    node.prev = NULL;
+    node.next = *head;
+    if (*head != NULL) {
+        (*head)->prev = &node;
+    }
+    *head = &node;
+}
+
+// Redescend les timers d'une case du niveau `level` quand le niveau inferieur a fait un tour
+void TimerWheel::cascade(int level) {
+    if (level >= TIMER_LEVELS) {
+        return;
+    }
+    unsigned long index = (_currentTick >> (TIMER_LEVEL_BITS * level)) & TIMER_MASK;
+    if (index == 0) {
+        cascade(level + 1);
+    }
+    TimerNode* node = _slots[level][index];
+    _slots[level][index] = NULL;
+    while (node != NULL) {
+        TimerNode* next = node->next;
+        place(*node, true);
+        node = next;
+    }
+}
+
+void TimerWheel::advance(unsigned long now, std::vector<TimerNode*>& expired) {
+    unsigned long nowTick = now / TIMER_TICK_MS;
+    while (_currentTick < nowTick) {
+        if (_count == 0) {
+            _currentTick = nowTick;
+            break;
+        }
+        ++_currentTick;
+        unsigned long index = _currentTick & TIMER_MASK;
+        if (index == 0) {
+            cascade(1);
+        }
+        TimerNode* node = _slots[0][index];
+        _slots[0][index] = NULL;
+        while (node != NULL) {
+            TimerNode* next = node->next;
+            node->prev = NULL;
+            node->next = NULL;
+            node->slot = NULL;
+            --_count;
+            expired.push_back(node);
+            node = next;
+        }
+    }
+}
+
+int TimerWheel::nextTimeout(unsigned long now) const {
+    if (_count == 0) {
+        return -1;
+    }
+    // Niveau 0 : expiration ; au-dessus : prochaine redescente d'une case non vide, qui peut
+    // preceder l'expiration trouvee plus bas. On garde la plus proche.
+    unsigned long targetTick = 0;
+    for (int level = 0; level < TIMER_LEVELS; ++level) {
+        unsigned long base = _currentTick >> (TIMER_LEVEL_BITS * level);
+        if (targetTick != 0 && ((base + 1) << (TIMER_LEVEL_BITS * level)) >= targetTick) {
+            break; // Aucune redescente de ce niveau ou au-dessus ne peut venir avant
+        }
+        for (unsigned long k = 1; k <= TIMER_SLOTS; ++k) {
+            if (_slots[level][(base + k) & TIMER_MASK] != NULL) {
+                unsigned long tick = (base + k) << (TIMER_LEVEL_BITS * level);
+                if (targetTick == 0 || tick < targetTick) {
+                    targetTick = tick;
+                }
+                break;
+            }
+        }
+    }
+    unsigned long targetMs = targetTick * TIMER_TICK_MS;
+    if (targetMs <= now) {
+        return 0;
+    }
+    return static_cast<int>(targetMs - now);
+}
+
+size_t TimerWheel::size() const {
+    return _count;
+}
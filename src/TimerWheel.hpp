@@ -0,0 +1,60 @@
+// TimerWheel.hpp
+#ifndef TIMERWHEEL_HPP
+#define TIMERWHEEL_HPP
+
+#include <vector>
+#include <cstddef>
+
+#define TIMER_TICK_MS 10
+#define TIMER_LEVELS 4
+#define TIMER_LEVEL_BITS 6
+#define TIMER_SLOTS (1 << TIMER_LEVEL_BITS)
+
+// Phases d'une connexion, chacune avec son propre delai (configurable par server)
+enum TimerPhase { TIMER_NONE, TIMER_HEADER, TIMER_BODY, TIMER_KEEPALIVE, TIMER_SEND };
+
+// Noeud intrusif : embarque dans l'etat de la connexion, aucune allocation a l'armement
+struct TimerNode {
+    int fd;
+    TimerPhase phase;
+    unsigned long expires; // en ms
+    TimerNode* prev;
+    TimerNode* next;
+    TimerNode** slot; // Case qui contient le noeud, pour un retrait en O(1)
+    TimerNode() : fd(-1), phase(TIMER_NONE), expires(0), prev(NULL), next(NULL), slot(NULL) {}
+};
+
+/*
+ * Roue temporelle hierarchique (4 niveaux de 64 cases, tick de 10 ms) :
+ * arm/disarm en O(1), les timers lointains redescendent d'un niveau quand la
+ * roue inferieure fait un tour. Couvre ~46 h, au-dela le timer est borne a la
+ * derniere case. nextTimeout() donne directement le timeout de poll().
+ */
+class TimerWheel {
+public:
+    TimerWheel(unsigned long now);
+    ~TimerWheel();
+
+    void arm(TimerNode& node, TimerPhase phase, unsigned long expires);
+    void disarm(TimerNode& node);
+    bool isArmed(const TimerNode& node) const;
+
+    // Avance jusqu'a `now` et retourne les timers expires (desarmes, `phase` conservee)
+    void advance(unsigned long now, std::vector<TimerNode*>& expired);
+    // Delai en ms avant le prochain traitement necessaire, -1 si aucun timer
+    int nextTimeout(unsigned long now) const;
+    size_t size() const;
+
+private:
+    TimerWheel(const TimerWheel&);
+    TimerWheel& operator=(const TimerWheel&);
+
+    void place(TimerNode& node, bool cascading);
+    void cascade(int level);
+
+    TimerNode* _slots[TIMER_LEVELS][TIMER_SLOTS];
+    unsigned long _currentTick;
+    size_t _count;
+};
+
+#endif
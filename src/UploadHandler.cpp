@@ -1,8 +1,69 @@
 #include <fstream>
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
 #include "Logger.hpp"
 #include "ServerConfig.hpp"
 #include "UploadHandler.hpp"
+#include "Server.hpp"
+#include "FsStats.hpp"
+
+// Ecrit tout `length`, en reprenant les ecritures partielles ; 0 ou errno
+static int writeAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+    return 0;
+}
+
+// Blocs entiers en O_DIRECT via un tampon aligne ; `done` recoit ce qui est ecrit.
+// EINVAL (alignement refuse par le systeme de fichiers) n'est pas une erreur : le reste
+// passe par le cache.
+static int writeDirect(int fd, const char* data, size_t length, size_t& done) {
+    done = 0;
+    size_t aligned = length - length % UPLOAD_DIRECT_ALIGN;
+    if (aligned == 0) {
+        return 0;
+    }
+    void* buffer = NULL;
+    if (posix_memalign(&buffer, UPLOAD_DIRECT_ALIGN, UPLOAD_DIRECT_CHUNK) != 0) {
+        return 0;
+    }
+    int error = 0;
+    while (done < aligned) {
+        size_t chunk = aligned - done;
+        if (chunk > UPLOAD_DIRECT_CHUNK) {
+            chunk = UPLOAD_DIRECT_CHUNK;
+        }
+        std::memcpy(buffer, data + done, chunk);
+        ssize_t written = write(fd, buffer, chunk);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error = (errno == EINVAL) ? 0 : errno;
+            break;
+        }
+        done += static_cast<size_t>(written);
+        if (static_cast<size_t>(written) != chunk) {
+            break; // Ecriture courte : la suite n'est plus alignee
+        }
+    }
+    free(buffer);
+    return error;
+}
 
 bool UploadHandler::checkDestPath(std::string path)
 {
@@ -11,24 +72,242 @@ bool UploadHandler::checkDestPath(std::string path)
 	return false;
 }
 
-UploadHandler::UploadHandler(const std::string& destPath, const std::string& fileContent, const ServerConfig& config)
-    : _destPath(destPath) {
-    (void)config;
-    if (!checkDestPath(destPath)) {
-        throw forbiddenDest();
+UploadHandler::UploadHandler(int clientFd, unsigned long ticket, const ServerConfig& config, std::vector<Part>& parts, std::string& body)
+    : DiskJob(clientFd, ticket), _fsync(config.uploadFsync),
+      _directIo(static_cast<size_t>(config.uploadDirectIo)), _error(0), _failedPart(0) {
+    for (size_t i = 0; i < parts.size(); ++i) {
+        if (!checkDestPath(parts[i].destPath)) {
+            throw forbiddenDest();
+        }
+    }
+    _parts.swap(parts);
+    _body.swap(body);
+}
+
+UploadHandler::~UploadHandler()
+{
+}
+
+size_t UploadHandler::parts() const {
+    return _parts.size();
+}
+
+size_t UploadHandler::bytes() const {
+    size_t total = 0;
+    for (size_t i = 0; i < _parts.size(); ++i) {
+        total += _parts[i].length;
     }
-    std::ofstream destFile(destPath.c_str(), std::ios::binary);
-    if (!destFile.is_open()) {
-        Logger::instance().log(ERROR, "Failed to open dest file on server's file system");
-        throw std::runtime_error("Failed to open destination file.");
+    return total;
+}
+
+HeaderTable& UploadHandler::headers() {
+    return _headers;
+}
+
+// Thread du pool : appels systeme seulement, pas de Logger
+void UploadHandler::run() {
+    for (size_t i = 0; i < _parts.size(); ++i) {
+        _error = writePart(_parts[i]);
+        if (_error != 0) {
+            _failedPart = i;
+            return;
+        }
     }
+}
 
-    destFile.write(fileContent.c_str(), fileContent.size());
-    Logger::instance().log(INFO, "Fichier enregistré à : " + destPath);
+bool UploadHandler::direct(const Part& part) const {
+    return _directIo > 0 && part.length >= _directIo;
+}
+
+int UploadHandler::writePart(const Part& part) {
+    FsTimer timer(FS_UPLOAD_WRITE);
+    const char* path = part.destPath.c_str();
+    const char* data = _body.data() + part.offset;
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    bool direct = this->direct(part);
+
+    int fd = open(path, direct ? (flags | O_DIRECT) : flags, 0666);
+    if (fd == -1 && direct && errno == EINVAL) {
+        direct = false; // tmpfs et certains FUSE refusent O_DIRECT
+        fd = open(path, flags, 0666);
+    }
+    if (fd == -1) {
+        return errno;
+    }
 
-    destFile.close();
+    int error = 0;
+    // Taille connue : blocs reserves d'un coup, ENOSPC avant d'avoir ecrit
+    if (part.length > 0 && fallocate(fd, 0, 0, static_cast<off_t>(part.length)) == -1
+        && errno != EOPNOTSUPP && errno != ENOSYS) {
+        error = errno;
+    }
+    size_t written = 0;
+    if (error == 0 && direct) {
+        error = writeDirect(fd, data, part.length, written);
+        // Queue non alignee par le cache
+        if (error == 0 && written < part.length && fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT) == -1) {
+            error = errno;
+        }
+    }
+    if (error == 0) {
+        error = writeAll(fd, data + written, part.length - written);
+    }
+    if (error == 0 && _fsync && fdatasync(fd) == -1) {
+        error = errno;
+    }
+    if (close(fd) == -1 && error == 0) {
+        error = errno;
+    }
+    if (error != 0) {
+        unlink(path); // Pas de fichier tronque laisse dans le repertoire d'upload
+    }
+    return error;
 }
 
-UploadHandler::~UploadHandler()
-{
+enum UploadStep { STEP_OPEN, STEP_FALLOCATE, STEP_WRITE, STEP_FSYNC, STEP_CLOSE };
+
+// Fichier a reprendre apres une chaine terminee : ecriture courte, sans erreur
+bool UploadHandler::ringResumes(size_t part) const {
+    return _ringErrors[part] == 0 && _ringWritten[part] < _parts[part].length;
+}
+
+// Octets du prochain write io_uring de la part
+size_t UploadHandler::ringChunk(size_t part) const {
+    size_t remaining = _parts[part].length - (_ringWritten.empty() ? 0 : _ringWritten[part]);
+    return remaining < UPLOAD_RING_WRITE_MAX ? remaining : UPLOAD_RING_WRITE_MAX;
+}
+
+unsigned UploadHandler::ringOps() const {
+    unsigned ops = 0;
+    for (size_t i = 0; i < _parts.size(); ++i) {
+        if (direct(_parts[i])) {
+            return 0;
+        }
+        bool first = _ringWritten.empty();
+        if (!first && !ringResumes(i)) {
+            continue;
+        }
+        // fallocate sur la premiere chaine seulement ; fsync apres le dernier morceau
+        bool last = _parts[i].length - (first ? 0 : _ringWritten[i]) == ringChunk(i);
+        ops += 3 + (first && _parts[i].length > 0 ? 1 : 0) + (_fsync && last ? 1 : 0);
+    }
+    return ops;
+}
+
+unsigned UploadHandler::ringFiles() const {
+    if (_ringWritten.empty()) {
+        return static_cast<unsigned>(_parts.size());
+    }
+    unsigned files = 0;
+    for (size_t i = 0; i < _parts.size(); ++i) {
+        files += ringResumes(i) ? 1 : 0;
+    }
+    return files;
+}
+
+// Chaine en IOSQE_IO_HARDLINK : un echec ne coupe pas la suite, le close part toujours.
+// Apres un openat rate, les operations suivantes echouent en EBADF sans effet.
+// Premiere chaine : tous les fichiers ; ensuite, la suite de ceux restes courts.
+void UploadHandler::prepareRing(DiskPool& pool) {
+    bool first = _ringWritten.empty();
+    if (first) {
+        _ringErrors.assign(_parts.size(), 0);
+        _ringWritten.assign(_parts.size(), 0);
+    }
+    unsigned files = 0;
+    for (size_t i = 0; i < _parts.size(); ++i) {
+        if (!first && !ringResumes(i)) {
+            continue;
+        }
+        const Part& part = _parts[i];
+        size_t written = _ringWritten[i];
+        size_t chunk = ringChunk(i);
+        unsigned file = pool.ringFile(this, files++);
+        unsigned base = static_cast<unsigned>(i) * UPLOAD_RING_STEPS;
+
+        struct io_uring_sqe* sqe = pool.ringOp(this, base + STEP_OPEN);
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->flags = IOSQE_IO_HARDLINK;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = reinterpret_cast<uintptr_t>(part.destPath.c_str());
+        sqe->len = 0666;
+        // O_CLOEXEC refuse (EINVAL) : aucun fd n'est cree
+        sqe->open_flags = first ? (O_WRONLY | O_CREAT | O_TRUNC) : O_WRONLY;
+        sqe->file_index = file + 1; // Installe dans la table fixe
+
+        if (first && part.length > 0) {
+            sqe = pool.ringOp(this, base + STEP_FALLOCATE);
+            sqe->opcode = IORING_OP_FALLOCATE;
+            sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+            sqe->fd = static_cast<int>(file);
+            sqe->off = 0;
+            sqe->addr = part.length; // Longueur dans addr pour fallocate
+        }
+
+        sqe = pool.ringOp(this, base + STEP_WRITE);
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+        sqe->fd = static_cast<int>(file);
+        sqe->addr = reinterpret_cast<uintptr_t>(_body.data() + part.offset + written);
+        sqe->len = static_cast<unsigned>(chunk); // Borne par UPLOAD_RING_WRITE_MAX
+        sqe->off = written;
+
+        if (_fsync && written + chunk == part.length) {
+            sqe = pool.ringOp(this, base + STEP_FSYNC);
+            sqe->opcode = IORING_OP_FSYNC;
+            sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+            sqe->fd = static_cast<int>(file);
+            sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        }
+
+        sqe = pool.ringOp(this, base + STEP_CLOSE);
+        sqe->opcode = IORING_OP_CLOSE;
+        sqe->file_index = file + 1;
+    }
+}
+
+void UploadHandler::fail(size_t part, int error) {
+    if (_ringErrors[part] == 0) {
+        _ringErrors[part] = error;
+    }
+    if (_error == 0 || part < _failedPart) {
+        _error = error;
+        _failedPart = part;
+    }
+}
+
+// Thread principal ; les completions d'une chaine arrivent dans l'ordre
+void UploadHandler::ringResult(unsigned step, int result) {
+    size_t part = step / UPLOAD_RING_STEPS;
+    unsigned kind = step % UPLOAD_RING_STEPS;
+    if (kind == STEP_FALLOCATE && (result == -EOPNOTSUPP || result == -ENOSYS)) {
+        return; // Systeme de fichiers sans fallocate : l'ecriture alloue
+    }
+    if (result < 0) {
+        fail(part, -result);
+    } else if (kind == STEP_WRITE) {
+        if (result == 0 && ringChunk(part) > 0) {
+            fail(part, EIO); // Aucun progres : une nouvelle chaine ne ferait pas mieux
+        }
+        _ringWritten[part] += static_cast<size_t>(result); // Reste repris par une nouvelle chaine
+    }
+    if (kind == STEP_CLOSE && _ringErrors[part] != 0) {
+        unlink(_parts[part].destPath.c_str()); // Pas de fichier tronque laisse dans le repertoire d'upload
+    }
+}
+
+void UploadHandler::finish(Server& server, int clientFd, HTTPRequest& request, ResponseWriter& output) {
+    server.completeUpload(clientFd, request, *this, output);
+}
+
+int UploadHandler::error() const {
+    return _error;
+}
+
+const std::string& UploadHandler::failedPath() const {
+    return _parts[_failedPart].destPath;
+}
+
+const std::string& UploadHandler::lastPath() const {
+    return _parts.back().destPath;
 }
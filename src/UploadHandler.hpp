@@ -1,11 +1,58 @@
+// UploadHandler.hpp
+#ifndef UPLOADHANDLER_HPP
+#define UPLOADHANDLER_HPP
+
 #include <fstream>
 #include <iostream>
+#include <vector>
 #include "ServerConfig.hpp"
+#include "DiskPool.hpp"
+#include "HeaderTable.hpp"
 
+#define UPLOAD_DIRECT_ALIGN 4096           // Alignement memoire et taille des ecritures O_DIRECT
+#define UPLOAD_DIRECT_CHUNK (1024 * 1024)  // Tampon aligne pour O_DIRECT
+#define UPLOAD_RING_STEPS 5                // openat, fallocate, write, fsync, close par fichier
+#ifndef UPLOAD_RING_WRITE_MAX
+# define UPLOAD_RING_WRITE_MAX 0x7ffff000  // Octets max par write io_uring (MAX_RW_COUNT du noyau)
+#endif
+
+/*
+ * Fichiers d'un upload multipart, ecrits sur un thread du DiskPool.
+ * Le job garde le corps de la requete (repris par echange) ; chaque part
+ * y est un intervalle, ecrit sans copie : fallocate de la taille connue,
+ * O_DIRECT au-dela de upload_directio, fdatasync si upload_fsync.
+ * Un fichier en erreur est supprime et les suivants ne sont pas ecrits.
+ * Avec io_uring, chaque fichier est une chaine liee des memes operations
+ * sur un descripteur fixe, fichiers ecrits en parallele ; les fichiers
+ * O_DIRECT (tampon aligne, queue sans O_DIRECT) restent sur les threads.
+ * Une ecriture courte (ou bornee a UPLOAD_RING_WRITE_MAX) est reprise par
+ * une nouvelle chaine openat, write, fsync, close a partir de l'octet atteint.
+ */
+class UploadHandler : public DiskJob {
+public:
+    // Fichier a ecrire : intervalle du corps de la requete
+    struct Part {
+        std::string destPath;
+        size_t offset;
+        size_t length;
+    };
 
-class UploadHandler {
 private:
-    std::string _destPath;
+    std::string _body;
+    std::vector<Part> _parts;
+    HeaderTable _headers; // Headers deja poses sur la reponse (Set-Cookie de session)
+    bool _fsync;
+    size_t _directIo;
+    int _error;          // errno du premier echec, 0 si tout est ecrit
+    size_t _failedPart;
+    std::vector<int> _ringErrors; // Par fichier, chemin io_uring
+    std::vector<size_t> _ringWritten; // Par fichier, octets deja ecrits par la ring ; vide avant la premiere chaine
+
+    int writePart(const Part& part);
+    bool direct(const Part& part) const;
+    bool ringResumes(size_t part) const;
+    size_t ringChunk(size_t part) const;
+    void fail(size_t part, int error);
 
 public:
     class forbiddenDest : public std::exception {
@@ -18,6 +65,24 @@ public:
 
 	bool checkDestPath(std::string path);
 
-    UploadHandler(const std::string& destPath, const std::string& fileContent, const ServerConfig& config);
+    // Reprend `parts` et `body` par echange ; forbiddenDest si une destination est vide
+    UploadHandler(int clientFd, unsigned long ticket, const ServerConfig& config, std::vector<Part>& parts, std::string& body);
     ~UploadHandler();
+
+    HeaderTable& headers();
+    size_t parts() const;
+    size_t bytes() const; // Somme des parties
+
+    virtual void run();
+    virtual unsigned ringOps() const;
+    virtual unsigned ringFiles() const;
+    virtual void prepareRing(DiskPool& pool);
+    virtual void ringResult(unsigned step, int result);
+    virtual void finish(Server& server, int clientFd, HTTPRequest& request, ResponseWriter& output);
+
+    int error() const;
+    const std::string& failedPath() const;
+    const std::string& lastPath() const;
 };
+
+#endif
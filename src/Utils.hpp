@@ -5,7 +5,9 @@
 #include <string>
 #include <unistd.h>
 
-#define TIMEOUT_MS 30000
+#define TIMEOUT_MS 30000 // Defaut de client_header_timeout, client_body_timeout et send_timeout
+#define KEEPALIVE_TIMEOUT_MS 15000 // Defaut de keepalive_timeout (0 desactive le keep-alive)
+#define SHUTDOWN_TIMEOUT_MS 10000 // Delai max du drain (SIGTERM / SIGQUIT / fin d'upgrade)
 
 template <typename T>
 std::string to_string(T value) {
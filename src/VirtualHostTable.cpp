@@ -0,0 +1,155 @@
+// VirtualHostTable.cpp
+#include "VirtualHostTable.hpp"
+#include "Logger.hpp"
+#include <cctype>
+
+VirtualHostTable::VirtualHostTable() : _defaultServer(NULL), _hasExplicitDefault(false) {}
+
+VirtualHostTable::~VirtualHostTable() {}
+
+void VirtualHostTable::addServer(Server* server, const std::vector<std::string>& serverNames, bool isDefault) {
+    // Le premier server declare sur un listener est le default server (comme nginx), sauf `default_server`
+    if (_defaultServer == NULL || (isDefault && !_hasExplicitDefault)) {
+        _defaultServer = server;
+        _hasExplicitDefault = isDefault;
+    } else if (isDefault) {
+        Logger::instance().log(WARNING, "Duplicate default_server on the same listener, ignored");
+    }
+    for (size_t i = 0; i < serverNames.size(); ++i) {
+        Entry entry;
+        entry.name = serverNames[i];
+        for (size_t j = 0; j < entry.name.size(); ++j) {
+            entry.name[j] = static_cast<char>(std::tolower(static_cast<unsigned char>(entry.name[j])));
+        }
+        if (!entry.name.empty() && entry.name[entry.name.size() - 1] == '.') {
+            entry.name.erase(entry.name.size() - 1);
+        }
+        entry.server = server;
+        _entries.push_back(entry);
+    }
+}
+
+size_t VirtualHostTable::tableCapacity(size_t count) {
+    // Puissance de deux, facteur de charge <= 0.5
+    size_t capacity = 8;
+    while (capacity < count * 2) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+void VirtualHostTable::build() {
+    size_t exactCount = 0;
+    size_t wildcardCount = 0;
+    for (size_t i = 0; i < _entries.size(); ++i) {
+        if (_entries[i].name.compare(0, 2, "*.") == 0) {
+            ++wildcardCount;
+        } else {
+            ++exactCount;
+        }
+    }
+
+    _exact.assign(tableCapacity(exactCount), Slot());
+    _wildcard.assign(tableCapacity(wildcardCount), Slot());
+
+    for (size_t i = 0; i < _entries.size(); ++i) {
+        const Entry& entry = _entries[i];
+        if (entry.name.compare(0, 2, "*.") == 0) {
+            insert(_wildcard, entry.name.substr(2), entry.server);
+        } else {
+            insert(_exact, entry.name, entry.server);
+        }
+    }
+    Logger::instance().log(DEBUG, "Virtual host table built: " + to_string(exactCount) + " exact, "
+        + to_string(wildcardCount) + " wildcard names");
+}
+
+// FNV-1a insensible a la casse, pour resoudre sans copier le header Host
+unsigned long VirtualHostTable::hashName(const char* name, size_t len) {
+    unsigned long hash = 2166136261UL;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= static_cast<unsigned char>(std::tolower(static_cast<unsigned char>(name[i])));
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+void VirtualHostTable::insert(std::vector<Slot>& table, const std::string& key, Server* server) {
+    size_t mask = table.size() - 1;
+    size_t idx = hashName(key.c_str(), key.size()) & mask;
+    while (table[idx].server != NULL) {
+        if (table[idx].key == key) {
+            Logger::instance().log(WARNING, "Conflicting server name \"" + key + "\" on the same listener, ignored");
+            return;
+        }
+        idx = (idx + 1) & mask;
+    }
+    table[idx].key = key;
+    table[idx].server = server;
+}
+
+Server* VirtualHostTable::find(const std::vector<Slot>& table, const char* name, size_t len) {
+    size_t mask = table.size() - 1;
+    size_t idx = hashName(name, len) & mask;
+    while (table[idx].server != NULL) {
+        const std::string& key = table[idx].key;
+        if (key.size() == len) {
+            size_t i = 0;
+            while (i < len && key[i] == std::tolower(static_cast<unsigned char>(name[i]))) {
+                ++i;
+            }
+            if (i == len) {
+                return table[idx].server;
+            }
+        }
+        idx = (idx + 1) & mask;
+    }
+    return NULL;
+}
+
+Server* VirtualHostTable::resolve(const std::string& hostHeader) const {
+    // Retirer le port (":8080", ou apres le ']' d'une adresse IPv6) et un eventuel point final
+    const char* name = hostHeader.c_str();
+    size_t len = hostHeader.size();
+    if (len > 0 && name[0] == '[') {
+        size_t closing = hostHeader.find(']');
+        if (closing != std::string::npos) {
+            len = closing + 1;
+        }
+    } else if (len > 0) {
+        size_t colonPos = hostHeader.rfind(':');
+        if (colonPos != std::string::npos) {
+            len = colonPos;
+        }
+    }
+    if (len > 0 && name[len - 1] == '.') {
+        --len;
+    }
+    if (len == 0) {
+        return _defaultServer;
+    }
+
+    Server* server = find(_exact, name, len);
+    if (server != NULL) {
+        return server;
+    }
+
+    // Wildcards : on essaie chaque suffixe apres un '.', du plus long au plus court
+    for (size_t i = 0; i < len; ++i) {
+        if (name[i] == '.' && i + 1 < len) {
+            server = find(_wildcard, name + i + 1, len - i - 1);
+            if (server != NULL) {
+                return server;
+            }
+        }
+    }
+    return _defaultServer;
+}
+
+Server* VirtualHostTable::getDefaultServer() const {
+    return _defaultServer;
+}
+
+size_t VirtualHostTable::size() const {
+    return _entries.size();
+}
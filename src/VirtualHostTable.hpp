@@ -0,0 +1,53 @@
+// VirtualHostTable.hpp
+#ifndef VIRTUALHOSTTABLE_HPP
+#define VIRTUALHOSTTABLE_HPP
+
+#include <string>
+#include <vector>
+
+class Server;
+
+/*
+ * Table de dispatch Host -> Server pour un listener (address:port).
+ * Construite une seule fois au demarrage : les noms exacts et les
+ * wildcards (`*.example.com`) sont ranges dans deux tables a adressage
+ * ouvert (sondage lineaire), le server marque `default_server` (sinon le
+ * premier du listener) sert de default. La resolution ne fait aucune allocation.
+ */
+class VirtualHostTable {
+public:
+    VirtualHostTable();
+    ~VirtualHostTable();
+
+    void addServer(Server* server, const std::vector<std::string>& serverNames, bool isDefault = false);
+    void build();
+
+    Server* resolve(const std::string& hostHeader) const;
+    Server* getDefaultServer() const;
+    size_t size() const;
+
+private:
+    struct Slot {
+        std::string key;
+        Server* server;
+        Slot() : server(NULL) {}
+    };
+
+    struct Entry {
+        std::string name;
+        Server* server;
+    };
+
+    std::vector<Entry> _entries;
+    std::vector<Slot> _exact;
+    std::vector<Slot> _wildcard;
+    Server* _defaultServer;
+    bool _hasExplicitDefault;
+
+    static unsigned long hashName(const char* name, size_t len);
+    static void insert(std::vector<Slot>& table, const std::string& key, Server* server);
+    static Server* find(const std::vector<Slot>& table, const char* name, size_t len);
+    static size_t tableCapacity(size_t count);
+};
+
+#endif
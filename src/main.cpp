@@ -3,25 +3,54 @@
 #include "ConfigParser.hpp"
 #include "Socket.hpp"
 #include "Server.hpp"
+#include "Listener.hpp"
+#include "ConfigSnapshot.hpp"
+#include "BinaryUpgrade.hpp"
+#include "TimerWheel.hpp"
+#include "ConnectionTable.hpp"
+#include "AllocStats.hpp"
+#include "StatusLine.hpp"
+#include "DiskPool.hpp"
+#include "FsStats.hpp"
+#include "Metrics.hpp"
 #include "Utils.hpp"
 #include <iostream>
 #include "Logger.hpp"
 #include "ServerConfig.hpp"
 #include <poll.h>
 #include <unistd.h>
-#include <sys/time.h>
 #include <ctime>
 #include <signal.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <cstring>
+#include <cerrno>
 #include <map>
 
-// Définition du functoOor
-struct MatchFD {
-    int fd;
-    MatchFD(int f) : fd(f) {}
-    bool operator()(const pollfd& pfd) const {
-        return pfd.fd == fd;
+// Retrait en O(1) : le dernier pollfd prend la place libre, sa connexion est mise a jour
+static void erasePollFd(std::vector<pollfd>& poll_fds, size_t index, ConnectionTable& connections) {
+    size_t last = poll_fds.size() - 1;
+    if (index != last) {
+        poll_fds[index] = poll_fds[last];
+        Connection* moved = connections.get(poll_fds[index].fd);
+        if (moved != NULL) {
+            moved->pollIndex = index;
+        }
     }
-};
+    poll_fds.pop_back();
+}
+
+// Listeners et canal d'upgrade : rares, recherche lineaire
+static void erasePollFdByValue(std::vector<pollfd>& poll_fds, int fd, ConnectionTable& connections) {
+    for (size_t i = 0; i < poll_fds.size(); ++i) {
+        if (poll_fds[i].fd == fd) {
+            erasePollFd(poll_fds, i, connections);
+            return;
+        }
+    }
+}
 
 void initialize_random_generator() {
     std::ifstream urandom("/dev/urandom", std::ios::binary);
@@ -35,10 +64,418 @@ void initialize_random_generator() {
     srand(seed);
 }
 
+// Ouvre les listeners du snapshot qui n'existent pas encore et ferme ceux qu'il ne reference plus.
+// Si `strict`, un echec d'ouverture annule tout (reload refuse) ; les listeners existants sont conserves.
+// Les sockets `inherited` (binary upgrade) sont adoptees au lieu d'etre bindees.
+static bool syncListeners(const ConfigSnapshot& snapshot, std::map<std::string, Listener*>& listeners,
+                          std::map<int, Listener*>& fdToListenerMap, std::vector<pollfd>& poll_fds,
+                          ConnectionTable& connections, bool strict, std::map<std::string, int>* inherited = NULL) {
+    const std::map<std::string, ListenDirective>& listens = snapshot.getListens();
+    std::vector<Listener*> opened;
+
+    for (std::map<std::string, ListenDirective>::const_iterator it = listens.begin(); it != listens.end(); ++it) {
+        if (listeners.find(it->first) != listeners.end()) {
+            continue; // Listener preserve : sa socket et ses clients en attente restent intacts
+        }
+        Listener* listener = new Listener(it->first, it->second);
+        if (inherited != NULL && inherited->find(it->first) != inherited->end()) {
+            listener->adopt((*inherited)[it->first]);
+            inherited->erase(it->first);
+            opened.push_back(listener);
+            continue;
+        }
+        if (!listener->open()) {
+            delete listener;
+            if (strict) {
+                for (size_t i = 0; i < opened.size(); ++i) {
+                    delete opened[i];
+                }
+                return false;
+            }
+            continue;
+        }
+        opened.push_back(listener);
+    }
+
+    for (size_t i = 0; i < opened.size(); ++i) {
+        listeners[opened[i]->getKey()] = opened[i];
+        fdToListenerMap[opened[i]->getFd()] = opened[i];
+
+        pollfd pfd;
+        pfd.fd = opened[i]->getFd();
+        pfd.events = POLLIN;
+        pfd.revents = 0; // Initialize revents to 0
+        poll_fds.push_back(pfd);
+        Logger::instance().log(INFO, "Server launched, listening on: " + opened[i]->getKey());
+    }
+
+    for (std::map<std::string, Listener*>::iterator it = listeners.begin(); it != listeners.end(); /* no increment here */) {
+        if (listens.find(it->first) != listens.end()) {
+            ++it;
+            continue;
+        }
+        int fd = it->second->getFd();
+        Logger::instance().log(INFO, "Listener " + it->first + " no longer configured, closing it");
+        erasePollFdByValue(poll_fds, fd, connections);
+        fdToListenerMap.erase(fd);
+        delete it->second;
+        listeners.erase(it++);
+    }
+    return true;
+}
+
+// Arret gracieux : plus d'accept, les requetes en cours ont jusqu'a `deadline` pour se terminer
+static void startDrain(std::map<std::string, Listener*>& listeners, std::map<int, Listener*>& fdToListenerMap,
+                       std::vector<pollfd>& poll_fds, ConnectionTable& connections,
+                       bool& draining, unsigned long& drainDeadline, unsigned long now) {
+    if (draining) {
+        return;
+    }
+    for (std::map<std::string, Listener*>::iterator it = listeners.begin(); it != listeners.end(); ++it) {
+        erasePollFdByValue(poll_fds, it->second->getFd(), connections);
+        delete it->second;
+    }
+    listeners.clear();
+    fdToListenerMap.clear();
+    draining = true;
+    drainDeadline = now + SHUTDOWN_TIMEOUT_MS;
+    Logger::instance().log(INFO, "Draining: listeners closed, waiting for in-flight requests");
+}
+
+#define WORKER_FD_RESERVE 64 // fds hors connexions client : listeners, pipes CGI, fichiers servis, logs
+
+// worker_connections doit tenir sous RLIMIT_NOFILE : la limite souple est relevee si la dure le permet
+static void ensureFdLimit(int workerConnections) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == -1) {
+        return;
+    }
+    rlim_t needed = static_cast<rlim_t>(workerConnections) + WORKER_FD_RESERVE;
+    if (limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < needed) {
+        rlim_t previous = limit.rlim_cur;
+        limit.rlim_cur = (limit.rlim_max == RLIM_INFINITY || limit.rlim_max >= needed) ? needed : limit.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != previous) {
+            Logger::instance().log(INFO, "Open file limit raised from " + to_string(previous) + " to " + to_string(limit.rlim_cur));
+        }
+        getrlimit(RLIMIT_NOFILE, &limit);
+    }
+    if (limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < needed) {
+        Logger::instance().log(WARNING, "worker_connections " + to_string(workerConnections) + " exceeds the open file limit ("
+            + to_string(limit.rlim_cur) + "): connections beyond it will be refused with 503");
+    }
+}
+
+// Fin d'un ConfigSnapshotJob : bascule du pointeur courant vers le nouveau snapshot. Les connexions
+// en cours gardent leur reference sur l'ancien, qui est libere a la derniere fermeture.
+static void applyReload(ConfigSnapshotJob* job, ConfigSnapshot*& current, std::map<std::string, Listener*>& listeners,
+                        std::map<int, Listener*>& fdToListenerMap, std::vector<pollfd>& poll_fds,
+                        ConnectionTable& connections, bool draining) {
+    job->replayLogs();
+    ConfigSnapshot* next = job->takeSnapshot();
+    std::string error = job->getError();
+    delete job;
+    if (next == NULL) {
+        Logger::instance().log(ERROR, "Reload aborted, keeping current configuration: " + error);
+        return;
+    }
+    if (draining) {
+        Logger::instance().log(INFO, "Reload finished while draining, snapshot #" + to_string(next->getGeneration()) + " discarded");
+        next->release();
+        return;
+    }
+    if (!syncListeners(*next, listeners, fdToListenerMap, poll_fds, connections, true)) {
+        Logger::instance().log(ERROR, "Reload aborted: unable to open new listeners, keeping current configuration");
+        next->release();
+        return;
+    }
+    ConfigSnapshot* previous = current;
+    current = next;
+    previous->release();
+    ensureFdLimit(current->getWorkerConnections());
+    Logger::instance().log(INFO, "Configuration reloaded, now serving snapshot #" + to_string(current->getGeneration()));
+}
+
+// SIGHUP : le snapshot est construit sur le DiskPool (parsing, types_file, pages d'erreur, getaddrinfo),
+// la boucle continue de servir sur le courant. NULL si le reload a du etre fait sur place (file du pool pleine).
+static ConfigSnapshotJob* startReload(ConfigSnapshot*& current, std::map<std::string, Listener*>& listeners,
+                                      std::map<int, Listener*>& fdToListenerMap, std::vector<pollfd>& poll_fds,
+                                      ConnectionTable& connections) {
+    Logger::instance().log(INFO, "SIGHUP received, reloading " + current->getConfigFile());
+    ConfigSnapshotJob* job = new ConfigSnapshotJob(current->getConfigFile());
+    if (DiskPool::instance().submit(job)) {
+        return job;
+    }
+    Logger::instance().log(WARNING, "Disk pool queue full, reloading on the event loop");
+    job->run();
+    applyReload(job, current, listeners, fdToListenerMap, poll_fds, connections, false);
+    return NULL;
+}
+
+// Libere l'etat d'une connexion client et rend son slot
+static void releaseClient(Connection* conn, ConnectionTable& connections, TimerWheel& wheel, std::vector<pollfd>& poll_fds) {
+    close(conn->fd);
+    wheel.disarm(conn->timer);
+    if (conn->snapshot != NULL) {
+        conn->snapshot->release();
+    }
+    erasePollFd(poll_fds, conn->pollIndex, connections);
+    connections.release(conn);
+}
+
+enum ClientState {
+    CLIENT_WAITING,   // Attend des octets du client
+    CLIENT_WRITING,   // Reponse en cours d'envoi, reprise sur POLLOUT
+    CLIENT_PIPELINED, // Requete suivante deja dans le buffer
+    CLIENT_CLOSE
+};
+
+// Suite d'une requete une fois sa reponse entierement partie
+static ClientState finishRequest(Connection* conn, TimerWheel& wheel, unsigned long activity) {
+    HTTPRequest* request = &conn->request;
+    Server* server = conn->server;
+    if (!request->isComplete()) {
+        if (request->getRequestTooLarge()) {
+            return CLIENT_CLOSE;
+        }
+        wheel.arm(conn->timer, TIMER_BODY, activity + server->getConfig().clientBodyTimeout);
+        return CLIENT_WAITING;
+    }
+    if (!request->getKeepAlive()) {
+        return CLIENT_CLOSE;
+    }
+
+    // Keep-alive : nouvelle requete dans le meme slot, les octets deja recus sont conserves
+    std::string pipelined = request->getPipelinedData();
+    request->reset();
+    request->setLastActivity(activity);
+    request->_rawRequest = pipelined;
+    conn->trace.next();
+    if (!pipelined.empty()) {
+        conn->trace.mark(TRACE_FIRST_BYTE);
+    }
+    conn->server = NULL;
+    wheel.arm(conn->timer, TIMER_KEEPALIVE, activity + server->getConfig().keepaliveTimeout);
+    return pipelined.empty() ? CLIENT_WAITING : CLIENT_PIPELINED;
+}
+
+// Requete entierement servie : phases par location, access log, chronologie echantillonnee
+static void requestDone(Connection* conn) {
+    const ResponseWriter::Sent& sent = conn->output.sent();
+    RequestTrace& trace = conn->trace;
+    trace.at[TRACE_HANDLER_END] = sent.queuedAt;
+    trace.at[TRACE_SEND_START] = sent.firstByteAt;
+    trace.at[TRACE_SEND_END] = sent.lastByteAt;
+    if (trace.has(PHASE_TOTAL)) {
+        Metrics::requestDuration(trace.phase(PHASE_TOTAL));
+    }
+
+    const HTTPRequest& request = conn->request;
+    const ServerConfig& config = conn->server->getConfig();
+    const Location* location = config.findLocation(request.getPath());
+    Metrics::requestTraced(config.serverNames.empty() ? "_" : config.serverNames[0], location ? location->path : "", trace);
+
+    std::string line;
+    trace.accessLine(line, conn->peer, request, sent.status, sent.bytes);
+    Logger::instance().access(line);
+
+    // Compteur commun aux servers qui tracent : une requete sur traceSample de chacun, a peu pres
+    static unsigned long traced = 0;
+    if (config.traceSample > 0 && ++traced % config.traceSample == 0) {
+        std::string timeline;
+        trace.timeline(timeline);
+        Logger::instance().log(INFO, "Trace " + request.getMethod() + " " + request.getPath() + " (" + to_string(sent.status)
+            + ", " + to_string(sent.bytes) + " bytes) on client FD " + to_string(conn->fd) + ": " + timeline);
+    }
+}
+
+// Etat de la connexion une fois la reponse produite par le server
+static ClientState afterResponse(Connection* conn, TimerWheel& wheel, std::vector<pollfd>& poll_fds, unsigned long activity) {
+    Server* server = conn->server;
+    if (conn->output.pending()) {
+        // Socket pleine : plus de lecture tant que la reponse n'est pas partie
+        wheel.arm(conn->timer, TIMER_SEND, activity + server->getConfig().sendTimeout);
+        poll_fds[conn->pollIndex].events = POLLOUT | POLLHUP | POLLERR;
+        return CLIENT_WRITING;
+    }
+    if (conn->output.deferred()) {
+        // Reponse attendue du DiskPool : ni lecture ni ecriture, send_timeout borne l'attente
+        wheel.arm(conn->timer, TIMER_SEND, activity + server->getConfig().sendTimeout);
+        poll_fds[conn->pollIndex].events = 0;
+        return CLIENT_WRITING;
+    }
+    poll_fds[conn->pollIndex].events = POLLIN | POLLHUP | POLLERR;
+    if (conn->request.isComplete()) {
+        requestDone(conn);
+    }
+    return finishRequest(conn, wheel, activity);
+}
+
+// Sert les requetes presentes dans le buffer ; plusieurs tours seulement si des requetes
+// pipelinees sont deja recues. S'arrete sur une reponse que la socket n'a pas tout acceptee.
+static ClientState processRequests(Connection* conn, TimerWheel& wheel, std::vector<pollfd>& poll_fds,
+                                   bool draining, unsigned long activity, unsigned long& allocStart) {
+    HTTPRequest* request = &conn->request;
+    ClientState state = CLIENT_WAITING;
+    while (!request->getConnectionClosed()) {
+        if (conn->server == NULL) {
+            Server* defaultServer = conn->snapshot->getDefaultServer(conn->listenKey);
+            const ServerConfig& config = defaultServer->getConfig();
+            if (conn->timer.phase == TIMER_KEEPALIVE) {
+                // Debut de la requete suivante : le delai des headers repart
+                wheel.arm(conn->timer, TIMER_HEADER, activity + config.clientHeaderTimeout);
+            }
+            int headerStatus = request->checkHeaderLimits(config.largeClientHeaderBufferSize,
+                static_cast<size_t>(config.largeClientHeaderBuffers) * config.largeClientHeaderBufferSize);
+            if (headerStatus != 0) {
+                Logger::instance().log(WARNING, "Request headers too large on client FD: " + to_string(conn->fd));
+                defaultServer->sendErrorResponse(conn->fd, headerStatus);
+                return CLIENT_CLOSE;
+            }
+            // Une seule resolution Host -> server par requete
+            conn->server = conn->snapshot->route(conn->listenKey, *request);
+            if (conn->server != NULL) {
+                conn->trace.mark(TRACE_HEADERS);
+            }
+        }
+        Server* server = conn->server;
+        if (server == NULL) {
+            return CLIENT_WAITING; // Headers incomplets, le timer HEADER n'est pas prolonge
+        }
+
+        if (draining) {
+            request->setKeepAlive(false);
+        }
+        Logger::instance().log(INFO, "Begin to handle request for client FD: " + to_string(conn->fd));
+        conn->trace.at[TRACE_HANDLER_START] = FsStats::nowNs(); // Le dernier passage, qui complete la requete, reste
+        server->handleClient(conn->fd, request, conn->output);
+
+        if (request->isComplete()) {
+            // Requete terminee : allocations faites pour elle depuis sa premiere lecture
+            unsigned long allocations = conn->requestAllocations + (AllocStats::allocations() - allocStart);
+            AllocStats::recordRequest(allocations);
+            Logger::instance().log(DEBUG, "Request served on client FD " + to_string(conn->fd) + " with " + to_string(allocations) + " allocations");
+            conn->requestAllocations = 0;
+            allocStart = AllocStats::allocations();
+        }
+
+        state = afterResponse(conn, wheel, poll_fds, activity);
+        if (state != CLIENT_PIPELINED) {
+            return state;
+        }
+    }
+    return state;
+}
+
+// Horloge monotone des delais et timers : un reglage de l'heure systeme ne declenche ni ne retient aucun timeout
 unsigned long curr_time_ms() {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return static_cast<unsigned long>(tv.tv_sec) * 1000 + tv.tv_usec / 1000;
+    return FsStats::nowNs() / 1000000;
+}
+
+#define ACCEPT_BATCH 64      // Connexions acceptees par listener et par tour de boucle
+#define ACCEPT_PAUSE_MS 100  // Listeners hors de poll() quand plus aucun fd ne peut etre libere
+
+// Reserve pour EMFILE : fermee le temps d'accepter et de refuser la connexion en tete de file,
+// sinon le listener resterait lisible et poll() tournerait a vide
+static int openSpareFd() {
+    return open("/dev/null", O_RDONLY | O_CLOEXEC);
+}
+
+// Listeners retires de poll() (events a 0) pendant une pause, remis ensuite
+static void pollListeners(std::vector<pollfd>& poll_fds, const std::map<int, Listener*>& fdToListenerMap, bool enabled) {
+    for (size_t i = 0; i < poll_fds.size(); ++i) {
+        if (fdToListenerMap.find(poll_fds[i].fd) != fdToListenerMap.end()) {
+            poll_fds[i].events = enabled ? POLLIN : 0;
+        }
+    }
+}
+
+// Refus immediat : la requete deja recue est lue (sinon close() enverrait un RST qui peut
+// effacer la reponse cote client), puis 503 et fermeture
+static void rejectClient(Server* server, int client_fd, MetricsReject reason) {
+    char discard[4096];
+    while (recv(client_fd, discard, sizeof(discard), 0) > 0) {
+    }
+    Metrics::connectionRejected(reason);
+    server->sendOverloaded(client_fd);
+    close(client_fd);
+}
+
+static void registerClient(int client_fd, std::string& peer, Listener* listener, Server* defaultServer, ConfigSnapshot* snapshot,
+                           ConnectionTable& connections, TimerWheel& wheel, std::vector<pollfd>& poll_fds) {
+    Connection* client = connections.acquire(client_fd);
+    Metrics::connectionAccepted();
+    client->trace.mark(TRACE_ACCEPT);
+    client->peer.swap(peer);
+    client->listenKey = listener->getKey(); // Register the client_fd -> listener association
+    client->server = NULL; // Virtual host choisi a la reception du Host
+    snapshot->retain();
+    client->snapshot = snapshot;
+    client->request.setLastActivity(curr_time_ms());
+
+    // Avant le Host, delais et buffers de headers sont ceux du server par defaut du listener
+    const ServerConfig& config = defaultServer->getConfig();
+    client->request._rawRequest.reserve(config.clientHeaderBufferSize);
+    wheel.arm(client->timer, TIMER_HEADER, client->request.getLastActivity() + config.clientHeaderTimeout);
+
+    pollfd client_pollfd;
+    client_pollfd.fd = client_fd;
+    client_pollfd.events = POLLIN | POLLHUP | POLLERR;
+    client_pollfd.revents = 0;
+    client->pollIndex = poll_fds.size();
+    poll_fds.push_back(client_pollfd);
+}
+
+// Accepte jusqu'a EAGAIN, au plus ACCEPT_BATCH connexions : les clients deja connectes et les autres
+// listeners passent avant le reste de la file. Au-dela de worker_connections, ou sans fd libre, la
+// connexion recoit un 503 tout de suite au lieu d'attendre en file.
+// false si plus rien ne peut etre accepte, pas meme avec le fd de reserve : les listeners doivent faire une pause.
+static bool acceptClients(int listenFd, Listener* listener, ConfigSnapshot* snapshot, ConnectionTable& connections,
+                          TimerWheel& wheel, std::vector<pollfd>& poll_fds, int& spareFd) {
+    Server* defaultServer = snapshot->getDefaultServer(listener->getKey());
+    size_t limit = static_cast<size_t>(snapshot->getWorkerConnections());
+    size_t rejected = 0;
+    bool paused = false;
+    for (int batch = 0; batch < ACCEPT_BATCH; ++batch) {
+        std::string peer;
+        int client_fd = defaultServer->acceptNewClient(listenFd, peer);
+        if (client_fd == -1) {
+            if (errno == EINTR || errno == ECONNABORTED || errno == EPROTO) {
+                continue; // Client parti avant l'accept
+            }
+            if (errno == EMFILE || errno == ENFILE) {
+                if (spareFd == -1) {
+                    paused = true;
+                    break;
+                }
+                close(spareFd);
+                int shed = defaultServer->acceptNewClient(listenFd, peer);
+                if (shed != -1) {
+                    rejectClient(defaultServer, shed, REJECT_NOFILE);
+                    ++rejected;
+                }
+                spareFd = openSpareFd();
+                if (shed == -1) {
+                    break;
+                }
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                Logger::instance().log(ERROR, std::string("Error while accepting connection on FD ") + to_string(listenFd) + ": " + strerror(errno));
+            }
+            break;
+        }
+        if (connections.size() >= limit) {
+            rejectClient(defaultServer, client_fd, REJECT_LIMIT);
+            ++rejected;
+            continue;
+        }
+        registerClient(client_fd, peer, listener, defaultServer, snapshot, connections, wheel, poll_fds);
+    }
+    if (rejected > 0) {
+        Logger::instance().log(WARNING, "Overloaded: " + to_string(rejected) + " connection(s) on " + listener->getKey()
+            + " refused with 503 (" + to_string(connections.size()) + " open, worker_connections " + to_string(limit) + ")");
+    }
+    return !paused;
 }
 
 int main(int argc, char* argv[]) {
@@ -61,17 +498,17 @@ int main(int argc, char* argv[]) {
 
     initialize_random_generator();
 
-    ConfigParser configParser;
+    ConfigSnapshot* snapshot = NULL;
     try {
-        configParser.parseConfigFile(configFile);
+        snapshot = ConfigSnapshot::load(configFile);
         Logger::instance().log(DEBUG, "Config file successfully parsed");
     } catch (const ConfigParserException& e) {
         Logger::instance().log(ERROR, std::string("Failure in configuration parsing: ") + e.what());
         return 1;
     }
 
-    const std::vector<ServerConfig>& serverConfigs = configParser.getServerConfigs();
-    Logger::instance().log(INFO, to_string(serverConfigs.size()) + " servers successfully configured");
+    Logger::instance().log(INFO, to_string(snapshot->getServerConfigs().size()) + " servers successfully configured");
+    ensureFdLimit(snapshot->getWorkerConnections());
 
     if (pipe(serverSignal::pipe_fd) == -1) {
         perror("pipe");
@@ -83,14 +520,20 @@ int main(int argc, char* argv[]) {
     sa.sa_handler = serverSignal::signal_handler;
     sigemptyset(&sa.sa_mask);
     sa.sa_flags = 0;
-    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGINT, &sa, NULL);  // Arret immediat
+    sigaction(SIGHUP, &sa, NULL);  // Reload de la configuration
+    sigaction(SIGTERM, &sa, NULL); // Arret gracieux (drain)
+    sigaction(SIGQUIT, &sa, NULL); // Arret gracieux (drain)
+    sigaction(SIGUSR2, &sa, NULL); // Binary upgrade
+    // Client parti en cours d'envoi : EPIPE sur l'ecriture plutot qu'un arret du serveur
+    signal(SIGPIPE, SIG_IGN);
 
-    std::vector<Server*> servers;
-    std::vector<Socket*> sockets;
     std::vector<pollfd> poll_fds;
-    std::map<int, Server*> fdToServerMap;
-    std::map<int, Server*> clientFdToServerMap;
-    std::map<int, HTTPRequest*> clientFdToRequestMap; // Map to keep track of HTTPRequest objects
+    std::map<std::string, Listener*> listeners;
+    std::map<int, Listener*> fdToListenerMap;
+    ConnectionTable connections; // Etat de chaque client, indexe par fd
+    Metrics::watch(&connections);
+    TimerWheel wheel(curr_time_ms());
     
 
     {
@@ -101,75 +544,102 @@ int main(int argc, char* argv[]) {
         poll_fds.push_back(pfd);
     }
 
-    // Create servers and sockets
-    for (size_t i = 0; i < serverConfigs.size(); ++i) {
-        Server* server = new Server(serverConfigs[i]);
-        Socket* socket = new Socket(serverConfigs[i].ports[0]);
-        socket->build_sockets();
-
+    // Ecritures disque (uploads) hors de la boucle ; leurs fins sont signalees par un eventfd
+    DiskPool& diskPool = DiskPool::instance();
+    diskPool.start(DISK_POOL_THREADS);
+    if (diskPool.notifyFd() != -1) {
         pollfd pfd;
-        pfd.fd = socket->getSocket();
+        pfd.fd = diskPool.notifyFd();
         pfd.events = POLLIN;
-        pfd.revents = 0; // Initialize revents to 0
+        pfd.revents = 0;
         poll_fds.push_back(pfd);
+    }
 
-        // Associate server sockets with servers
-        fdToServerMap[socket->getSocket()] = server;
-
-        servers.push_back(server);
-        sockets.push_back(socket);
-
-        Logger::instance().log(INFO, "Server launched, listening on port: " + to_string(serverConfigs[i].ports[0]));
+    // One listener per distinct address:port, reprises de l'ancien processus en cas d'upgrade
+    std::map<std::string, int> inherited = BinaryUpgrade::receiveListeners();
+    syncListeners(*snapshot, listeners, fdToListenerMap, poll_fds, connections, false, &inherited);
+    for (std::map<std::string, int>::iterator it = inherited.begin(); it != inherited.end(); ++it) {
+        Logger::instance().log(INFO, "Inherited listener " + it->first + " no longer configured, closing it");
+        close(it->second);
     }
+    BinaryUpgrade::acknowledge();
+
+    bool draining = false;
+    bool idleClosed = false;
+    unsigned long drainDeadline = 0;
+    int upgradeChannel = -1;
+    pid_t upgradePid = -1;
+    int spareFd = openSpareFd();
+    unsigned long acceptResumeAt = 0; // Fin de la pause des listeners, 0 si aucune
+    ConfigSnapshotJob* reloadJob = NULL; // Reload en cours sur le DiskPool
+    bool reloadAgain = false;            // SIGHUP recu pendant ce reload : relire le fichier a sa fin
 
     while (!stopServer) {
         unsigned long now = curr_time_ms();
-        std::vector<int> timed_out_fds;
-        unsigned long min_remaining_time = TIMEOUT_MS;
-        bool has_active_connections = false;
-
-        // Timeout checks
-        std::map<int, HTTPRequest*>::iterator it;
-        for (it = clientFdToRequestMap.begin(); it != clientFdToRequestMap.end(); /* no increment here */) {
-            int client_fd = it->first;
-            HTTPRequest& request = *(it->second);
-
-            unsigned long time_since_last_activity = now - request.getLastActivity();
-
-            if (time_since_last_activity >= TIMEOUT_MS) {
-                // Connection has timed out
-                Logger::instance().log(INFO, "Connection timed out for client FD: " + to_string(client_fd));
-                //?? sendError avant de close (408)
-                // Close the connection and clean up
-                Server *server = clientFdToServerMap[client_fd];
-                server->sendErrorResponse(client_fd, 408);
-                close(client_fd);
-                clientFdToServerMap.erase(client_fd);
-                poll_fds.erase(
-                    std::remove_if(poll_fds.begin(), poll_fds.end(), MatchFD(client_fd)),
-                    poll_fds.end()
-                );
-                clientFdToRequestMap.erase(it++);
+
+        if (draining) {
+            // Une seule fois : les connexions keep-alive inactives n'ont plus de requete a terminer
+            for (size_t s = 0; !idleClosed && s < connections.capacity(); ++s) {
+                Connection* conn = connections.slot(s);
+                if (conn->inUse && conn->timer.phase == TIMER_KEEPALIVE && wheel.isArmed(conn->timer)) {
+                    releaseClient(conn, connections, wheel, poll_fds);
+                }
+            }
+            idleClosed = true;
+            if (connections.size() == 0) {
+                Logger::instance().log(INFO, "Drain complete, stopping the server...");
+                break;
+            }
+            if (now >= drainDeadline) {
+                Logger::instance().log(WARNING, "Drain deadline reached, closing " + to_string(connections.size()) + " remaining connections");
+                break;
+            }
+        }
+
+        if (acceptResumeAt != 0 && now >= acceptResumeAt) {
+            if (spareFd == -1) {
+                spareFd = openSpareFd();
+            }
+            pollListeners(poll_fds, fdToListenerMap, true);
+            acceptResumeAt = 0;
+        }
+
+        // Timeout checks : seuls les timers echus sont visites
+        std::vector<TimerNode*> expired;
+        wheel.advance(now, expired);
+        for (size_t e = 0; e < expired.size(); ++e) {
+            Connection* conn = connections.get(expired[e]->fd);
+            if (conn == NULL) {
+                continue;
+            }
+            if (expired[e]->phase == TIMER_KEEPALIVE) {
+                Logger::instance().log(DEBUG, "Keep-alive timeout, closing idle client FD: " + to_string(conn->fd));
+            } else if (expired[e]->phase == TIMER_SEND) {
+                // Reponse deja commencee : pas de 408, on coupe
+                Logger::instance().log(INFO, "Send timeout, closing client FD: " + to_string(conn->fd));
             } else {
-                unsigned long remaining_time = TIMEOUT_MS - time_since_last_activity;
-                if (remaining_time < min_remaining_time) {
-                    min_remaining_time = remaining_time;
+                Logger::instance().log(INFO, "Connection timed out for client FD: " + to_string(conn->fd));
+                Server *server = conn->server;
+                if (server == NULL) {
+                    server = conn->snapshot->getDefaultServer(conn->listenKey);
                 }
-                has_active_connections = true;
-                ++it;
+                server->sendErrorResponse(conn->fd, 408);
             }
+            releaseClient(conn, connections, wheel, poll_fds);
         }
 
         // Call poll()
-        int poll_timeout;
-        if (has_active_connections) {
-            poll_timeout = static_cast<int>(min_remaining_time);
-        } else {
-            poll_timeout = -1; // Bloquer indéfiniment si aucune connexion active
+        // On attend au plus jusqu'a la prochaine echeance de la roue (ou du drain), -1 si aucune
+        int poll_timeout = wheel.nextTimeout(now);
+        if (draining && (poll_timeout == -1 || static_cast<unsigned long>(poll_timeout) > drainDeadline - now)) {
+            poll_timeout = static_cast<int>(drainDeadline - now);
+        }
+        if (acceptResumeAt != 0 && (poll_timeout == -1 || static_cast<unsigned long>(poll_timeout) > acceptResumeAt - now)) {
+            poll_timeout = static_cast<int>(acceptResumeAt - now);
         }
+        // Uploads prepares pendant ce tour : un seul io_uring_enter
+        diskPool.flush();
         int poll_count = poll(&poll_fds[0], poll_fds.size(), poll_timeout); 
-        // Ici on attend le temps le plus court avant expiration d'une des requetes. Si une requête timeout dans 500ms, on dit a poll d'attendre au maximum 500ms
-        // Comme ca on sort du poll, on coupe la connexion avec le client expiré et on peut relancer une boucle poll avec le nouveau temps le plus court avant time out d'une requete 
         if (poll_count < 0) {
             if (errno == EINTR) {
                 // poll() was interrupted by a signal, continue the loop
@@ -179,6 +649,8 @@ int main(int argc, char* argv[]) {
                 break; // Or handle the error appropriately
             }
         }
+        // Date des reponses de ce tour, reformatee au plus une fois par seconde
+        DateCache::refresh(static_cast<unsigned long>(time(NULL)) * 1000);
 
         for (size_t i = 0; i < poll_fds.size(); ++i) {
             if (poll_fds[i].revents == 0)
@@ -189,6 +661,35 @@ int main(int argc, char* argv[]) {
                     // Read the byte(s) from the pipe to clear the buffer
                     uint8_t byte;
                     ssize_t bytesRead = read(serverSignal::pipe_fd[0], &byte, sizeof(byte));
+                    if (bytesRead > 0 && byte == SIGHUP && !draining) {
+                        if (reloadJob != NULL) {
+                            Logger::instance().log(INFO, "SIGHUP received during a reload, reloading again once it finishes");
+                            reloadAgain = true;
+                            continue;
+                        }
+                        // Repli sur place : les listeners ont pu changer, on repart sur un nouveau poll()
+                        reloadJob = startReload(snapshot, listeners, fdToListenerMap, poll_fds, connections);
+                        break;
+                    }
+                    if (bytesRead > 0 && (byte == SIGTERM || byte == SIGQUIT)) {
+                        Logger::instance().log(INFO, "Signal received, draining the server...");
+                        startDrain(listeners, fdToListenerMap, poll_fds, connections, draining, drainDeadline, curr_time_ms());
+                        break;
+                    }
+                    if (bytesRead > 0 && byte == SIGUSR2) {
+                        if (upgradeChannel == -1 && !draining) {
+                            Logger::instance().log(INFO, "SIGUSR2 received, starting binary upgrade");
+                            upgradeChannel = BinaryUpgrade::start(argv, listeners, upgradePid);
+                            if (upgradeChannel != -1) {
+                                pollfd pfd;
+                                pfd.fd = upgradeChannel;
+                                pfd.events = POLLIN;
+                                pfd.revents = 0;
+                                poll_fds.push_back(pfd);
+                            }
+                        }
+                        break;
+                    }
                     if (bytesRead > 0) {
                         // You can set a variable to properly stop the server
                         Logger::instance().log(INFO, "Signal received, stopping the server...");
@@ -199,32 +700,90 @@ int main(int argc, char* argv[]) {
                 continue;
             }
 
+            if (poll_fds[i].fd == upgradeChannel) {
+                // Le nouveau processus a adopte les listeners (ou a echoue)
+                erasePollFd(poll_fds, i, connections);
+                if (BinaryUpgrade::readAcknowledge(upgradeChannel)) {
+                    Logger::instance().log(INFO, "Binary upgrade acknowledged by PID " + to_string(upgradePid) + ", draining the old process");
+                    startDrain(listeners, fdToListenerMap, poll_fds, connections, draining, drainDeadline, curr_time_ms());
+                } else {
+                    Logger::instance().log(ERROR, "Binary upgrade failed, PID " + to_string(upgradePid) + " did not take over; still serving");
+                    waitpid(upgradePid, NULL, WNOHANG);
+                }
+                upgradeChannel = -1;
+                break;
+            }
+
+            if (poll_fds[i].fd == diskPool.notifyFd()) {
+                // Jobs termines : la reponse part sur la connexion qui l'attend encore
+                std::vector<DiskJob*> finished;
+                diskPool.collect(finished);
+                unsigned long activity = curr_time_ms();
+                bool reloaded = false;
+                for (size_t j = 0; j < finished.size(); ++j) {
+                    DiskJob* job = finished[j];
+                    if (job == reloadJob) {
+                        reloaded = true; // Bascule apres les reponses, qui utilisent encore les index de poll_fds
+                        continue;
+                    }
+                    Connection* conn = connections.get(job->clientFd());
+                    if (conn == NULL || conn->server == NULL || !conn->output.awaiting(job->ticket())) {
+                        if (job->clientFd() != -1) {
+                            Logger::instance().log(DEBUG, "Disk job finished for a closed connection, FD: " + to_string(job->clientFd()));
+                        } else {
+                            job->finishDetached(); // Job sans reponse (session)
+                        }
+                        delete job;
+                        continue;
+                    }
+                    job->finish(*conn->server, conn->fd, conn->request, conn->output);
+                    delete job;
+                    unsigned long allocStart = AllocStats::allocations();
+                    ClientState state = afterResponse(conn, wheel, poll_fds, activity);
+                    if (state == CLIENT_PIPELINED) {
+                        state = processRequests(conn, wheel, poll_fds, draining, activity, allocStart);
+                    }
+                    conn->requestAllocations += AllocStats::allocations() - allocStart;
+                    if (state == CLIENT_CLOSE || conn->request.getConnectionClosed()) {
+                        releaseClient(conn, connections, wheel, poll_fds);
+                    }
+                }
+                if (reloaded) {
+                    ConfigSnapshotJob* job = reloadJob;
+                    reloadJob = NULL;
+                    applyReload(job, snapshot, listeners, fdToListenerMap, poll_fds, connections, draining);
+                    if (reloadAgain && !draining) {
+                        reloadAgain = false;
+                        reloadJob = startReload(snapshot, listeners, fdToListenerMap, poll_fds, connections);
+                    }
+                }
+                // Des pollfds ont pu etre deplaces : on repart sur un nouveau poll()
+                break;
+            }
+
+            // Un seul acces indexe par evenement ; NULL pour les sockets d'ecoute
+            Connection* conn = connections.get(poll_fds[i].fd);
+
             // Handle errors
             if (poll_fds[i].revents & POLLERR) {
                 Logger::instance().log(ERROR, "Error on file descriptor: " + to_string(poll_fds[i].fd));
-                if (fdToServerMap.find(poll_fds[i].fd) != fdToServerMap.end()) {
+                if (conn == NULL) {
                     // It's a server socket
                     Logger::instance().log(ERROR, "Error on server socket detected in poll");
                     // Decide how to handle server socket errors
                 } else {
                     // It's a client socket
                     Logger::instance().log(ERROR, "Error on client socket detected in poll");
-                    close(poll_fds[i].fd);
-                    clientFdToServerMap.erase(poll_fds[i].fd);
-                    clientFdToRequestMap.erase(poll_fds[i].fd);
-                    poll_fds.erase(poll_fds.begin() + i);
+                    releaseClient(conn, connections, wheel, poll_fds);
                     --i;
                 }
                 continue;
             }
 
             // Handle disconnections
-            if (poll_fds[i].revents & POLLHUP) {
+            if ((poll_fds[i].revents & POLLHUP) && conn != NULL) {
                 Logger::instance().log(INFO, "Disconnected client FD: " + to_string(poll_fds[i].fd));
-                close(poll_fds[i].fd);
-                clientFdToServerMap.erase(poll_fds[i].fd);
-                clientFdToRequestMap.erase(poll_fds[i].fd);
-                poll_fds.erase(poll_fds.begin() + i);
+                releaseClient(conn, connections, wheel, poll_fds);
                 --i;
                 continue;
             }
@@ -232,55 +791,62 @@ int main(int argc, char* argv[]) {
             if (poll_fds[i].revents & POLLNVAL) {
                 Logger::instance().log(ERROR, "File descriptor not valid: " + to_string(poll_fds[i].fd));
                 // Remove the invalid descriptor
-                poll_fds.erase(poll_fds.begin() + i);
+                erasePollFd(poll_fds, i, connections);
                 --i;
                 continue;
             }
 
-            if (poll_fds[i].revents & POLLIN) {
-                if (fdToServerMap.find(poll_fds[i].fd) != fdToServerMap.end()) {
-                    // It's a server socket descriptor, accept a new connection
-                    Server* server = fdToServerMap[poll_fds[i].fd];
-                    int client_fd = server->acceptNewClient(poll_fds[i].fd);
-
-                    if (client_fd != -1) {
-                        clientFdToServerMap[client_fd] = server; // Register the client_fd -> server association
-
-                        // Create a new HTTPRequest object and store it in the map
-                        int max_body_size = serverConfigs[0].clientMaxBodySize;
-                        HTTPRequest* request = new HTTPRequest(max_body_size);
-                        request->setLastActivity(curr_time_ms());
-                        clientFdToRequestMap[client_fd] = request;
-
-                        pollfd client_pollfd;
-                        client_pollfd.fd = client_fd;
-                        client_pollfd.events = POLLIN | POLLHUP | POLLERR;
-                        client_pollfd.revents = 0;
-                        poll_fds.push_back(client_pollfd);
-                        Logger::instance().log(DEBUG, "New pollfd added for client with FD: " + to_string(client_fd) + " accepted on server FD: " + to_string(poll_fds[i].fd));
-                    } else {
-                        Logger::instance().log(ERROR, "Failure accepting client on server FD: " + to_string(poll_fds[i].fd));
+            if ((poll_fds[i].revents & POLLOUT) && conn != NULL) {
+                // Reprise d'une reponse que la socket n'avait pas entierement acceptee
+                unsigned long activity = curr_time_ms();
+                unsigned long allocStart = AllocStats::allocations();
+                ClientState state = CLIENT_CLOSE;
+                ResponseWriter::Status status = conn->output.flush(conn->fd);
+                if (status == ResponseWriter::WRITE_AGAIN) {
+                    // Le client lit toujours : send_timeout borne l'intervalle entre deux envois
+                    wheel.arm(conn->timer, TIMER_SEND, activity + conn->server->getConfig().sendTimeout);
+                    continue;
+                }
+                if (status == ResponseWriter::WRITE_DONE) {
+                    state = afterResponse(conn, wheel, poll_fds, activity);
+                    if (state == CLIENT_PIPELINED) {
+                        state = processRequests(conn, wheel, poll_fds, draining, activity, allocStart);
                     }
                 } else {
-                    // It's a client socket descriptor, handle the request
-                    Server* server = clientFdToServerMap[poll_fds[i].fd];
-                    HTTPRequest* request = clientFdToRequestMap[poll_fds[i].fd];
-                    request->setLastActivity(curr_time_ms());
+                    Logger::instance().log(WARNING, std::string("Failed to send response to client FD ") + to_string(conn->fd) + ": " + strerror(errno));
+                }
+                conn->requestAllocations += AllocStats::allocations() - allocStart;
+                if (state == CLIENT_CLOSE || conn->request.getConnectionClosed()) {
+                    releaseClient(conn, connections, wheel, poll_fds);
+                    --i;
+                }
+                continue;
+            }
 
-                    if (server != NULL && request != NULL) {
-                        Logger::instance().log(INFO, "Begin to handle request for client FD: " + to_string(poll_fds[i].fd));
-                        server->handleClient(poll_fds[i].fd, request);
+            if (poll_fds[i].revents & POLLIN) {
+                if (conn == NULL && fdToListenerMap.find(poll_fds[i].fd) != fdToListenerMap.end()) {
+                    // It's a server socket descriptor, accept new connections
+                    if (!acceptClients(poll_fds[i].fd, fdToListenerMap[poll_fds[i].fd], snapshot, connections, wheel, poll_fds, spareFd)) {
+                        Logger::instance().log(WARNING, "Out of file descriptors, not accepting for " + to_string(ACCEPT_PAUSE_MS) + " ms");
+                        pollListeners(poll_fds, fdToListenerMap, false);
+                        acceptResumeAt = curr_time_ms() + ACCEPT_PAUSE_MS;
                     }
+                } else if (conn != NULL) {
+                    // It's a client socket descriptor, handle the request
+                    HTTPRequest* request = &conn->request;
+                    unsigned long activity = curr_time_ms();
+                    request->setLastActivity(activity);
+
+                    unsigned long allocStart = AllocStats::allocations();
+                    conn->trace.mark(TRACE_FIRST_BYTE);
+                    readFromSocket(conn->fd, *request);
+                    ClientState state = processRequests(conn, wheel, poll_fds, draining, activity, allocStart);
+                    conn->requestAllocations += AllocStats::allocations() - allocStart;
 
                     // Check if the request is complete or connection is closed
-                    if (request->isComplete() || request->getConnectionClosed() || request->getRequestTooLarge()) {
+                    if (state == CLIENT_CLOSE || request->getConnectionClosed()) {
                         // Clean up
-                        delete request;
-                        clientFdToRequestMap.erase(poll_fds[i].fd);
-
-                        close(poll_fds[i].fd);
-                        clientFdToServerMap.erase(poll_fds[i].fd);
-                        poll_fds.erase(poll_fds.begin() + i);
+                        releaseClient(conn, connections, wheel, poll_fds);
                         --i;
                     }
                 }
@@ -291,17 +857,28 @@ int main(int argc, char* argv[]) {
             break;
     }
 
-    // Clean up any remaining HTTPRequest objects
-    for (std::map<int, HTTPRequest*>::iterator it = clientFdToRequestMap.begin(); it != clientFdToRequestMap.end(); ++it) {
-        delete it->second;
+    // Clean up any remaining client connections
+    for (size_t s = 0; s < connections.capacity(); ++s) {
+        Connection* conn = connections.slot(s);
+        if (conn->inUse) {
+            releaseClient(conn, connections, wheel, poll_fds);
+        }
     }
-    clientFdToRequestMap.clear();
 
     // Clean up memory
-    for (size_t i = 0; i < servers.size(); ++i) {
-        delete servers[i];
-        delete sockets[i];
+    for (std::map<std::string, Listener*>::iterator it = listeners.begin(); it != listeners.end(); ++it) {
+        delete it->second;
     }
+    if (spareFd != -1) {
+        close(spareFd);
+    }
+    snapshot->release();
+    diskPool.stop(); // Les uploads deja confies sont ecrits jusqu'au bout
 
+    if (AllocStats::enabled()) {
+        Logger::instance().log(INFO, to_string(AllocStats::requests()) + " requests served, "
+            + to_string(AllocStats::averagePerRequest()) + " allocations per request on average");
+    }
+    FsStats::report();
     return 0;
 }
@@ -4,8 +4,8 @@ namespace serverSignal {
     int pipe_fd[2]; // Définition de la variable
 
     void signal_handler(int signum) {
-		(void)signum;
-        char byte = 1;
+        // Le numero du signal est transmis a la boucle principale (SIGINT : arret, SIGHUP : reload)
+        char byte = static_cast<char>(signum);
         write(pipe_fd[1], &byte, sizeof(byte));
     }
 }